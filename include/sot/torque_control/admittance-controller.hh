@@ -39,7 +39,9 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
 #include <sot/torque_control/common.hh>
+#include <sot/torque_control/utils/kinematics-cache.hh>
 #include <map>
 #include "boost/assign.hpp"
 
@@ -67,6 +69,8 @@ namespace dynamicgraph {
 
         void init(const double& dt, const std::string& robotRef);
 
+        void setDeadline(const double& deadline);
+
         /* --- SIGNALS --- */
         DECLARE_SIGNAL_IN(encoders,          dynamicgraph::Vector);
         DECLARE_SIGNAL_IN(jointsVelocities,  dynamicgraph::Vector);
@@ -95,6 +99,8 @@ namespace dynamicgraph {
         DECLARE_SIGNAL_OUT(dqDes,             dynamicgraph::Vector);  /// dqDes = J^+ * Kf * (fRef-f)
         DECLARE_SIGNAL_OUT(vDesRightFoot,     dynamicgraph::Vector);  ///
         DECLARE_SIGNAL_OUT(vDesLeftFoot,      dynamicgraph::Vector);  ///
+        DECLARE_SIGNAL_OUT(latency,           dynamicgraph::Vector);  /// p50, p99, max time [s] of dqDes over the last ticks
+        DECLARE_SIGNAL_OUT(deadline_misses,   dynamicgraph::Vector);  /// number of times dqDes exceeded the deadline
 //        DECLARE_SIGNAL_OUT(fRightHandError,   dynamicgraph::Vector);  /// fRef-f
 //        DECLARE_SIGNAL_OUT(fLeftHandError,    dynamicgraph::Vector);  /// fRef-f
 
@@ -115,6 +121,7 @@ namespace dynamicgraph {
         Eigen::VectorXd   m_u;                /// control (i.e. motor currents)
         bool              m_firstIter;
         bool              m_initSucceeded;    /// true if the entity has been successfully initialized
+        StopwatchId       m_profileDqDes;     /// profiled computation of dqDes
         bool              m_useJacobianTranspose; /// if true it uses the Jacobian transpose rather than the pseudoinverse
         double            m_dt;               /// control loop time period
         int               m_nj;
@@ -124,8 +131,10 @@ namespace dynamicgraph {
         int m_frame_id_lf;  /// frame id of left foot
 
         /// tsid
-        tsid::robots::RobotWrapper *        m_robot;
-        se3::Data*                          m_data;
+        const tsid::robots::RobotWrapper *  m_robot;          /// shared robot model, see getRobotModel
+        KinematicsCache *                   m_kinematics;       /// kinematics shared with the other entities using the same URDF
+        int                                 m_kinematicsClient; /// id of this entity in m_kinematics
+        const se3::Data*                    m_data;
 
         tsid::math::Vector6 m_f_RF;                /// desired 6d wrench right foot
         tsid::math::Vector6 m_f_LF;                /// desired 6d wrench left foot
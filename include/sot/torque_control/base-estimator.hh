@@ -40,6 +40,8 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+#include <sot/torque_control/utils/kinematics-cache.hh>
 #include <map>
 #include "boost/assign.hpp"
 //#include <boost/random/normal_distribution.hpp>
@@ -118,6 +120,7 @@ namespace dynamicgraph {
         void set_zmp_margin_left_foot(const double & margin);
         void set_normal_force_margin_right_foot(const double & margin);
         void set_normal_force_margin_left_foot(const double & margin);
+        void set_deadline(const dynamicgraph::Vector& deadlines);
 
         void reset_foot_positions_impl(const Vector6 & ftlf, const Vector6 & ftrf);
         void compute_zmp(const Vector6 & w, Vector2 & zmp);
@@ -164,6 +167,8 @@ namespace dynamicgraph {
         DECLARE_SIGNAL_OUT(w_rf,                       double);  /// weight of the estimation coming from the right foot
         DECLARE_SIGNAL_OUT(w_lf_filtered,              double);  /// filtered weight of the estimation coming from the left foot
         DECLARE_SIGNAL_OUT(w_rf_filtered,              double);  /// filtered weight of the estimation coming from the right foot
+        DECLARE_SIGNAL_OUT(latency,                    dynamicgraph::Vector);  /// p50, p99, max time [s] over the last ticks of: kinematics, position and velocity estimation
+        DECLARE_SIGNAL_OUT(deadline_misses,            dynamicgraph::Vector);  /// number of times the same sections exceeded the deadline
 
         /* --- COMMANDS --- */
         /* --- ENTITY INHERITANCE --- */
@@ -179,6 +184,7 @@ namespace dynamicgraph {
         
       protected:
         bool              m_initSucceeded;    /// true if the entity has been successfully initialized
+        std::vector<StopwatchId> m_profileSections; /// ids of the profiled sections of this entity: kinematics, position and velocity estimation
         bool              m_reset_foot_pos;   /// true after the command resetFootPositions is called
         double            m_dt;               /// sampling time step
         RobotUtil *       m_robot_util;
@@ -220,8 +226,10 @@ namespace dynamicgraph {
         double m_w_lf_filtered;               /// filtered weight of the estimation coming from the left foot
         double m_w_rf_filtered;               /// filtered weight of the estimation coming from the right foot
         
-        se3::Model        m_model;            /// Pinocchio robot model
-        se3::Data         *m_data;            /// Pinocchio robot data
+        KinematicsCache   *m_kinematics;      /// kinematics shared with the other entities using the same URDF
+        int               m_kinematicsClient; /// id of this entity in m_kinematics
+        const se3::Model  *m_model;           /// Pinocchio robot model
+        const se3::Data   *m_data;            /// Pinocchio robot data
         se3::SE3          m_oMff_lf;          /// world-to-base transformation obtained through left foot
         se3::SE3          m_oMff_rf;          /// world-to-base transformation obtained through right foot
         SE3               m_oMlfs;            /// transformation from world to left foot sole
@@ -45,6 +45,12 @@
 namespace dg = ::dynamicgraph;
 using namespace dg;
 
+namespace tsid {
+  namespace robots {
+    class RobotWrapper;
+  }
+}
+
 
 namespace dynamicgraph {
   namespace sot {
@@ -170,6 +176,15 @@ namespace dynamicgraph {
 	void display(std::ostream & os) const;
       };
 
+      /// Contiguous run of joints that have consecutive indices in both the
+      /// URDF and the SoT orders, so that it is converted with a single copy.
+      struct JointSegment
+      {
+        Index urdf;     /// index of the first joint in the URDF order
+        Index sot;      /// index of the first joint in the SoT order
+        Index length;   /// number of joints
+      };
+
       struct RobotUtil
       {
       public:
@@ -183,7 +198,18 @@ namespace dynamicgraph {
 	FootUtil m_foot_util;
 
 	/// Map from the urdf index to the SoT index.
+	/// Use set_urdf_to_sot to modify it, so that m_urdf_to_sot_segments is updated.
 	std::vector<Index> m_urdf_to_sot;
+
+	/// m_urdf_to_sot decomposed in contiguous runs, computed by set_urdf_to_sot.
+	std::vector<JointSegment> m_urdf_to_sot_segments;
+
+	/// True if the URDF and the SoT orders of the joints are the same.
+	bool m_urdf_to_sot_identity;
+
+	/// True if the conversions copy the segments, false if they gather the
+	/// joints one by one because the segments are too short on average.
+	bool m_urdf_to_sot_use_segments;
 	
 	/// Nb of Dofs for the robot.
         long unsigned int m_nbJoints;
@@ -205,6 +231,10 @@ namespace dynamicgraph {
 	/// (i.e. when set_name_to_id is called).
 	void create_id_to_name_map();
 
+	/// This method decomposes m_urdf_to_sot in contiguous runs of joints.
+	/// It is called by set_urdf_to_sot.
+	void create_urdf_to_sot_segments();
+
 	/// URDF file path
 	std::string m_urdf_filename;
 	
@@ -242,15 +272,31 @@ namespace dynamicgraph {
 
 	bool joints_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::RefVector q_urdf);
 
+	/// Convert three joint vectors (e.g. position, velocity and acceleration) at once
+	bool joints_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::ConstRefVector v_sot,
+	                        Eigen::ConstRefVector a_sot, Eigen::RefVector q_urdf,
+	                        Eigen::RefVector v_urdf, Eigen::RefVector a_urdf);
+
         bool velocity_urdf_to_sot(Eigen::ConstRefVector q_urdf,
                                   Eigen::ConstRefVector v_urdf, Eigen::RefVector v_sot);
       
         bool velocity_sot_to_urdf(Eigen::ConstRefVector q_urdf,
                                   Eigen::ConstRefVector v_sot, Eigen::RefVector v_urdf);
 
+        /// Same as velocity_urdf_to_sot for two velocities (e.g. velocity and acceleration),
+        /// computing the orientation of the base only once.
+        bool velocity_urdf_to_sot(Eigen::ConstRefVector q_urdf,
+                                  Eigen::ConstRefVector v_urdf, Eigen::ConstRefVector a_urdf,
+                                  Eigen::RefVector v_sot, Eigen::RefVector a_sot);
+
 	bool config_urdf_to_sot(Eigen::ConstRefVector q_urdf, Eigen::RefVector q_sot);
 	bool config_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::RefVector q_urdf);
 
+	/// Same as config_sot_to_urdf followed by velocity_sot_to_urdf,
+	/// computing the orientation of the base only once.
+	bool config_velocity_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::ConstRefVector v_sot,
+	                                 Eigen::RefVector q_urdf, Eigen::RefVector v_urdf);
+
 	bool base_urdf_to_sot(Eigen::ConstRefVector q_urdf, Eigen::RefVector q_sot);
 	bool base_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::RefVector q_urdf);
 
@@ -279,6 +325,24 @@ namespace dynamicgraph {
       bool isNameInRobotUtil(std::string &robotName);
       RobotUtil * createRobotUtil(std::string &robotName);
 
+      /// Root joint of the robot models built from URDF files
+      enum RootJointType
+      {
+        ROOT_JOINT_FIXED,
+        ROOT_JOINT_FREE_FLYER
+      };
+
+      /** Get the robot model described by a URDF file. The URDF file is parsed
+       *  on the first call only, and the model is then shared by all the entities
+       *  of the process, so it must not be modified: entities that need to
+       *  modify the model (e.g. the rotor inertias) must work on a copy.
+       *  Throws an exception if the URDF file cannot be parsed.
+       * @param urdfFileName Path of the URDF file.
+       * @param rootJoint Type of the root joint added to the model.
+       * @return The shared robot model. */
+      const tsid::robots::RobotWrapper & getRobotModel(const std::string &urdfFileName,
+                                                       RootJointType rootJoint);
+
       bool base_se3_to_sot(Eigen::ConstRefVector pos,
                            Eigen::ConstRefMatrix R,
                            Eigen::RefVector q_sot);
@@ -108,6 +108,7 @@ namespace dynamicgraph {
 
         DECLARE_SIGNAL_OUT(u,                                    dynamicgraph::Vector);
         DECLARE_SIGNAL_OUT(u_safe,                               dynamicgraph::Vector);  /// same as u when everything is fine, 0 otherwise
+        DECLARE_SIGNAL_OUT(logger_dropped_messages,              dynamicgraph::Vector);  /// number of messages dropped by the asynchronous logger
 
         /* --- COMMANDS --- */
 
@@ -142,6 +143,7 @@ namespace dynamicgraph {
 	void setJoints(const dynamicgraph::Vector &);
 
         void setStreamPrintPeriod(const double & s);
+        void setLoggerAsynchronous(const bool & async);
         void setSleepTime(const double &seconds);
         void addEmergencyStopSIN(const std::string& name);
 
@@ -167,11 +169,18 @@ namespace dynamicgraph {
         std::vector<CtrlMode>     m_jointCtrlModes_current;   /// control mode of the joints
         std::vector<CtrlMode>     m_jointCtrlModes_previous;  /// previous control mode of the joints
         std::vector<int>          m_jointCtrlModesCountDown;  /// counters used for the transition between two ctrl modes
+        int                       m_nbJointsInTransition;     /// number of joints whose counter is not zero
+        int                       m_nbJointsWithoutCtrlMode;  /// number of joints whose ctrl mode has not been set yet
+        /// Weight of each ctrl mode (column) in the control of each joint (row),
+        /// so that u is the sum of the columns times the inputs of the ctrl modes.
+        /// It changes only when a ctrl mode is set and during the transitions.
+        Eigen::MatrixXd           m_ctrlModeWeights;
 
         bool convertStringToCtrlMode(const std::string& name, CtrlMode& cm);
         bool convertJointNameToJointId(const std::string& name, unsigned int& id);
         bool isJointInRange(unsigned int id, double q);
         void updateJointCtrlModesOutputSignal();
+        void updateCtrlModeWeights(unsigned int jid);
 
       }; // class ControlManager
 
@@ -19,8 +19,12 @@
 #include <tsid/utils/stop-watch.hpp>
 #include <sot/torque_control/utils/causal-filter.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/latest-value-buffer.hh>
 #include <ddp-actuator-solver/ddpsolver.hh>
-#include <ddp-actuator-solver/ddpsolver.hh>
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 #include <ddp-actuator-solver/examples/dctemp.hh>
 #include <ddp-actuator-solver/examples/costtemp.hh>
@@ -33,7 +37,7 @@ namespace dynamicgraph {
       << m_pos_joint_measureSIN << m_dx_measureSIN		 \
       << m_tau_measureSIN << m_temp_measureSIN 
 
-#define ALL_OUTPUT_SIGNALS  m_tauSOUT
+#define ALL_OUTPUT_SIGNALS  m_tauSOUT << m_solve_timeSOUT << m_iterationsSOUT
       
         class SOTDDPACTUATORSOLVER_EXPORT DdpActuatorSolver
 	  :public :: dynamicgraph::Entity
@@ -48,15 +52,106 @@ namespace dynamicgraph {
 	  DECLARE_SIGNAL_IN(tau_measure,        dynamicgraph::Vector);
 	  DECLARE_SIGNAL_IN(temp_measure,        dynamicgraph::Vector);	  
 	  DECLARE_SIGNAL_OUT(tau,               dynamicgraph::Vector);
+	  DECLARE_SIGNAL_OUT(solve_time,        dynamicgraph::Vector);  /// duration of the last solution of each joint [s]
+	  DECLARE_SIGNAL_OUT(iterations,        dynamicgraph::Vector);  /// nb of iterations of the last solution of each joint
 
 	protected:
+	  typedef DDPSolver<double,5,1>::stateVec_t StateVector;
+
+	  /// Problem sent by the signal tau to the solver thread
+	  struct DdpProblem
+	  {
+	    StateVector xInit;  /// measured state
+	    StateVector xDes;   /// desired state
+	    int iter;           /// time step of the measure
+	  };
+
+	  /// Commands of the last solution, starting at time step iter
+	  struct DdpPlan
+	  {
+	    int iter;                 /// time step of the problem (-1 before the first solution)
+	    std::vector<double> u;    /// one command per time step of the horizon
+	    double solveTime;         /// duration of the solution [s]
+	    unsigned int iterations;  /// nb of iterations of the solver
+	  };
+
+	  /// Parameters of the DDP of a joint, given by add_joint or init
+	  struct JointParameters
+	  {
+	    int jointId;
+	    unsigned int T;
+	    unsigned int iterMax;
+	    double stopCrit;
+	  };
+
+	  /// Actuator model, cost and solver of one joint
+	  struct JointDdp
+	  {
+	    JointDdp(const JointParameters & p)
+	      : param(p), solver(model, cost, DISABLE_FULLDDP, DISABLE_QPBOX)
+	    {}
+
+	    JointParameters               param;
+	    DCTemp                        model;
+	    CostTemp                      cost;
+	    DDPSolver<double,5,1>         solver;
+	    DdpProblem                    problem;   /// problem of the synchronous mode
+	    DdpPlan                       plan;      /// solution of the synchronous mode
+	    LatestValueBuffer<DdpProblem> problems;  /// problems sent by tau to the solver thread
+	    LatestValueBuffer<DdpPlan>    plans;     /// solutions sent by the solver thread to tau
+
+	    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	  };
+
+	  /** Solve the DDP of joint from problem and store the commands of
+	   *  the solution in plan. */
+	  void solve(JointDdp & joint, const DdpProblem & problem, DdpPlan & plan);
+
+	  /** Solve the DDP of all the joints, dispatched over the worker pool.
+	   *  If async, only the joints with a new problem are solved and their
+	   *  solutions are published, otherwise the problem and the plan of the
+	   *  synchronous mode are used. */
+	  void solveAllJoints(const bool async);
+
+	  /** Take the next joint to solve until all of them have been solved. */
+	  void solveNextJoints();
+
+	  /** Loop of the threads of the pool: wait for the calls to
+	   *  solveAllJoints following the round given in argument. */
+	  void runWorker(unsigned int round);
+
+	  void startWorkers();
+	  void stopWorkers();
+
+	  /** Loop of the solver thread: solve the last problems sent by tau
+	   *  every m_solverPeriod seconds, and publish their solutions. */
+	  void runSolver();
+
+	  std::vector<JointParameters>  m_jointParameters;  /// joints added with add_joint
+	  std::vector<JointDdp*>        m_joints;           /// joints controlled since the last init
+	  int                           m_maxJointId;
+
+	  boost::thread_group           m_workers;
+	  int                           m_nbWorkers;
+	  boost::mutex                  m_poolMutex;
+	  boost::condition_variable     m_poolStart;        /// notified by solveAllJoints
+	  boost::condition_variable     m_poolDone;         /// notified by the last worker to finish
+	  unsigned int                  m_poolRound;        /// nb of calls to solveAllJoints
+	  int                           m_busyWorkers;      /// nb of workers of the current round
+	  bool                          m_poolAsync;        /// async argument of the current round
+	  bool                          m_stopWorkers;
+	  boost::atomic<int>            m_nextJoint;        /// index of the next joint to solve
+
+	  boost::atomic<bool>           m_async;         /// true if the DDP is solved by m_thread
+	  boost::atomic<bool>           m_stopSolver;    /// true to ask m_thread to stop
+	  boost::thread                 m_thread;
+	  double                        m_solverPeriod;  /// period of the solver thread [s]
+	  bool                          m_initSucceeded;
+	  dynamicgraph::Vector          m_solveTime;
+	  dynamicgraph::Vector          m_iterations;
+
 	  double m_dt;
 	  double m_ambiant_temperature;
-	  DDPSolver<double,5,1>::stateVec_t m_xinit,m_xDes,m_x;
-	  DDPSolver<double,5,1>::commandVec_t m_u;
-	  DCTemp m_model;
-	  CostTemp m_cost;
-	  DDPSolver<double,5,1>  m_solver;
 	  unsigned int m_T;
 	  double m_stopCrit;
 	  unsigned int m_iterMax;
@@ -65,9 +160,12 @@ namespace dynamicgraph {
 	    
 	    /** Constructor */
 	    DdpActuatorSolver(const std::string &name);
+	  ~DdpActuatorSolver();
 	  virtual void display(std::ostream &os) const;
 
-	  /** Initialize the DDP.
+	  /** Initialize the DDP of the joints added with add_joint, or of
+	   * joint 0 if none has been added. The DDPs of the joints are solved
+	   * in parallel on a pool of threads sized to the number of cores.
 	   * @param timestep Control period (in seconds).
 	   * @param T  Size of the preview window (in nb of timestep).
 	   * @param nbItMax Maximum number of iterations.
@@ -77,6 +175,35 @@ namespace dynamicgraph {
 			  const int &T,
 			  const int &nbItMax,
 			  const double &stopCriteria);
+
+	  /** Control the joint jointId with its own DDP, from the next call to init.
+	   * @param jointId Index of the joint in the input signals.
+	   * @param T  Size of the preview window (in nb of timestep).
+	   * @param nbItMax Maximum number of iterations.
+	   * @param stopCriteria The value of the stopping criteria.
+	   */
+	  void add_joint(const int &jointId,
+			 const int &T,
+			 const int &nbItMax,
+			 const double &stopCriteria);
+
+	  /** Solve the DDP in a background thread rather than in the signal tau.
+	   * The thread solves the problem of the last measured state every period
+	   * seconds (receding horizon). At each time step tau only reads the
+	   * command of the last solution corresponding to the current time step,
+	   * so that it keeps following that solution until the next one is
+	   * available. Until the first solution, tau is zero.
+	   * @param period Period of the solver thread (in seconds).
+	   */
+	  void start_async(const double &period);
+
+	  /** Stop the solver thread: tau solves the DDP again at each time step. */
+	  void stop_async();
+
+	  void sendMsg(const std::string& msg, MsgType t=MSG_TYPE_INFO, const char* file="", int line=0)
+	  {
+	    getLogger().sendMsg("[DdpActuatorSolver-"+name+"] "+msg, t, file, line);
+	  }
         };
     } // namespace torque_control
   } // namespace sot
@@ -88,12 +88,15 @@ namespace dynamicgraph
         virtual void setState(const dynamicgraph::Vector& st);
         virtual void setVelocity(const dynamicgraph::Vector & vel);
         virtual void setControlInputType(const std::string& cit);
+        void setForwardDynamicsSolver(const std::string& solver);
 
         virtual void init(const double& dt, const std::string& urdfFile);
 
       protected:
         virtual void integrate(const double & dt);
         void computeForwardDynamics();
+        void computeForwardDynamicsSvd(const Matrix& M, const Vector& h);
+        void computeForwardDynamicsCholesky(const Matrix& M, const Vector& h);
 
         void sendMsg(const std::string& msg, MsgType t=MSG_TYPE_INFO, const char* file="", int line=0)
         {
@@ -168,6 +171,18 @@ namespace dynamicgraph
         Vector                    m_tau_np6;
         int                       m_nj;         /// number of joints
 
+        /// Solvers of the constrained forward dynamics
+        enum ForwardDynamicsSolver
+        {
+          FD_SOLVER_SVD,        /// null-space projection based on the SVD of the constraint Jacobian
+          FD_SOLVER_CHOLESKY    /// Schur complement of the mass matrix, based on Cholesky decompositions
+        };
+        ForwardDynamicsSolver         m_fdSolver;
+        Eigen::LLT<Matrix, Eigen::Upper> m_M_chol;     /// Cholesky decomposition of the mass matrix
+        Matrix                        m_Minv_JcT;      /// M^{-1}*Jc^T
+        Matrix                        m_JMinvJcT;      /// inverse of the contact-space inertia: Jc*M^{-1}*Jc^T
+        Cholesky                      m_JMinvJcT_chol; /// Cholesky decomposition of m_JMinvJcT
+
         typedef boost::mt11213b                    ENG;    // uniform random number generator
         typedef boost::normal_distribution<double> DIST;   // Normal Distribution
         typedef boost::variate_generator<ENG,DIST> GEN;    // Variate generator
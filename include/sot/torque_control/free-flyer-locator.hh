@@ -41,6 +41,8 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+#include <sot/torque_control/utils/kinematics-cache.hh>
 #include <map>
 #include "boost/assign.hpp"
 
@@ -84,9 +86,14 @@ namespace dynamicgraph {
         DECLARE_SIGNAL_OUT(base6dFromFoot_encoders,   dynamicgraph::Vector);
 	/// n+6 robot velocities
         DECLARE_SIGNAL_OUT(v,                         dynamicgraph::Vector);  
+	/// p50, p99, max time [s] over the last ticks of: position and velocity computation
+        DECLARE_SIGNAL_OUT(latency,                   dynamicgraph::Vector);
+	/// number of times the same sections exceeded the deadline
+        DECLARE_SIGNAL_OUT(deadline_misses,           dynamicgraph::Vector);
 
         /* --- COMMANDS --- */
 	void displayRobotUtil();
+        void setDeadline(const dynamicgraph::Vector& deadlines);
 
         /* --- ENTITY INHERITANCE --- */
         virtual void display( std::ostream& os ) const;
@@ -102,8 +109,11 @@ namespace dynamicgraph {
       protected:
         
         bool              m_initSucceeded;    /// true if the entity has been successfully initialized
-        se3::Model        *m_model;            /// Pinocchio robot model
-        se3::Data         *m_data;            /// Pinocchio robot data 
+        std::vector<StopwatchId> m_profileSections; /// ids of the profiled sections of this entity: position and velocity computation
+        KinematicsCache   *m_kinematics;      /// kinematics shared with the other entities using the same URDF
+        int               m_kinematicsClient; /// id of this entity in m_kinematics
+        const se3::Model  *m_model;           /// Pinocchio robot model
+        const se3::Data   *m_data;            /// Pinocchio robot data
         se3::SE3          m_Mff;               /// SE3 Transform from center of feet to base
         se3::SE3          m_w_M_lf;
         se3::SE3          m_w_M_rf;
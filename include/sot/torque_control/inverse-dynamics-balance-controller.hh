@@ -39,8 +39,12 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+#include <sot/torque_control/utils/qp-warm-start.hh>
+#include <sot/torque_control/utils/hqp-solver-bank.hh>
 #include <sot/torque_control/common.hh>
 #include <map>
+#include <stdint.h>
 #include "boost/assign.hpp"
 
 /* Pinocchio */
@@ -80,8 +84,15 @@ namespace dynamicgraph {
         void updateComOffset();
         void removeRightFootContact(const double& transitionTime);
         void removeLeftFootContact(const double& transitionTime);
+        /// The contacts are added immediately: the transition time is
+        /// ignored, it is only kept for the compatibility of the interface.
         void addRightFootContact(const double& transitionTime);
         void addLeftFootContact(const double& transitionTime);
+        void setWarmStart(const bool& warmStart);
+        void setRealTimeMode(const bool& rtMode);
+        void setDeadline(const double& deadline);
+        void setSolverBudget(const double& maxTime, const int& maxIterations);
+        void setMaxExtrapolation(const int& nbTicks);
 
         /* --- SIGNALS --- */
         DECLARE_SIGNAL_IN(com_ref_pos,                dynamicgraph::Vector);
@@ -175,6 +186,10 @@ namespace dynamicgraph {
         DECLARE_SIGNAL_OUT(left_foot_acc,             dynamicgraph::Vector);
         DECLARE_SIGNAL_OUT(right_foot_acc_des,        dynamicgraph::Vector);
         DECLARE_SIGNAL_OUT(left_foot_acc_des,         dynamicgraph::Vector);
+        DECLARE_SIGNAL_OUT(latency,                   dynamicgraph::Vector);  /// p50, p99, max time [s] over the last ticks of: tau_des, read inputs, prepare inv-dyn, HQP
+        DECLARE_SIGNAL_OUT(deadline_misses,           dynamicgraph::Vector);  /// number of times the same sections exceeded their deadline (only tau_des has one)
+        DECLARE_SIGNAL_OUT(hqp_failures,              dynamicgraph::Vector);  /// number of failures of the HQP solver since the start
+        DECLARE_SIGNAL_OUT(fallback_level,            dynamicgraph::Vector);  /// how tau_des has been computed at the last tick (see FallbackLevel)
         
         /// This signal copies active_joints only if it changes from a all false or to an all false value
         DECLARE_SIGNAL_INNER(active_joints_checked, dynamicgraph::Vector);
@@ -196,8 +211,45 @@ namespace dynamicgraph {
         double            m_dt;               /// control loop time period
         double            m_t;
         bool              m_initSucceeded;    /// true if the entity has been successfully initialized
+        std::vector<StopwatchId> m_profileSections; /// ids of the profiled sections of this entity (see setDeadline)
         bool              m_enabled;          /// True if controler is enabled
         bool              m_firstTime;        /// True at the first iteration of the controller
+        bool              m_rtMode;           /// True if tau_des must not allocate memory nor print messages
+        unsigned int      m_hqpFailures;      /// number of failures of the HQP solver
+        int               m_hqpStatusLast;    /// status returned by the HQP solver at its last failure
+        unsigned int      m_timeErrors;       /// number of calls of tau_des with a non consecutive iteration
+
+        /// How tau_des is computed, from the best to the worst. The fallbacks
+        /// are used when the HQP fails or the solver budget is exceeded.
+        enum FallbackLevel
+        {
+          FALLBACK_NONE = 0,           // solution of the HQP
+          FALLBACK_EXTRAPOLATION = 1,  // linear extrapolation of the last two solutions of the HQP
+          FALLBACK_REDUCED_HQP = 2,    // solution of the HQP with only the contacts and the posture task
+          FALLBACK_GRAVITY = 3         // compensation of the gravity and velocity terms, balanced by the contact forces of min norm
+        };
+        FallbackLevel     m_fallbackLevel;         /// fallback used at the last tick
+        unsigned int      m_fallbacks[4];          /// number of ticks computed with each fallback level
+        int               m_fallbackTicks;         /// number of consecutive ticks computed with a fallback
+        int               m_maxExtrapolationTicks; /// max nb of consecutive ticks computed by extrapolation
+        double            m_maxSolveTime;          /// time budget of tau_des for the HQP solvers [s], 0 for no limit
+        int               m_maxSolverIterations;   /// max nb of iterations of the HQP solvers, 0 to keep their default
+        unsigned int      m_defaultSolverIterations; /// default max nb of iterations of the HQP solvers
+        double            m_iterationTime;         /// estimate of the time of an iteration of the HQP solvers [s]
+        int64_t           m_tickStartNs;           /// time of the start of the last tick [ns]
+        bool              m_hqpSolved;             /// true if m_tau_hqp holds a solution of the HQP
+
+        /** Return the max nb of iterations of the next HQP solution: those that
+         *  fit in the time left before m_maxSolveTime (estimated with
+         *  m_iterationTime), at most m_maxSolverIterations. 0 if none fit. */
+        unsigned int solverIterationBudget();
+
+        /** Update m_iterationTime with the measure of an HQP solution. */
+        void updateIterationTime(const int64_t solveStartNs, const int iterations);
+
+        /** Compute m_tau_sot (without the joint PD) with the best available fallback
+         *  and set m_fallbackLevel. */
+        void computeFallbackTorques();
 
         enum ContactState
         {
@@ -209,16 +261,56 @@ namespace dynamicgraph {
         };
         ContactState      m_contactState;
         double            m_contactTransitionTime;  /// end time of the current contact transition (if any)
+        double            m_contactTransitionDuration;  /// duration of the current contact transition (if any)
+
+        /// Contacts and feet tasks of the formulations built at init, one per
+        /// contact phase. A removal with a transition time keeps both contacts
+        /// until its end, with the task of the foot being removed.
+        enum ContactPhase
+        {
+          PHASE_DOUBLE_SUPPORT = 0,
+          PHASE_LEFT_SUPPORT = 1,   // contact of the left foot only
+          PHASE_RIGHT_SUPPORT = 2,  // contact of the right foot only
+          PHASE_LEFT_SUPPORT_TRANSITION = 3,   // both contacts, task of the right foot
+          PHASE_RIGHT_SUPPORT_TRANSITION = 4,  // both contacts, task of the left foot
+          NB_CONTACT_PHASES = 5
+        };
+        ContactPhase      m_contactPhase;           /// phase of m_invDyn
+
+        /** Remove the contact of the foot that is not in support (LEFT_SUPPORT
+         *  or RIGHT_SUPPORT), if in double support. Do not send any message
+         *  nor allocate memory, since it is called by tau_des.
+         *  @return True if the contact has been removed. */
+        bool removeContact(const ContactState support, const double transitionTime);
+
+        /** Add the contact of the foot that is not in support, if in the
+         *  single support specified (not during the transition towards it).
+         *  The contact is added immediately, there is no transition phase.
+         *  Same as removeContact for tau_des. */
+        bool addContact(const ContactState support);
+
+        /** Switch m_invDyn, m_invDynReduced and the warm start to those of phase.
+         *  Only pointers change, so it can be called by tau_des. */
+        void setContactPhase(const ContactPhase phase);
+
+        /** Update the weight of a task in the formulations of all the phases
+         *  (and in the reduced ones for the posture task). */
+        void updateTaskWeight(tsid::tasks::TaskMotion & task, const double weight);
 
         int m_frame_id_rf;  /// frame id of right foot
         int m_frame_id_lf;  /// frame id of left foot
 
         /// tsid
         tsid::robots::RobotWrapper *                       m_robot;
-        tsid::solvers::SolverHQPBase *           m_hqpSolver;
-        tsid::solvers::SolverHQPBase *           m_hqpSolver_60_36_34;
-        tsid::solvers::SolverHQPBase *           m_hqpSolver_48_30_17;
-        tsid::InverseDynamicsFormulationAccForce * m_invDyn;
+        HqpSolverBank                            m_hqpSolvers;      /// solvers of m_invDyn, selected by the size of the problem
+        tsid::solvers::SolverHQPBase *           m_hqpSolverLast;   /// solver used at the last tick
+        tsid::solvers::SolverHQPBase *           m_hqpSolverReduced[NB_CONTACT_PHASES];  /// solvers of the reduced formulations
+        bool                                       m_useWarmStart;  /// true if the HQP is warm started with the last active set
+        QpWarmStart                                m_qpWarmStart[NB_CONTACT_PHASES];
+        tsid::InverseDynamicsFormulationAccForce * m_invDyn;         /// formulation of the current contact phase
+        tsid::InverseDynamicsFormulationAccForce * m_invDynReduced;  /// same contacts and posture task as m_invDyn, without the other tasks
+        tsid::InverseDynamicsFormulationAccForce * m_invDynPhases[NB_CONTACT_PHASES];
+        tsid::InverseDynamicsFormulationAccForce * m_invDynReducedPhases[NB_CONTACT_PHASES];
         tsid::contacts::Contact6d *                m_contactRF;
         tsid::contacts::Contact6d *                m_contactLF;
         tsid::tasks::TaskComEquality *             m_taskCom;
@@ -234,10 +326,11 @@ namespace dynamicgraph {
 
         double m_w_com;
         double m_w_posture;
+        double m_w_feet;
 
         tsid::math::Vector  m_dv_sot;              /// desired accelerations (sot order)
         tsid::math::Vector  m_dv_urdf;             /// desired accelerations (urdf order)
-        tsid::math::Vector  m_f;                   /// desired force coefficients (24d)
+        tsid::math::Vector  m_f;                   /// desired force coefficients (24d): right foot, left foot
         tsid::math::Vector6 m_f_RF;                /// desired 6d wrench right foot
         tsid::math::Vector6 m_f_LF;                /// desired 6d wrench left foot
         tsid::math::Vector3 m_com_offset;          /// 3d CoM offset
@@ -250,8 +343,14 @@ namespace dynamicgraph {
         tsid::math::Vector3 m_zmp_RF;              /// 3d zmp left foot
         tsid::math::Vector3 m_zmp;                 /// 3d global zmp
         tsid::math::Vector  m_tau_sot;
+        tsid::math::Vector  m_tau_hqp;             /// joint torques of the last HQP solution (sot order, without PD)
+        tsid::math::Vector  m_tau_hqp_prev;        /// joint torques of the HQP solution of the tick before m_tau_hqp
+        tsid::math::Vector  m_tau_gravity_urdf;    /// joint torques of the fallback FALLBACK_GRAVITY (urdf order)
         tsid::math::Vector  m_q_urdf;
         tsid::math::Vector  m_v_urdf;
+        tsid::math::Vector  m_active_joints_urdf;  /// active joints (urdf order)
+        tsid::math::Vector  m_blocked_joints;      /// mask of the task of the blocked joints (urdf order), set at init
+        tsid::math::Vector  m_blocked_joints_enabled;  /// joints blocked when the controller was last enabled (urdf order)
 
         typedef se3::Data::Matrix6x Matrix6x;
         Matrix6x m_J_RF;
@@ -110,12 +110,16 @@ namespace dynamicgraph {
         DECLARE_SIGNAL_IN(motorParameterKa_n, dynamicgraph::Vector);
         DECLARE_SIGNAL_IN(polySignDq,         dynamicgraph::Vector);
 
+        /// packed coefficients of the motors (see MotorCoefficients), recomputed only when the parameters change
+        DECLARE_SIGNAL_INNER(motor_coefficients, dynamicgraph::Matrix);
+
         DECLARE_SIGNAL_OUT(u,                 dynamicgraph::Vector);  /// Desired current
         DECLARE_SIGNAL_OUT(smoothSignDq,      dynamicgraph::Vector); /// smooth approximation of sign(dq)
         DECLARE_SIGNAL_OUT(torque_error_integral, dynamicgraph::Vector); /// integral of the torque tracking error
 
       protected:
         MotorModel motorModel;
+        Eigen::VectorXd m_dq_motor; /// velocity given to the motor model (with velocity feedback)
         double m_dt; /// timestep of the controller
         Eigen::VectorXd m_tau_star;
         Eigen::VectorXd m_current_des;
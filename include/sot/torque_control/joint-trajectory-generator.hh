@@ -187,13 +187,7 @@ namespace dynamicgraph {
         std::vector<int>  m_iterForceSignals;
 
         std::vector<JTG_Status> m_status;     /// status of the joints
-        std::vector<AbstractTrajectoryGenerator*>    m_currentTrajGen;
-        std::vector<NoTrajectoryGenerator*>          m_noTrajGen;
-        std::vector<MinimumJerkTrajectoryGenerator*> m_minJerkTrajGen;
-        std::vector<SinusoidTrajectoryGenerator*>    m_sinTrajGen;
-        std::vector<LinearChirpTrajectoryGenerator*> m_linChirpTrajGen;
-        std::vector<TriangleTrajectoryGenerator*>    m_triangleTrajGen;
-        std::vector<ConstantAccelerationTrajectoryGenerator*>    m_constAccTrajGen;
+        BatchTrajectoryGenerator*                    m_jointTrajGen;   /// trajectories of all the joints
         TextFileTrajectoryGenerator*                 m_textFileTrajGen;
 
         std::vector<JTG_Status> m_status_force;     /// status of the forces
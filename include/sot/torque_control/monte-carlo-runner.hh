@@ -0,0 +1,167 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_monte_carlo_runner_H__
+#define __sot_torque_control_monte_carlo_runner_H__
+
+/* --------------------------------------------------------------------- */
+/* --- API ------------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#if defined (WIN32)
+#  if defined (__sot_torque_control_monte_carlo_runner_H__)
+#    define SOTMONTECARLORUNNER_EXPORT __declspec(dllexport)
+#  else
+#    define SOTMONTECARLORUNNER_EXPORT __declspec(dllimport)
+#  endif
+#else
+#  define SOTMONTECARLORUNNER_EXPORT
+#endif
+
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <vector>
+#include <boost/atomic.hpp>
+#include <sot/core/device.hh>
+#include <sot/torque_control/signal-helper.hh>
+#include <sot/torque_control/utils/vector-conversions.hh>
+#include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /* --------------------------------------------------------------------- */
+      /* --- CLASS ----------------------------------------------------------- */
+      /* --------------------------------------------------------------------- */
+
+
+      /**
+       * @brief Entity to run many independent simulations in parallel,
+       * e.g. to evaluate the robustness of a set of gains to perturbations.
+       *
+       * Each simulation is a graph built in Python around its own device
+       * (e.g. DeviceTorqueCtrl, estimator and controller, each graph with its own
+       * initial state, noise and gains). The graphs must not share any entity,
+       * and their entities must be initialized with different robot names, so
+       * that they do not share their RobotUtil and their KinematicsCache.
+       *
+       * The command run steps all the devices for the same number of time steps
+       * on a pool of threads. Every thread measures the simulation it runs with
+       * its own profiler, logger and statistics (see setThreadProfiler,
+       * setThreadLogger and setThreadStatistics). The check of the dynamic
+       * memory allocations of Eigen is shared by the whole process, so it is
+       * disabled during the run (see disableMallocGuard): the controllers in
+       * real-time mode then run as in non real-time mode.
+       * At each time step the metrics added with addMetric are updated, and at
+       * the end of the run they are available in the output signal metrics,
+       * with one row per simulation and one column per metric name.
+       */
+      class SOTMONTECARLORUNNER_EXPORT MonteCarloRunner
+        :public::dynamicgraph::Entity
+      {
+        typedef MonteCarloRunner EntityClassName;
+        DYNAMIC_GRAPH_ENTITY_DECL();
+
+      public:
+
+        /* --- CONSTRUCTOR ---- */
+        MonteCarloRunner( const std::string & name );
+        ~MonteCarloRunner();
+
+        /* --- SIGNALS --- */
+        typedef dynamicgraph::Signal<dynamicgraph::Vector, int> InputSignalType;
+
+        dynamicgraph::Signal<dynamicgraph::Matrix, int> m_metricsSOUT;          /// value of the metrics, one row per simulation
+        dynamicgraph::Signal<dynamicgraph::Vector, int> m_completed_stepsSOUT;  /// number of time steps simulated without error
+
+        /* --- COMMANDS --- */
+        void addSimulation(const std::string & deviceName);
+        void addMetric(const std::string & deviceName,
+                       const std::string & metricName,
+                       const std::string & signalName,
+                       const std::string & referenceSignalName,
+                       const std::string & reduction);
+        void setVerbosity(const int & verbosity);
+        void run(const double & dt, const int & nbTimeSteps, const int & nbThreads);
+        void clear();
+
+        /* --- ENTITY INHERITANCE --- */
+        virtual void display( std::ostream& os ) const;
+
+        void sendMsg(const std::string& msg, MsgType t=MSG_TYPE_INFO, const char* file="", int line=0)
+        {
+          getLogger().sendMsg("["+name+"] "+msg, t, file, line);
+        }
+
+      protected:
+        /// How the values of a metric at every time step are reduced to one number
+        enum Reduction
+        {
+          REDUCTION_MAX,      /// max over time of the largest element
+          REDUCTION_MIN,      /// min over time of the smallest element
+          REDUCTION_MAX_ABS,  /// max over time of the largest absolute value
+          REDUCTION_MAX_NORM, /// max over time of the norm
+          REDUCTION_RMS,      /// root mean square over time of the norm
+          REDUCTION_FINAL     /// sum of the elements at the last time step
+        };
+
+        struct Metric
+        {
+          int                   column;     /// index of the metric name
+          InputSignalType*      signal;
+          InputSignalType*      reference;  /// if not NULL, the metric is computed on signal-reference
+          Reduction             reduction;
+          double                value;
+          dynamicgraph::Vector  error;      /// preallocated signal-reference
+        };
+
+        struct Simulation
+        {
+          std::string                   deviceName;
+          dynamicgraph::sot::Device*    device;
+          std::vector<Metric>           metrics;
+          int                           completedSteps;
+          std::string                   error;  /// why the simulation stopped before the end
+        };
+
+        Simulation* findSimulation(const std::string & deviceName);
+
+        /** Loop of the threads of the pool: take the next simulation to run
+         *  until all of them have been run. */
+        void runWorker(const double dt, const int nbTimeSteps, const Stopwatch* profiler);
+
+        void runSimulation(Simulation & sim, const double dt, const int nbTimeSteps);
+
+        std::vector<Simulation*>  m_simulations;
+        std::vector<std::string>  m_metricNames;     /// names of the columns of the signal metrics
+        LoggerVerbosity           m_verbosity;       /// verbosity of the loggers of the simulations
+        boost::atomic<int>        m_nextSimulation;  /// index of the next simulation to run
+
+      }; // class MonteCarloRunner
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+
+
+#endif // #ifndef __sot_torque_control_monte_carlo_runner_H__
@@ -13,9 +13,29 @@
 #else
 #  define SOTFORCETORQUEESTIMATOR_EXPORT
 #endif
+
+#include <sot/torque_control/utils/vector-conversions.hh>
+
 namespace dynamicgraph {
   namespace sot {
     namespace torque_control {
+        /// Columns of the packed table of the coefficients of the motors (one row
+        /// per joint). Each coefficient K is stored as (K_p+K_n)/2 and (K_p-K_n)/2,
+        /// so that blending it with the sign s of the velocity is one multiply-add.
+        /// The degree of the polynomial of smoothSign is stored as three weights
+        /// equal to 0 or 1, so that all the joints are computed without branches.
+        /// The table is a Matrix so that it can be the value of a signal.
+        enum MotorCoefficient
+        {
+          MOTOR_KT_MEAN=0, MOTOR_KT_HALF_DIFF,
+          MOTOR_KV_MEAN,   MOTOR_KV_HALF_DIFF,
+          MOTOR_KA_MEAN,   MOTOR_KA_HALF_DIFF,
+          MOTOR_KF_MEAN,   MOTOR_KF_HALF_DIFF,
+          MOTOR_POLY_1,    MOTOR_POLY_2,    MOTOR_POLY_3,
+          MOTOR_NB_COEFFICIENTS
+        };
+        typedef Eigen::MatrixXd MotorCoefficients;
+
         class MotorModel {
         public:
             MotorModel();
@@ -31,6 +51,32 @@ namespace dynamicgraph {
                                double Kv_p=0.0, double Kv_n=0.0,
                                double Ka_p=0.0, double Ka_n=0.0, unsigned int poly=3);
             double smoothSign(double value, double threshold, unsigned int poly=3);
+
+            /** Fill the table K with the coefficients of all the joints. */
+            static void packCoefficients(Eigen::ConstRefVector Kt_p, Eigen::ConstRefVector Kt_n,
+                                         Eigen::ConstRefVector Kf_p, Eigen::ConstRefVector Kf_n,
+                                         Eigen::ConstRefVector Kv_p, Eigen::ConstRefVector Kv_n,
+                                         Eigen::ConstRefVector Ka_p, Eigen::ConstRefVector Ka_n,
+                                         Eigen::ConstRefVector poly, MotorCoefficients & K);
+
+            /** Fill only the polynomial weights of K, as needed by smoothSign. */
+            static void packPolynomials(Eigen::ConstRefVector poly, MotorCoefficients & K);
+
+            /** Currents of all the joints, computed in one pass.
+             *  The output must not alias any input. */
+            void getCurrent(Eigen::ConstRefVector torque, Eigen::ConstRefVector dq,
+                            Eigen::ConstRefVector ddq, const MotorCoefficients & K,
+                            Eigen::RefVector current);
+
+            /** Torques of all the joints, computed in one pass.
+             *  The output must not alias any input. */
+            void getTorque (Eigen::ConstRefVector current, Eigen::ConstRefVector dq,
+                            Eigen::ConstRefVector ddq, const MotorCoefficients & K,
+                            Eigen::RefVector torque);
+
+            /** Smooth sign of all the elements of value, with the polynomials of K. */
+            void smoothSign(Eigen::ConstRefVector value, double threshold,
+                            const MotorCoefficients & K, Eigen::RefVector sign);
         };
     } // namespace torque_control
   } // namespace sot
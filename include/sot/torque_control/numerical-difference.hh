@@ -84,13 +84,6 @@ namespace dynamicgraph {
         double m_dt;      /// sampling timestep of the input signal
         double m_delay;   /// delay introduced by the estimation
         int x_size;
-        /// std::vector to use with the filters
-        /// All the variables whose name contains 'filter' are outputs of the filters
-        std::vector<double> m_ddx_filter_std;  /// 2nd derivative
-        std::vector<double> m_dx_filter_std;   /// 1st derivative
-        std::vector<double> m_x_filter_std;    /// filtered output
-        std::vector<double> m_x_std;           /// x signal
-
 
         /// polynomial-fitting filters
         PolyEstimator* m_filter;
@@ -113,6 +106,13 @@ namespace dynamicgraph {
         void init(const double &timestep, const int& sigSize,
                   const double &delay, const int& polyOrder);
 
+        /** Enable or disable the sliding sums of the polynomial-fitting filter.
+         * With the sliding sums the cost of the filter is O(sigSize) per sample,
+         * independently of the window length.
+         * @param sliding true to enable the sliding sums.
+         */
+        void setSlidingSums(const bool& sliding);
+
       protected:
         void sendMsg(const std::string& msg, MsgType t=MSG_TYPE_INFO, const char* file="", int line=0)
         {
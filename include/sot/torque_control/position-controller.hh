@@ -39,6 +39,7 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
 #include <sot/torque_control/common.hh>
 #include <map>
 #include "boost/assign.hpp"
@@ -67,6 +68,8 @@ namespace dynamicgraph {
 
         void resetIntegral();
 
+        void setDeadline(const double& deadline);
+
         /* --- SIGNALS --- */
         DECLARE_SIGNAL_IN(base6d_encoders,  dynamicgraph::Vector);
         DECLARE_SIGNAL_IN(jointsVelocities, dynamicgraph::Vector);
@@ -79,6 +82,8 @@ namespace dynamicgraph {
         DECLARE_SIGNAL_OUT(pwmDes,      dynamicgraph::Vector);  /// Kp*e_q + Kd*de_q + Ki*int(e_q)
         // DEBUG SIGNALS
         DECLARE_SIGNAL_OUT(qError,      dynamicgraph::Vector);  /// qRef-q
+        DECLARE_SIGNAL_OUT(latency,         dynamicgraph::Vector);  /// p50, p99, max time [s] of pwmDes over the last ticks
+        DECLARE_SIGNAL_OUT(deadline_misses, dynamicgraph::Vector);  /// number of times pwmDes exceeded the deadline
 
 
         /* --- COMMANDS --- */
@@ -97,6 +102,7 @@ namespace dynamicgraph {
 	RobotUtil *       m_robot_util;        /// Robot Util
         Eigen::VectorXd   m_pwmDes;
         bool              m_initSucceeded;    /// true if the entity has been successfully initialized
+        StopwatchId       m_profilePwmDes;    /// profiled computation of pwmDes
         double            m_dt;               /// control loop time period
 
         /// Integral of the joint tracking errors
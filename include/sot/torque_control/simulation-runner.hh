@@ -0,0 +1,122 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_simulation_runner_H__
+#define __sot_torque_control_simulation_runner_H__
+
+/* --------------------------------------------------------------------- */
+/* --- API ------------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#if defined (WIN32)
+#  if defined (__sot_torque_control_simulation_runner_H__)
+#    define SOTSIMULATIONRUNNER_EXPORT __declspec(dllexport)
+#  else
+#    define SOTSIMULATIONRUNNER_EXPORT __declspec(dllimport)
+#  endif
+#else
+#  define SOTSIMULATIONRUNNER_EXPORT
+#endif
+
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <map>
+#include <sot/core/device.hh>
+#include <sot/torque_control/signal-helper.hh>
+#include <sot/torque_control/utils/vector-conversions.hh>
+#include <sot/torque_control/utils/logger.hh>
+
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /* --------------------------------------------------------------------- */
+      /* --- CLASS ----------------------------------------------------------- */
+      /* --------------------------------------------------------------------- */
+
+
+      /**
+       * @brief Entity to run a simulation without going back to Python
+       * at each time step.
+       *
+       * The command run calls the increment of a device (e.g. DeviceTorqueCtrl)
+       * for a given number of time steps, which computes all the entities
+       * of the graph plugged to the device, as the simulation loop written in
+       * Python would do. At each recording period the value of the signals added
+       * with addRecordedSignal is copied in a buffer allocated before the
+       * simulation starts. At the end of the simulation the recorded data are
+       * available in the output signals of this entity (one row per record),
+       * and they can be saved in the binary trace format read by TracePlayer.
+       */
+      class SOTSIMULATIONRUNNER_EXPORT SimulationRunner
+        :public::dynamicgraph::Entity
+      {
+        typedef SimulationRunner EntityClassName;
+        DYNAMIC_GRAPH_ENTITY_DECL();
+
+      public:
+
+        /* --- CONSTRUCTOR ---- */
+        SimulationRunner( const std::string & name );
+        ~SimulationRunner();
+
+        void init(const std::string & deviceName);
+
+        /* --- SIGNALS --- */
+        typedef dynamicgraph::Signal<dynamicgraph::Vector, int> InputSignalType;
+        typedef dynamicgraph::Signal<dynamicgraph::Matrix, int> OutputSignalType;
+
+        /* --- COMMANDS --- */
+        void addRecordedSignal(const std::string & signalName,
+                               const std::string & outputSignalName);
+        void run(const double & dt, const int & nbTimeSteps, const int & recordingPeriod);
+        void saveRecordedSignal(const std::string & outputSignalName,
+                                const std::string & fileName);
+        void clear();
+
+        /* --- ENTITY INHERITANCE --- */
+        virtual void display( std::ostream& os ) const;
+
+        void sendMsg(const std::string& msg, MsgType t=MSG_TYPE_INFO, const char* file="", int line=0)
+        {
+          getLogger().sendMsg("["+name+"] "+msg, t, file, line);
+        }
+
+      protected:
+        struct RecordedSignal
+        {
+          InputSignalType*      signal;   /// signal to record
+          OutputSignalType*     output;   /// output signal of the recorded data
+          dynamicgraph::Matrix  buffer;   /// recorded data, one column per record
+        };
+
+        bool                          m_initSucceeded;
+        dynamicgraph::sot::Device*    m_device;     /// device stepped by the simulation
+        std::map<std::string, RecordedSignal*> m_recorded;  /// recorded signals by output name
+
+      }; // class SimulationRunner
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+
+
+#endif // #ifndef __sot_torque_control_simulation_runner_H__
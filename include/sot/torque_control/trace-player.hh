@@ -40,6 +40,7 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/trace-file.hh>
 #include <map>
 #include "boost/assign.hpp"
 
@@ -61,6 +62,9 @@ namespace dynamicgraph {
        * the Tracer. Then you can either call the command
        * playNext, or you can call recompute on the output
        * signal "trigger".
+       * Long traces should be converted once to the binary trace format
+       * with the command convertTraceFile: binary traces are memory mapped
+       * rather than parsed, so they are loaded instantly.
        */
       class SOTTRACEPLAYER_EXPORT TracePlayer
         :public::dynamicgraph::Entity
@@ -72,6 +76,7 @@ namespace dynamicgraph {
 
         /* --- CONSTRUCTOR ---- */
         TracePlayer( const std::string & name );
+        ~TracePlayer();
 
         void init(const double& dt);
 
@@ -83,6 +88,8 @@ namespace dynamicgraph {
         /* --- COMMANDS --- */
         void addOutputSignal(const std::string & fileName,
                              const std::string & signalName);
+        void convertTraceFile(const std::string & textFileName,
+                              const std::string & binaryFileName);
         void playNext();
         void rewind();
         void clear();
@@ -100,11 +107,16 @@ namespace dynamicgraph {
 
       protected:
         typedef dynamicgraph::Vector            DataType;
-        typedef std::list< DataType >           DataHistoryType;
-        typedef DataHistoryType::const_iterator DataPointerType;
 
-        std::map<std::string, DataHistoryType> m_data;
-        std::map<std::string, DataPointerType> m_dataPointers;
+        struct TraceData
+        {
+          TraceFile               file;     /// data of the trace
+          Eigen::VectorXd::Index  pointer;  /// index of the current record
+          DataType                value;    /// current record, preallocated
+          OutputSignalType*       signal;   /// output signal of the trace
+        };
+
+        std::map<std::string, TraceData*> m_data;
 
       }; // class TraceReader
 
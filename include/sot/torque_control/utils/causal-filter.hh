@@ -39,6 +39,9 @@ public:
                      const Eigen::VectorXd& filter_denominator);
   
 private:
+  /// Fill the coefficient tables from the filter numerator and denominator
+  void compute_coefficient_tables();
+
   double m_dt;      /// sampling timestep of the input signal
   int m_x_size;
   int m_filter_order_m;
@@ -51,4 +54,13 @@ private:
   int pt_denominator;
   Eigen::MatrixXd input_buffer;
   Eigen::MatrixXd output_buffer;
+
+  /// Column k contains the numerator coefficients ordered as the
+  /// columns of input_buffer when pt_numerator==k
+  Eigen::MatrixXd m_numerator_table;
+  /// Column k contains the denominator coefficients (except the first)
+  /// ordered as the columns of output_buffer when pt_denominator==k
+  Eigen::MatrixXd m_denominator_table;
+  Eigen::VectorXd m_input_term;   /// input_buffer * numerator
+  Eigen::VectorXd m_output_term;  /// output_buffer * denominator
 }; // class CausalFilter
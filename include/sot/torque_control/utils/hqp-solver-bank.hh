@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_hqp_solver_bank_H__
+#define __sot_torque_control_hqp_solver_bank_H__
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <string>
+#include <vector>
+
+#include <tsid/solvers/solver-HQP-base.hpp>
+#include <tsid/solvers/solver-HQP-factory.hxx>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** HQP solvers of fixed size, selected by the size of the problem, with
+       * a solver of dynamic size for the problems of any other size.
+       *
+       * The fixed-size solvers of tsid (eiquadprog-rt) do not allocate memory
+       * and are faster, but each one can only solve problems of its exact size.
+       * init creates one for each size listed at build time in the CMake
+       * variable HQP_FIXED_SIZES ("nVar,nEq,nIn" entries separated by ';', by
+       * default those of HRP-2 in double and single support). Other sizes can
+       * be added with addFixedSize. The balance controller displays the size
+       * of its problem and the solver it uses.
+       */
+      class HqpSolverBank
+      {
+      public:
+        HqpSolverBank();
+        ~HqpSolverBank();
+
+        /** Create the solver of dynamic size, initially resized to the given
+         *  size, and the fixed-size solvers of HQP_FIXED_SIZES. */
+        void init(const std::string & name, unsigned int nVar, unsigned int nEq, unsigned int nIn);
+
+        /** Add a fixed-size solver, if there is none of this size yet. */
+        template<int nVar, int nEq, int nIn>
+        void addFixedSize()
+        {
+          if(findSolver(nVar, nEq, nIn)!=NULL)
+            return;
+          tsid::solvers::SolverHQPBase * solver =
+              tsid::solvers::SolverHQPFactory::createNewSolver<nVar, nEq, nIn>(
+                tsid::solvers::SOLVER_HQP_EIQUADPROG_RT, sizeName("eiquadprog_rt", nVar, nEq, nIn));
+          Entry e = {nVar, nEq, nIn, solver, true};
+          m_solvers.push_back(e);
+        }
+
+        /** Make sure that a solver is dedicated to problems of this size, so
+         *  that solving them never resizes a solver: if there is no fixed-size
+         *  solver of this size, add a solver of dynamic size resized to it. */
+        void reserve(unsigned int nVar, unsigned int nEq, unsigned int nIn);
+
+        /** Solver dedicated to this size of problem if there is one,
+         *  otherwise the solver of dynamic size. */
+        tsid::solvers::SolverHQPBase * getSolver(unsigned int nVar, unsigned int nEq, unsigned int nIn) const
+        {
+          tsid::solvers::SolverHQPBase * solver = findSolver(nVar, nEq, nIn);
+          return solver!=NULL ? solver : m_dynamicSize;
+        }
+
+        bool isDynamicSize(const tsid::solvers::SolverHQPBase * solver) const
+        {
+          for(std::size_t i=0; i<m_solvers.size(); i++)
+            if(m_solvers[i].solver==solver)
+              return !m_solvers[i].fixedSize;
+          return true;
+        }
+
+        /** Set the maximum number of iterations of all the solvers. */
+        void setMaximumIterations(unsigned int maxIter);
+
+        /** Delete all the solvers. */
+        void clear();
+
+      protected:
+        struct Entry
+        {
+          unsigned int nVar;
+          unsigned int nEq;
+          unsigned int nIn;
+          tsid::solvers::SolverHQPBase * solver;
+          bool fixedSize;  /// false for a solver of dynamic size added by reserve
+        };
+
+        /** Linear search: there are only a few sizes. */
+        tsid::solvers::SolverHQPBase * findSolver(unsigned int nVar, unsigned int nEq, unsigned int nIn) const
+        {
+          for(std::size_t i=0; i<m_solvers.size(); i++)
+            if(m_solvers[i].nVar==nVar && m_solvers[i].nEq==nEq && m_solvers[i].nIn==nIn)
+              return m_solvers[i].solver;
+          return NULL;
+        }
+
+        static std::string sizeName(const std::string & prefix, unsigned int nVar, unsigned int nEq, unsigned int nIn);
+
+        std::string                     m_name;         /// name of the solvers of dynamic size
+        std::vector<Entry>              m_solvers;      /// solvers dedicated to one size
+        tsid::solvers::SolverHQPBase *  m_dynamicSize;  /// solver of the other sizes
+      };
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif // #ifndef __sot_torque_control_hqp_solver_bank_H__
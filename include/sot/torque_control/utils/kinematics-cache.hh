@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_kinematics_cache_H__
+#define __sot_torque_control_kinematics_cache_H__
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+
+#include <pinocchio/multibody/model.hpp>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** Kinematics of a robot shared by all the entities that control it.
+       *
+       * Several entities (BaseEstimator, FreeFlyerLocator, AdmittanceController)
+       * compute the forward kinematics of the same joint configuration at each
+       * control cycle. Each of them registers as a client of the cache of its
+       * URDF and asks, through compute(), for the quantities it needs at its
+       * configuration. The cache keeps a pinocchio Data for each configuration
+       * in use: if another client has already asked for the same configuration
+       * (identical to the last bit) its Data is returned and only the quantities
+       * not yet computed are computed. The Data returned to a client is never
+       * modified for another configuration until that client calls compute()
+       * again, so it can be read across several signals of the same cycle.
+       */
+      class KinematicsCache
+      {
+      public:
+        /// Quantities that can be computed, to be combined in a bit mask.
+        enum Quantity
+        {
+          POSITIONS   = 1,  /// placements of the joints (oMi)
+          VELOCITIES  = 2,  /// velocities of the joints (v), needs the joint velocities
+          FRAMES      = 4,  /// placements of the frames (oMf)
+          JACOBIANS   = 8,  /// Jacobians of the joints (J)
+          COM         = 16  /// center of mass (com)
+        };
+
+        explicit KinematicsCache(const se3::Model& model);
+        ~KinematicsCache();
+
+        const se3::Model& model() const { return m_model; }
+
+        /** Register a new client of the cache.
+         * @return The id of the client, to pass to compute(). */
+        int addClient();
+        void removeClient(int client);
+
+        /** Compute the quantities for configuration q and velocity v, or retrieve
+         *  them if they have already been computed for another client.
+         * @param client Id of the client returned by addClient.
+         * @param q Configuration (pinocchio convention).
+         * @param v Velocity (pinocchio convention), only used if quantities contains VELOCITIES.
+         * @param quantities Bit mask of the Quantity to compute.
+         * @return The pinocchio data, which stays valid until the next call of this client.
+         */
+        const se3::Data& compute(int client,
+                                 const Eigen::VectorXd& q,
+                                 const Eigen::VectorXd& v,
+                                 int quantities);
+
+      protected:
+        struct Entry
+        {
+          se3::Data*        data;
+          Eigen::VectorXd   q;
+          Eigen::VectorXd   v;
+          int               computed;     /// bit mask of the Quantity already computed
+          int               nbClients;    /// number of clients currently reading data
+        };
+
+        Entry* findEntry(const Eigen::VectorXd& q, const Eigen::VectorXd& v, bool needVelocities);
+        Entry* getWritableEntry(int client);
+
+        const se3::Model&     m_model;          /// shared model, see getRobotModel
+        std::vector<Entry*>   m_entries;
+        std::vector<Entry*>   m_clientEntries;  /// entry currently used by each client
+
+      private:
+        KinematicsCache(const KinematicsCache&);
+        KinematicsCache& operator=(const KinematicsCache&);
+      };
+
+      /** Get the kinematics cache of a robot (as named in getRobotUtil),
+       *  described by a URDF file with a free-flyer root joint, whose model is
+       *  given by getRobotModel. The robots of independent graphs (e.g. the
+       *  simulations of MonteCarloRunner) must have different names, so that
+       *  they do not share a cache. Throws an exception if the URDF file
+       *  cannot be parsed. */
+      KinematicsCache * getKinematicsCache(const std::string &robotName,
+                                           const std::string &urdfFileName);
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif // #ifndef __sot_torque_control_kinematics_cache_H__
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_latest_value_buffer_H__
+#define __sot_torque_control_latest_value_buffer_H__
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <boost/atomic.hpp>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** Lock-free exchange of the latest value of T between one writer thread
+       * and one reader thread, e.g. a solver running in background and the
+       * real-time control loop.
+       *
+       * The writer fills back() and then calls publish(); the reader gets the
+       * last published value with front(). Neither of them ever waits nor
+       * allocates memory (the slots are copies of the value given to reset).
+       * Besides the front buffer of the reader and the back buffer of the
+       * writer there is a third slot, holding the last published value, so
+       * that the writer never writes into the slot being read.
+       */
+      template<typename T>
+      class LatestValueBuffer
+      {
+      public:
+        LatestValueBuffer()
+          : m_front(0), m_middle(1), m_back(2)
+        {}
+
+        /** Set all the slots to value. Not thread safe: call it before
+         *  starting the writer thread. */
+        void reset(const T & value)
+        {
+          for(int i=0; i<3; i++)
+            m_slots[i] = value;
+          m_front = 0;
+          m_middle = 1;
+          m_back = 2;
+        }
+
+        /** (Writer) Slot to fill before calling publish(). */
+        T & back()
+        {
+          return m_slots[m_back];
+        }
+
+        /** (Writer) Make the content of back() the latest value. */
+        void publish()
+        {
+          m_back = m_middle.exchange(m_back | NEW_VALUE, boost::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        /** (Reader) True if a value has been published since the last call to front(). */
+        bool hasNewValue() const
+        {
+          return (m_middle.load(boost::memory_order_acquire) & NEW_VALUE) != 0;
+        }
+
+        /** (Reader) Latest published value. */
+        const T & front()
+        {
+          if(hasNewValue())
+            m_front = m_middle.exchange(m_front, boost::memory_order_acq_rel) & INDEX_MASK;
+          return m_slots[m_front];
+        }
+
+      protected:
+        enum { INDEX_MASK = 3, NEW_VALUE = 4 };
+
+        T                           m_slots[3];
+        unsigned int                m_front;   /// slot read by the reader
+        boost::atomic<unsigned int> m_middle;  /// last published slot (with NEW_VALUE if not read yet)
+        unsigned int                m_back;    /// slot written by the writer
+      };
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif // #ifndef __sot_torque_control_latest_value_buffer_H__
@@ -32,6 +32,9 @@ public:
 
   virtual void estimate(std::vector<double>& estimee,
                         const std::vector<double>& el);
+
+  virtual void estimate(Eigen::Ref<Eigen::VectorXd> estimee,
+                        const Eigen::Ref<const Eigen::VectorXd>& el);
   
   virtual void estimateRecursive(std::vector<double>& estimee,
                                  const std::vector<double>& el, 
@@ -39,6 +42,9 @@ public:
 
   void getEstimateDerivative(std::vector<double>& estimeeDerivative,
                              const unsigned int order);
+
+  void getEstimateDerivative(Eigen::Ref<Eigen::VectorXd> estimeeDerivative,
+                             const unsigned int order);
   
 private:
 
@@ -53,13 +59,6 @@ private:
   std::vector<double> sum_xi_;
   std::vector<double> sum_tixi_;
 
-  // coefficients of the polynomial c2*x^2 + c1*x + c0
-  std::vector<double> c0_;
-  std::vector<double> c1_;
-
-  // Rows of the pseudo-inverse (when assuming constant sample time)
-  double* pinv0_;
-  double* pinv1_;
   // Half of the maximum time (according to the size of the window and dt)
   double tmed_;
   
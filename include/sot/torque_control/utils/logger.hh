@@ -41,6 +41,9 @@
 #include <map>
 #include <iomanip> // std::setprecision
 #include "boost/assign.hpp"
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/lockfree/queue.hpp>
 
 
 namespace dynamicgraph {
@@ -52,32 +55,59 @@ namespace dynamicgraph {
 
 #define SEND_MSG(msg,type)         sendMsg(msg,type,__FILE__,__LINE__)
 
+/** Streaming messages are throttled before being formatted, so that
+ * the string concatenations of the message are skipped when it is not printed. */
+#define SEND_STREAM_MSG(msg,type)  \
+  do { if(getLogger().isStreamMsgDue(type,__FILE__,__LINE__)) SEND_MSG(msg,type); } while(0)
+
+/** Real-time safe messages of an entity: format is a string literal with up to
+ * LOGGER_RECORD_MAX_ARGS printf conversions of double (e.g. "%.3f"). No string
+ * is built by the caller: in asynchronous mode the record is formatted by the
+ * printing thread. */
+#define SEND_RECORD(type,format)  \
+  getLogger().sendRecord(type,__FILE__,__LINE__,name.c_str(),format)
+#define SEND_RECORD1(type,format,a0)  \
+  getLogger().sendRecord(type,__FILE__,__LINE__,name.c_str(),format,1,a0)
+#define SEND_RECORD2(type,format,a0,a1)  \
+  getLogger().sendRecord(type,__FILE__,__LINE__,name.c_str(),format,2,a0,a1)
+#define SEND_RECORD3(type,format,a0,a1,a2)  \
+  getLogger().sendRecord(type,__FILE__,__LINE__,name.c_str(),format,3,a0,a1,a2)
+#define SEND_RECORD4(type,format,a0,a1,a2,a3)  \
+  getLogger().sendRecord(type,__FILE__,__LINE__,name.c_str(),format,4,a0,a1,a2,a3)
+
+#define LOGGER_MSG_MAX_LENGTH     256   /// longer messages are truncated in asynchronous mode
+#define LOGGER_RECORD_MAX_ARGS    4     /// max number of arguments of a record
+#define LOGGER_SOURCE_MAX_LENGTH  32    /// longer names of the sender of a record are truncated
+#define LOGGER_QUEUE_SIZE         1024  /// max number of messages waiting to be printed
+#define LOGGER_MAX_STREAM_MSGS    512   /// max number of streaming message call sites
+#define LOGGER_THREAD_PERIOD_MS   10    /// period of the printing thread
+
 #ifdef LOGGER_VERBOSITY_ERROR
   #define SEND_DEBUG_STREAM_MSG(msg)
   #define SEND_INFO_STREAM_MSG(msg)
   #define SEND_WARNING_STREAM_MSG(msg)
-  #define SEND_ERROR_STREAM_MSG(msg)    SEND_MSG(msg,MSG_TYPE_ERROR_STREAM)
+  #define SEND_ERROR_STREAM_MSG(msg)    SEND_STREAM_MSG(msg,MSG_TYPE_ERROR_STREAM)
 #endif
 
 #ifdef LOGGER_VERBOSITY_WARNING_ERROR
   #define SEND_DEBUG_STREAM_MSG(msg)
   #define SEND_INFO_STREAM_MSG(msg)\
-  #define SEND_WARNING_STREAM_MSG(msg)  SEND_MSG(msg,MSG_TYPE_WARNING_STREAM)
-  #define SEND_ERROR_STREAM_MSG(msg)    SEND_MSG(msg,MSG_TYPE_ERROR_STREAM)
+  #define SEND_WARNING_STREAM_MSG(msg)  SEND_STREAM_MSG(msg,MSG_TYPE_WARNING_STREAM)
+  #define SEND_ERROR_STREAM_MSG(msg)    SEND_STREAM_MSG(msg,MSG_TYPE_ERROR_STREAM)
 #endif
 
 #ifdef LOGGER_VERBOSITY_INFO_WARNING_ERROR
   #define SEND_DEBUG_STREAM_MSG(msg)
-  #define SEND_INFO_STREAM_MSG(msg)     SEND_MSG(msg,MSG_TYPE_INFO_STREAM)
-  #define SEND_WARNING_STREAM_MSG(msg)  SEND_MSG(msg,MSG_TYPE_WARNING_STREAM)
-  #define SEND_ERROR_STREAM_MSG(msg)    SEND_MSG(msg,MSG_TYPE_ERROR_STREAM)
+  #define SEND_INFO_STREAM_MSG(msg)     SEND_STREAM_MSG(msg,MSG_TYPE_INFO_STREAM)
+  #define SEND_WARNING_STREAM_MSG(msg)  SEND_STREAM_MSG(msg,MSG_TYPE_WARNING_STREAM)
+  #define SEND_ERROR_STREAM_MSG(msg)    SEND_STREAM_MSG(msg,MSG_TYPE_ERROR_STREAM)
 #endif
 
 #ifdef LOGGER_VERBOSITY_ALL
-  #define SEND_DEBUG_STREAM_MSG(msg) SEND_MSG(msg,MSG_TYPE_DEBUG_STREAM)
-  #define SEND_INFO_STREAM_MSG(msg)   SEND_MSG(msg,MSG_TYPE_INFO_STREAM)
-  #define SEND_WARNING_STREAM_MSG(msg)  SEND_MSG(msg,MSG_TYPE_WARNING_STREAM)
-  #define SEND_ERROR_STREAM_MSG(msg)    SEND_MSG(msg,MSG_TYPE_ERROR_STREAM)
+  #define SEND_DEBUG_STREAM_MSG(msg) SEND_STREAM_MSG(msg,MSG_TYPE_DEBUG_STREAM)
+  #define SEND_INFO_STREAM_MSG(msg)   SEND_STREAM_MSG(msg,MSG_TYPE_INFO_STREAM)
+  #define SEND_WARNING_STREAM_MSG(msg)  SEND_STREAM_MSG(msg,MSG_TYPE_WARNING_STREAM)
+  #define SEND_ERROR_STREAM_MSG(msg)    SEND_STREAM_MSG(msg,MSG_TYPE_ERROR_STREAM)
 #endif
 
       /** Enum representing the different kind of messages.
@@ -159,7 +189,27 @@ namespace dynamicgraph {
         VERBOSITY_NONE
       };
 
-      /** A simple class for logging messages
+      /** Message waiting to be printed by the asynchronous logger.
+       * It has a fixed size so that it can be stored in a preallocated queue.
+       * It is either a message formatted by the sender (sendMsg), or a format
+       * and its arguments (sendRecord), formatted by the printing thread.
+       */
+      struct LoggerRecord
+      {
+        MsgType     type;
+        const char* file;
+        int         line;
+        const char* format;   /// string literal, NULL if msg holds the message
+        int         nbArgs;
+        double      args[LOGGER_RECORD_MAX_ARGS];
+        char        source[LOGGER_SOURCE_MAX_LENGTH];  /// name of the sender of a record
+        char        msg[LOGGER_MSG_MAX_LENGTH];
+      };
+
+      /** A simple class for logging messages.
+       * In asynchronous mode sendMsg only copies the message in a lock-free
+       * queue, which is emptied by a background thread that does the printing.
+       * If the queue is full the message is dropped and counted.
       */
       class Logger
       {
@@ -169,7 +219,7 @@ namespace dynamicgraph {
         Logger(double timeSample=0.001, double streamPrintPeriod=1.0);
 
         /** Destructor */
-        ~Logger(){}
+        ~Logger();
 
         /** Method to be called at every control iteration
            * to decrement the internal Logger's counter. */
@@ -180,7 +230,21 @@ namespace dynamicgraph {
          * the point where sendMsg is called so that streaming messages are
          * printed only every streamPrintPeriod iterations.
          */
-        void sendMsg(std::string msg, MsgType type, const char* file="", int line=0);
+        void sendMsg(const std::string& msg, MsgType type, const char* file="", int line=0);
+
+        /** Same as sendMsg, for messages that are already a C string: in
+         * asynchronous mode the message is only copied in the queue, without
+         * allocating memory. */
+        void sendMsg(const char* msg, MsgType type, const char* file="", int line=0);
+
+        /** Same as sendMsg, without building any string: the message is
+         * "[source] " followed by format (a string literal, with nbArgs printf
+         * conversions of double) applied to the arguments. In asynchronous
+         * mode the formatting is done by the printing thread. Use it through
+         * the SEND_RECORD macros. */
+        void sendRecord(MsgType type, const char* file, int line,
+                        const char* source, const char* format, int nbArgs=0,
+                        double a0=0.0, double a1=0.0, double a2=0.0, double a3=0.0);
 
         /** Set the sampling time at which the method countdown()
            * is going to be called. */
@@ -192,14 +256,76 @@ namespace dynamicgraph {
         /** Set the verbosity level of the logger. */
         void setVerbosity(LoggerVerbosity lv);
 
+        /** Start (or stop) the thread printing the messages in background. */
+        void setAsynchronous(bool async);
+
+        /** Return true if a message of the specified type sent from the
+         * specified point is going to be printed. If it is a streaming message
+         * that is not due yet, its counter is decremented as sendMsg would do. */
+        bool isStreamMsgDue(MsgType type, const char* file, int line);
+
+        /** Number of messages dropped because the queue was full
+         * (published by the signal logger_dropped_messages of ControlManager). */
+        unsigned long getDroppedMessages() const { return m_droppedMsgs; }
+
       protected:
+        /** States of a slot of m_stream_msg_counters */
+        enum StreamMsgSlotState
+        {
+          SLOT_EMPTY   = 0,
+          SLOT_CLAIMED = 1,   /// the key of the slot is being written
+          SLOT_READY   = 2
+        };
+
+        /** Counter of a streaming message, identified by the point where it is sent.
+         * A slot is claimed by a CAS of its state, then its key is written and
+         * published: the key never changes after, and the countdown is updated
+         * by CAS, so that no thread ever waits for another one. */
+        struct StreamMsgCounter
+        {
+          boost::atomic<int>  state;      /// see StreamMsgSlotState
+          const char*         file;
+          int                 line;
+          boost::atomic<long> countdown;  /// number of messages to skip before printing again
+        };
+
         LoggerVerbosity m_lv;                /// verbosity of the logger
         double          m_timeSample;        /// specify the period of call of the countdown method
         double          m_streamPrintPeriod; /// specify the time period of the stream prints
         double          m_printCountdown;    /// every time this is < 0 (i.e. every _streamPrintPeriod sec) print stuff
+        boost::atomic<long> m_streamPrintTicks; /// number of messages skipped after each print of a streaming message
+
+        /** Lock-free hash table (open addressing) holding the counters of the
+         * streaming messages, which can be shared by several threads */
+        StreamMsgCounter m_stream_msg_counters[LOGGER_MAX_STREAM_MSGS];
+
+        boost::lockfree::queue<LoggerRecord,
+                               boost::lockfree::capacity<LOGGER_QUEUE_SIZE> > m_queue;
+        boost::atomic<bool>           m_async;        /// true if messages are printed by m_thread
+        boost::atomic<unsigned long>  m_droppedMsgs;  /// number of messages lost because the queue was full
+        unsigned long                 m_droppedMsgsPrinted;
+        boost::thread                 m_thread;
+
+        /** Return the counter of the specified streaming message, NULL if the
+         * table is full or if its slot is being claimed by another thread. */
+        StreamMsgCounter* getStreamMsgCounter(const char* file, int line);
+
+        /** Update m_streamPrintTicks from m_streamPrintPeriod and m_timeSample */
+        void updateStreamPrintTicks();
 
-        /** Pointer to the dynamic structure which holds the collection of streaming messages */
-        std::map<std::string, double> m_stream_msg_counters;
+        /** Return true if a message of the specified type sent from the specified
+         * point must be printed, updating the counter if it is a streaming message. */
+        bool isMsgDue(MsgType type, const char* file, int line);
+
+        /** Write the message of a record in buffer (of size LOGGER_MSG_MAX_LENGTH) */
+        static void formatRecord(const LoggerRecord & r, char* buffer);
+
+        bool isAllowedByVerbosity(MsgType type);
+
+        void print(const char* msg);
+
+        /** Loop of the printing thread */
+        void run();
 
         bool isStreamMsg(MsgType m)
         { return m==MSG_TYPE_ERROR_STREAM || m==MSG_TYPE_DEBUG_STREAM || m==MSG_TYPE_INFO_STREAM || m==MSG_TYPE_WARNING_STREAM; }
@@ -217,9 +343,14 @@ namespace dynamicgraph {
         { return m==MSG_TYPE_ERROR_STREAM || m==MSG_TYPE_ERROR; }
       };
 
-      /** Method to get the logger (singleton). */
+      /** Method to get the logger of the calling thread: the one set with
+       * setThreadLogger, or the logger shared by the whole process. */
       Logger& getLogger();
 
+      /** Make getLogger return the specified logger in the calling thread, or
+       * the logger of the process if it is NULL. The logger is not owned. */
+      void setThreadLogger(Logger* logger);
+
     }    // namespace torque_control
   }      // namespace sot
 }        // namespace dynamicgraph
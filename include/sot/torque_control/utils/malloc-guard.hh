@@ -0,0 +1,43 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_malloc_guard_H__
+#define __sot_torque_control_malloc_guard_H__
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** Return true if the entities in real-time mode may forbid the dynamic
+          memory allocations of Eigen (EIGEN_MALLOC_NOT_ALLOWED). The flag of
+          Eigen is shared by the whole process: while a thread forbids the
+          allocations, the ones of all the other threads fail too, and a
+          thread allowing them again stops checking the others. So the
+          runners stepping several graphs in parallel (e.g. MonteCarloRunner)
+          disable the guard while they run: meanwhile the real-time mode of
+          the entities does not check the allocations. */
+      bool isMallocGuardEnabled();
+
+      /** Disable the guard until the matching call to enableMallocGuard
+          (the calls can be nested by several runners). */
+      void disableMallocGuard();
+      void enableMallocGuard();
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif
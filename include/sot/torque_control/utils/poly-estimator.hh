@@ -67,6 +67,15 @@ public:
    */
   virtual void estimate(std::vector<double>& estimee,
                         const std::vector<double>& data_element) = 0;
+
+  /**
+   * Same as estimate(estimee, data_element), working directly on Eigen
+   * vectors to avoid copying the data to and from std::vector.
+   * @param [out] estimee is the calculated estimation.
+   * @param [in] data_element is the new data vector.
+   */
+  virtual void estimate(Eigen::Ref<Eigen::VectorXd> estimee,
+                        const Eigen::Ref<const Eigen::VectorXd>& data_element) = 0;
   
   /**
    * Estimate the polynomial given a new element using a recursive
@@ -87,7 +96,28 @@ public:
    */
   virtual void getEstimateDerivative(std::vector<double>& estimeeDerivative,
                                      const unsigned int order) = 0;
+
+  /**
+   * Same as getEstimateDerivative(estimeeDerivative, order) for Eigen vectors.
+   * @param [out] estimeeDerivative is the calculated time derivative.
+   * @param [in] order The order of the derivative.
+   */
+  virtual void getEstimateDerivative(Eigen::Ref<Eigen::VectorXd> estimeeDerivative,
+                                     const unsigned int order) = 0;
   
+  /**
+   * Enable or disable the sliding sums for the estimation with constant time
+   * difference. When enabled, the moments of the window data with respect to
+   * a time origin placed at the center of the window are updated in O(dim)
+   * for each new sample, rather than recomputing the weighted sums over the
+   * whole window. To avoid the accumulation of rounding errors, shadow
+   * moments are accumulated from the new samples only, and replace the
+   * moments once they cover the whole window (i.e. every N samples), so that
+   * no sample costs more than O(order^2 dim).
+   * @param [in] sliding true to enable the sliding sums.
+   */
+  void setSlidingSums(const bool& sliding);
+
   /**
    * Set the size of the filter window.
    * @param [in] N size
@@ -113,6 +143,49 @@ protected:
    */
   virtual double getEsteeme() = 0;
 
+  /**
+   * Pre-compute the matrices used for the estimation with constant time
+   * difference. To be called by the constructors of the derived classes.
+   * @param [in] Tmat is the N x (order+1) matrix of the time components.
+   * @param [in] dim is the dimension of the input elements.
+   */
+  void initWindow(const Eigen::MatrixXd& Tmat, const unsigned int& dim);
+
+  /**
+   * Add a new element to window_ (constant time difference).
+   * @param [in] data_element is the new data vector.
+   * @return false if there are not enough elements in the window yet.
+   */
+  bool feedWindow(const Eigen::Ref<const Eigen::VectorXd>& data_element);
+
+  /**
+   * Compute the coefficients c_ of the polynomial fitting window_.
+   */
+  void fitWindow();
+
+  /**
+   * Update the sliding sums removing the oldest element of window_ and adding
+   * data_element.
+   */
+  void updateSlidingSums(const Eigen::Ref<const Eigen::VectorXd>& data_element);
+
+  /**
+   * Shift the time origin of the moments sums by one sample.
+   */
+  void shiftSlidingSums(Eigen::MatrixXd& sums);
+
+  /**
+   * Add data_element, as the most recent sample of the window, to the
+   * moments sums.
+   */
+  void addToSlidingSums(Eigen::MatrixXd& sums,
+                        const Eigen::Ref<const Eigen::VectorXd>& data_element);
+
+  /**
+   * Recompute the sliding sums from the data in window_.
+   */
+  void anchorSlidingSums();
+
   /// Order of the polynomial estimator
   unsigned int order_;
 
@@ -132,6 +205,43 @@ protected:
   /// All the data (N elements of size dim)
   std::vector< std::vector<double> > elem_list_;
 
+  /// Window used when the sample time is constant (dim x N). Column k holds
+  /// the k-th sample of the circular buffer, so that the data of all the
+  /// channels of a sample are contiguous and the fit is a matrix product.
+  Eigen::MatrixXd window_;
+
+  /// Coefficients of the polynomial fitting window_: column k is the
+  /// coefficient of t^k/k! (t being zero for the oldest sample)
+  Eigen::MatrixXd c_;
+
+  /// Transposed pseudo-inverse of the time matrix: column k gives the
+  /// weights of the window samples (oldest first) in the k-th coefficient
+  Eigen::MatrixXd pinv_;
+
+  /// Use the sliding sums in fitWindow
+  bool sliding_sums_;
+
+  /// Indicate that sums_ corresponds to the data in window_
+  bool sums_valid_;
+
+  /// Moments of the window data (dim x order+1): column k is
+  /// \f$\sum_j u_j^k x_j\f$, where \f$u_j\f$ is the time of the j-th sample
+  /// (in sampling periods) relative to the center of the window
+  Eigen::MatrixXd sums_;
+
+  /// Moments of the samples added since the last swap with sums_ (same
+  /// layout as sums_), which replace sums_ when they cover the whole window
+  Eigen::MatrixXd shadow_sums_;
+
+  /// Number of samples in shadow_sums_
+  unsigned int shadow_count_;
+
+  /// Powers of the relative times (N x order+1): element (j,k) is \f$u_j^k\f$
+  Eigen::MatrixXd time_powers_;
+
+  /// Matrix mapping the moments to the coefficients: c_ = sums_ * sums_to_coeff_
+  Eigen::MatrixXd sums_to_coeff_;
+
   /// Time vector corresponding to each element in elem_list_
   std::vector< double > time_list_;
 
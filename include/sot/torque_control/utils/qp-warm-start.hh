@@ -0,0 +1,166 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_qp_warm_start_H__
+#define __sot_torque_control_qp_warm_start_H__
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+#include <tsid/math/constraint-base.hpp>
+#include <tsid/solvers/solver-HQP-base.hpp>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** Active-set warm start for the HQP solved by the balance controller.
+       *
+       * The eiquadprog solvers of tsid always start from the unconstrained
+       * minimum, even though the set of active inequalities rarely changes
+       * from one control cycle to the next. This class remembers the active
+       * set of the last optimal solution and, at the next cycle, solves the
+       * equality-constrained QP obtained by assuming that the same
+       * inequalities are active. If the KKT conditions hold (primal
+       * feasibility of the inactive inequalities and nonnegative multipliers
+       * of the active ones) the result is the optimum and the iterative
+       * solver can be skipped; otherwise the caller falls back to a cold solve
+       * and feeds its solution back through store().
+       *
+       * The active set is stored per constraint object (not per row index),
+       * so that it survives changes of the problem dimensions, e.g. when a
+       * contact is removed and the controller switches to another solver.
+       * Both problems follow the layout used by the eiquadprog solvers of
+       * tsid: every inequality/bound of dimension k is split into k lower
+       * rows followed by k upper rows.
+       *
+       * The Cholesky factorization of the Hessian is kept as long as the
+       * Hessian does not change, and the inequalities are read from the
+       * constraint objects, without building the whole inequality matrix.
+       */
+      class QpWarmStart
+      {
+      public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        typedef Eigen::MatrixXd Matrix;
+        typedef Eigen::VectorXd Vector;
+
+        QpWarmStart();
+
+        /** Preallocate the memory for a problem of the specified size. */
+        void resize(unsigned int n, unsigned int neq, unsigned int nin);
+
+        /** Forget the stored active set. */
+        void reset();
+
+        /** Try to solve the problem assuming the stored active set.
+         * @return True if the solution satisfies the KKT conditions,
+         * in which case it can be read with getOutput().
+         */
+        bool solve(const tsid::solvers::HQPData & problemData);
+
+        /** Store the active set of the specified (optimal) solution. */
+        void store(const tsid::solvers::HQPData & problemData,
+                   const tsid::solvers::HQPOutput & sol);
+
+        /** Solution found by the last successful call of solve().
+         * To avoid memory allocation its active set always has 2*nin
+         * entries, the unused ones being set to -1.
+         */
+        const tsid::solvers::HQPOutput & getOutput() const { return m_output; }
+
+        /** Tolerance used to check primal and dual feasibility. */
+        void setTolerance(double tol) { m_tol = tol; }
+
+        bool isSeeded() const { return m_seeded; }
+
+      protected:
+
+        /// Inequality (or bound) constraint of level 0 and its first row in CI
+        struct ConstraintBlock
+        {
+          const tsid::math::ConstraintBase * constr;
+          int index;
+          int rows;
+        };
+
+        /// Row of an inequality constraint that is active at the solution
+        struct ActiveRow
+        {
+          const tsid::math::ConstraintBase * constr;
+          int row;
+          bool upper;
+        };
+
+        /// Active row mapped on the current problem
+        struct ActiveIndex
+        {
+          int block;    /// index in m_layout
+          int row;
+          bool upper;
+        };
+
+        /// Fill m_layout with the inequality blocks of the specified problem
+        void computeLayout(const tsid::solvers::HQPData & problemData);
+
+        /// Build the cost and the equality constraints as done by the eiquadprog
+        /// solvers, writing the equalities in the first rows of m_C and m_c0
+        void computeMatrices(const tsid::solvers::HQPData & problemData);
+
+        /// Write the specified active row as row i of m_C and m_c0
+        void setActiveRow(const ActiveIndex & a, int i);
+
+        /// Check that x satisfies all the inequalities of m_layout
+        bool isPrimalFeasible(const Vector & x);
+
+        unsigned int m_n;     /// number of variables
+        unsigned int m_neq;   /// number of equality constraints
+        unsigned int m_nin;   /// number of (double-sided) inequality constraints
+        double m_tol;
+        bool m_seeded;        /// true if an active set has been stored
+
+        Matrix m_H;
+        Vector m_g;
+
+        Eigen::LLT<Matrix> m_H_chol;
+        Matrix m_H_factorized; /// Hessian factorized in m_H_chol
+        bool m_H_chol_valid;
+        Matrix m_C;           /// equalities followed by guessed active inequalities
+        Vector m_c0;
+        Matrix m_M;           /// L^{-1} C^T, with H = L L^T
+        Matrix m_S;           /// Schur complement C H^{-1} C^T
+        Vector m_w;           /// L^{-1} g
+        Vector m_lambda;
+        Vector m_slack;       /// A x for an inequality block
+
+        std::vector<ConstraintBlock> m_layout;
+        std::vector<ActiveRow>       m_activeSet;
+        std::vector<ActiveIndex>     m_activeIndex;
+
+        tsid::solvers::HQPOutput m_output;
+      };
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif // #ifndef __sot_torque_control_qp_warm_start_H__
@@ -33,6 +33,9 @@ public:
   
   virtual void estimate(std::vector<double>& estimee,
                         const std::vector<double>& el);
+
+  virtual void estimate(Eigen::Ref<Eigen::VectorXd> estimee,
+                        const Eigen::Ref<const Eigen::VectorXd>& el);
   
   virtual void estimateRecursive(std::vector<double>& estimee,
                                  const std::vector<double>& el, 
@@ -40,6 +43,9 @@ public:
 
   virtual void getEstimateDerivative(std::vector<double>& estimeeDerivative,
                                      const unsigned int order);
+
+  virtual void getEstimateDerivative(Eigen::Ref<Eigen::VectorXd> estimeeDerivative,
+                                     const unsigned int order);
   
 private:
 
@@ -57,15 +63,6 @@ private:
   std::vector<double> sum_tixi_;
   std::vector<double> sum_ti2xi_;
 
-  // coefficients of the polynomial c2*x^2 + c1*x + c0
-  std::vector<double> c0_;
-  std::vector<double> c1_;
-  std::vector<double> c2_;
-
-  // Rows of the pseudo-inverse (when assuming constant sample time) 
-  double* pinv0_;
-  double* pinv1_;
-  double* pinv2_;
   // Half of the maximum time (according to the size of the window and dt)
   double tmed_;
 
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_statistics_H__
+#define __sot_torque_control_statistics_H__
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <tsid/utils/statistics.hpp>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** Return the statistics of the calling thread: the ones set with
+          setThreadStatistics, or the statistics of tsid shared by the whole
+          process. The entities of this library store their statistics here
+          rather than in ::getStatistics. */
+      ::Statistics& getStatistics();
+
+      /** Make getStatistics return the specified statistics in the calling
+          thread, or the statistics of the process if it is NULL. The
+          statistics are not owned. The statistics of tsid are not thread-safe,
+          so threads running independent graphs (e.g. the simulations of
+          MonteCarloRunner) must each store in their own. */
+      void setThreadStatistics(::Statistics* statistics);
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif
@@ -29,12 +29,19 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define __sot_torque_control_stopwatch_H__
 
 #include "sot/torque_control/utils/Stdafx.hh"
+#include <deque>
+#include <vector>
+#include <stdint.h>
 
 #ifndef WIN32
 /* The classes below are exported */
 #pragma GCC visibility push(default)
 #endif
 
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
 // Generic stopwatch exception class
 struct StopwatchException
 {
@@ -47,13 +54,30 @@ public:
 enum StopwatchMode
 {
   NONE	    = 0,  // Clock is not initialized
-  CPU_TIME  = 1,  // Clock calculates time ranges using ctime and CLOCKS_PER_SEC
+  CPU_TIME  = 1,  // Clock calculates time ranges using the CPU time of the process
   REAL_TIME = 2   // Clock calculates time by asking the operating system how
-  // much real time passed
+  // much real time passed (monotonic clock)
 };
 
 #define STOP_WATCH_MAX_NAME_LENGTH 80
 
+/** Number of bins of the histogram of all the measurements. Bin k counts the
+    measurements in [2^k, 2^(k+1)) nanoseconds, the last one everything above. */
+#define STOP_WATCH_HISTOGRAM_SIZE 32
+
+/** Number of measurements kept in the sliding window of every performance,
+    whose percentiles are exact */
+#define STOP_WATCH_WINDOW_SIZE 1000
+
+/** Identifier of a performance record, returned by Stopwatch::get_id */
+typedef int StopwatchId;
+
+/** Define a static StopwatchId with the specified name, registered once when
+    the library is loaded, to be used in place of the name in start/stop. */
+#define STOP_WATCH_REGISTER(id, perf_name) \
+  static const ::dynamicgraph::sot::torque_control::StopwatchId id = \
+    ::dynamicgraph::sot::torque_control::getProfiler().get_id(perf_name)
+
 /**
     @brief A class representing a stopwatch.
     
@@ -106,6 +130,22 @@ enum StopwatchMode
     measured code portions are part of My astounding algorithm, but there's no
     connection between the three measurements.
 
+    Looking up a string at every call is too slow for code running in the
+    control loop. There the name should be resolved once into an integer ID,
+    which can then be passed to all the methods in place of the name:
+
+    @code
+    STOP_WATCH_REGISTER(PROFILE_MAIN_LOOP, "My astounding algorithm - Main loop");
+    ...
+    getProfiler().start(PROFILE_MAIN_LOOP);
+    // Loop
+    getProfiler().stop(PROFILE_MAIN_LOOP);
+    @endcode
+
+    Besides min/max/average, every record keeps a histogram of the measured
+    times (logarithmic bins), from which percentiles can be estimated with
+    get_percentile().
+
     If the code for a certain task is scattered through different files or
     portions of the same file one can use the start-pause-stop method:
 
@@ -157,20 +197,31 @@ public:
   /** Tells if a performance with a certain ID exists */
   bool performance_exists(std::string perf_name);
 
+  /** Return the ID of a performance, creating it if it does not exist */
+  StopwatchId get_id(const std::string & perf_name);
+
   /** Initialize stopwatch to use a certain time taking mode */
   void set_mode(StopwatchMode mode);
 
-  /** Start the stopwatch related to a certain piece of code */
+  /** Start the stopwatch related to a certain piece of code.
+      The methods taking the name of the performance look it up in a map at
+      every call: they are the slow path, kept for compatibility. Code running
+      in the control loop should use the ID returned by get_id (see
+      STOP_WATCH_REGISTER and benchmark_stop_watch). */
   void start(std::string perf_name);
+  void start(StopwatchId id);
 
   /** Stops the stopwatch related to a certain piece of code */
   void stop(std::string perf_name);
+  void stop(StopwatchId id);
 
   /** Stops the stopwatch related to a certain piece of code */
   void pause(std::string perf_name);
+  void pause(StopwatchId id);
 
   /** Reset a certain performance record */
   void reset(std::string perf_name);
+  void reset(StopwatchId id);
 
   /** Resets all the performance records */
   void reset_all();
@@ -178,28 +229,89 @@ public:
   /** Dump the data of a certain performance record */
   void report(std::string perf_name, int precision=2,
               std::ostream& output = std::cout);
+  void report(StopwatchId id, int precision=2,
+              std::ostream& output = std::cout);
 
   /** Dump the data of all the performance records */
   void report_all(int precision=2, std::ostream& output = std::cout);
 
   /** Returns total execution time of a certain performance */
   long double get_total_time(std::string perf_name);
+  long double get_total_time(StopwatchId id);
 
   /** Returns average execution time of a certain performance */
   long double get_average_time(std::string perf_name);
+  long double get_average_time(StopwatchId id);
 
   /** Returns minimum execution time of a certain performance */
   long double get_min_time(std::string perf_name);
+  long double get_min_time(StopwatchId id);
 
   /** Returns maximum execution time of a certain performance */
   long double get_max_time(std::string perf_name);
+  long double get_max_time(StopwatchId id);
 
   /** Return last measurement of a certain performance */
   long double get_last_time(std::string perf_name);
+  long double get_last_time(StopwatchId id);
+
+  /** Return an estimate of the specified percentile (in [0,100]) of the
+      execution time of a certain performance since its last reset,
+      interpolated from its log2 histogram: coarse, use
+      get_window_percentile to compare to a deadline */
+  long double get_percentile(std::string perf_name, double percentile);
+  long double get_percentile(StopwatchId id, double percentile);
+
+  /** Exact percentile (nearest rank) of the last STOP_WATCH_WINDOW_SIZE
+      measurements. It does not allocate memory. */
+  long double get_window_percentile(StopwatchId id, double percentile);
+
+  /** Return the maximum of the last STOP_WATCH_WINDOW_SIZE measurements */
+  long double get_window_max_time(StopwatchId id);
+
+  /** Set the maximum execution time (in seconds) of a certain performance.
+      Every measurement exceeding it is counted as a deadline miss.
+      A nonpositive deadline disables the check. */
+  void set_deadline(StopwatchId id, long double deadline);
+
+  /** Return the number of measurements that exceeded the deadline */
+  unsigned long get_deadline_misses(StopwatchId id);
+
+  /** Write p50, p99 and max time (in seconds) over the sliding window of
+      n performances in the 3*n vector s (meant for dynamic-graph signals) */
+  template<typename Vector>
+  void get_latencies(const StopwatchId* ids, int n, Vector& s)
+  {
+    if(s.size()!=3*n)
+      s.resize(3*n);
+    long double p50, p99;
+    for(int i=0; i<n; i++)
+    {
+      get_window_percentiles(ids[i], p50, p99);
+      s[3*i]   = (double) p50;
+      s[3*i+1] = (double) p99;
+      s[3*i+2] = (double) get_window_max_time(ids[i]);
+    }
+  }
+
+  /** Exact p50 and p99 of the last STOP_WATCH_WINDOW_SIZE measurements,
+      computed together (faster than two calls of get_window_percentile) */
+  void get_window_percentiles(StopwatchId id, long double & p50, long double & p99);
+
+  /** Write the number of deadline misses of n performances in the vector s */
+  template<typename Vector>
+  void get_deadline_misses(const StopwatchId* ids, int n, Vector& s)
+  {
+    if(s.size()!=n)
+      s.resize(n);
+    for(int i=0; i<n; i++)
+      s[i] = (double) get_deadline_misses(ids[i]);
+  }
 
   /** Return the time since the start of the last measurement of a given
       performance. */
   long double get_time_so_far(std::string perf_name);
+  long double get_time_so_far(StopwatchId id);
 
   /**	Turn off clock, all the Stopwatch::* methods return without doing
         anything after this method is called. */
@@ -208,12 +320,15 @@ public:
   /** Turn on clock, restore clock operativity after a turn_off(). */
   void turn_on();
 
-  /** Take time, depends on mode */
+  /** Take time in seconds, depends on mode */
   long double take_time();
 
+  /** Take time in nanoseconds, depends on mode */
+  int64_t take_time_ns();
+
 protected:
 
-  /** Struct to hold the performance data */
+  /** Struct to hold the performance data. Times are in nanoseconds. */
   struct PerformanceData {
 
     PerformanceData() :
@@ -223,45 +338,130 @@ protected:
       max_time(0),
       last_time(0),
       paused(false),
-      stops(0) {
+      stops(0),
+      window_index(0),
+      window_count(0),
+      window_max_time(0),
+      deadline(0),
+      deadline_misses(0) {
+      for(int i=0; i<STOP_WATCH_HISTOGRAM_SIZE; i++)
+        histogram[i] = 0;
     }
 
+    /** Name of the performance */
+    std::string name;
+
     /** Start time */
-    long double	clock_start;
+    int64_t	clock_start;
 
     /** Cumulative total time */
-    long double	total_time;
+    int64_t	total_time;
 
     /** Minimum time */
-    long double	min_time;
+    int64_t	min_time;
 
     /** Maximum time */
-    long double	max_time;
+    int64_t	max_time;
 
     /** Last time */
-    long double last_time;
+    int64_t last_time;
 
     /** Tells if this performance has been paused, only for internal use */
     bool paused;
 
     /** How many cycles have been this stopwatch executed? */
     int	stops;
+
+    /** Number of measurements falling in each bin */
+    unsigned int histogram[STOP_WATCH_HISTOGRAM_SIZE];
+
+    /** Last measurements (circular buffer) */
+    std::vector<int64_t> window;
+
+    /** Index where the next measurement is stored in the window */
+    int window_index;
+
+    /** Number of measurements in the window */
+    int window_count;
+
+    /** Maximum of the measurements in the window */
+    int64_t window_max_time;
+
+    /** Preallocated copy of the window, partially sorted to get its percentiles */
+    std::vector<int64_t> window_scratch;
+
+    /** Maximum execution time, 0 if none */
+    int64_t deadline;
+
+    /** How many measurements exceeded the deadline? */
+    unsigned long deadline_misses;
   };
 
+  /** Maximum time in the window of a performance, computed by scanning it
+      (only needed when the maximum leaves the window) */
+  int64_t window_max(const PerformanceData & perf_info);
+
+  /** Copy the window in window_scratch and return the element of rank k
+      (0-based), placing the smaller ones before it */
+  int64_t window_rank(PerformanceData & perf_info, int k, int end);
+
+  /** Rank (0-based) of a percentile in n measurements (nearest-rank method) */
+  static int percentile_rank(int n, double percentile);
+
+  /** Percentile estimated from a histogram of the measurements */
+  long double histogram_percentile(const unsigned int * histogram, long samples,
+                                   int64_t min_time, int64_t max_time,
+                                   double percentile);
+
+  /** Return the ID of an existing performance,
+      throwing an exception if it does not exist */
+  StopwatchId find_id(const std::string & perf_name);
+
+  /** Return the performance data with the specified name/ID,
+      throwing an exception if it does not exist */
+  PerformanceData& get_record(const std::string & perf_name);
+  PerformanceData& get_record(StopwatchId id);
+
   /** Flag to hold the clock's status */
   bool active;
 
   /** Time taking mode */
   StopwatchMode mode;
 
-  /** Pointer to the dynamic structure which holds the collection of performance
-      data */
-  std::map<std::string, PerformanceData >* records_of;
+  /** Performance data, indexed by ID. A deque is used so that adding
+      a record does not move the existing ones. */
+  std::deque<PerformanceData> records;
+
+  /** Map from the name of the performances to their IDs */
+  std::map<std::string, StopwatchId> ids_of;
 
 };
 
+/** Return the profiler of the calling thread: the one set with
+    setThreadProfiler, or the profiler shared by the whole process. */
 Stopwatch& getProfiler();
 
+/** Make getProfiler return the specified profiler in the calling thread, or
+    the profiler of the process if it is NULL. The profiler is not owned.
+    A copy of the process profiler has the IDs registered with
+    STOP_WATCH_REGISTER, so threads running independent graphs (e.g. the
+    simulations of MonteCarloRunner) can each measure their own times. */
+void setThreadProfiler(Stopwatch* profiler);
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+/* The stopwatch used to be declared in the global namespace: keep the old
+   names for the code that uses them unqualified. */
+using dynamicgraph::sot::torque_control::StopwatchException;
+using dynamicgraph::sot::torque_control::StopwatchMode;
+using dynamicgraph::sot::torque_control::NONE;
+using dynamicgraph::sot::torque_control::CPU_TIME;
+using dynamicgraph::sot::torque_control::REAL_TIME;
+using dynamicgraph::sot::torque_control::Stopwatch;
+using dynamicgraph::sot::torque_control::getProfiler;
+
 #ifndef WIN32
 #pragma GCC visibility pop
 #endif
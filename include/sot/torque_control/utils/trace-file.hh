@@ -0,0 +1,187 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __sot_torque_control_trace_file_H__
+#define __sot_torque_control_trace_file_H__
+
+/* --------------------------------------------------------------------- */
+/* --- INCLUDE --------------------------------------------------------- */
+/* --------------------------------------------------------------------- */
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <Eigen/Core>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+      /** Header of a binary trace file.
+       *
+       * A binary trace file contains the header followed by the data, stored
+       * as native doubles, one record (time step) after the other. Each record
+       * holds the nbCols values of the signal at one time step, so a record can
+       * be read in place from the memory-mapped file. The time column of the
+       * text traces of the Tracer is not stored.
+       */
+      struct TraceFileHeader
+      {
+        char     magic[8];     /// TRACE_FILE_MAGIC
+        uint32_t version;      /// TRACE_FILE_VERSION
+        uint32_t nbCols;       /// number of values of each record
+        uint64_t nbRows;       /// number of records
+        uint64_t dataOffset;   /// offset in bytes of the first record
+      };
+
+      #define TRACE_FILE_MAGIC   "SOTTRACE"
+      #define TRACE_FILE_VERSION 1
+
+      /** Data of a trace, read either from a binary trace file, which is
+       *  memory mapped, or from a text file written by the Tracer, which is
+       *  parsed into a single contiguous buffer. The first column of the
+       *  text files, which contains the time, is discarded. In both cases the records
+       *  are accessed through Eigen::Map views, without copies.
+       */
+      class TraceFile
+      {
+      public:
+        typedef Eigen::Map<const Eigen::VectorXd> ConstRow;
+
+        TraceFile();
+        ~TraceFile();
+
+        /** Open a trace file, detecting whether it is binary from its header.
+         * @param fileName Name of the file, path included.
+         * @param error Description of the error, if any.
+         * @return true if the file has been read successfully.
+         */
+        bool open(const std::string& fileName, std::string& error);
+
+        /** Release the data. */
+        void close();
+
+        Eigen::VectorXd::Index rows() const { return m_rows; }
+        Eigen::VectorXd::Index cols() const { return m_cols; }
+        bool isMapped() const { return m_map!=NULL; }
+
+        /** View of the i-th record. */
+        ConstRow row(Eigen::VectorXd::Index i) const
+        {
+          return ConstRow(m_data + i*m_cols, m_cols);
+        }
+
+      protected:
+        bool openBinary(const std::string& fileName, std::string& error);
+        bool openText(const std::string& fileName, std::string& error);
+
+        const double*           m_data;     /// first value of the first record
+        Eigen::VectorXd::Index  m_rows;     /// number of records
+        Eigen::VectorXd::Index  m_cols;     /// number of values of each record
+        void*                   m_map;      /// memory-mapped file (NULL for text files)
+        size_t                  m_mapSize;  /// size of the memory-mapped file
+        std::vector<double>     m_buffer;   /// data read from a text file
+
+      private:
+        TraceFile(const TraceFile&);
+        TraceFile& operator=(const TraceFile&);
+      };
+
+      /** Reader of a text file containing a matrix, one row per line, with
+       *  the values separated by spaces or tabs. Blank lines are skipped.
+       *  The file is memory mapped and parsed one row at a time, so reading
+       *  it needs no memory beyond the row being parsed, whatever its length.
+       */
+      class TextMatrixFileReader
+      {
+      public:
+        typedef Eigen::VectorXd::Index Index;
+
+        TextMatrixFileReader();
+        ~TextMatrixFileReader();
+
+        /** Open a text file, counting its rows and parsing the first one
+         *  to find the number of columns.
+         * @param fileName Name of the file, path included.
+         * @param error Description of the error, if any.
+         * @return true if the file has been opened successfully.
+         */
+        bool open(const std::string& fileName, std::string& error);
+
+        /** Release the file. */
+        void close();
+
+        /** Go back to the first row. */
+        void rewind();
+
+        /** Parse the next row. It does not allocate memory.
+         * @param row Vector of size cols() where to write the values.
+         * @return false if there are no more rows, or if the row does not
+         * contain cols() numbers.
+         */
+        bool readRow(Eigen::Ref<Eigen::VectorXd> row);
+
+        Index rows() const { return m_rows; }
+        Index cols() const { return m_cols; }
+        /** Index of the next row to read. */
+        Index currentRow() const { return m_currentRow; }
+
+      protected:
+        bool nextLine(const char*& lineBegin, const char*& lineEnd);
+
+        const char*   m_begin;        /// first character of the file
+        const char*   m_end;          /// end of the file
+        const char*   m_cursor;       /// beginning of the next line to parse
+        Index         m_rows;         /// number of rows (non-blank lines)
+        Index         m_cols;         /// number of values in each row
+        Index         m_currentRow;   /// index of the next row
+        void*         m_map;          /// memory-mapped file
+        size_t        m_mapSize;      /// size of the memory-mapped file
+        std::string   m_lastLine;     /// copy of the last line if it does not end with a newline,
+                                      /// so that strtod cannot read past the end of the mapping
+
+      private:
+        TextMatrixFileReader(const TextMatrixFileReader&);
+        TextMatrixFileReader& operator=(const TextMatrixFileReader&);
+      };
+
+      /** Convert a text file written by the Tracer into a binary trace file.
+       *  The text file is read row by row, so the conversion does not need
+       *  to hold the whole trace in memory.
+       * @param textFileName Name of the text file to read.
+       * @param binaryFileName Name of the binary file to write.
+       * @param error Description of the error, if any.
+       * @return true if the conversion succeeded.
+       */
+      bool convertTextTraceToBinary(const std::string& textFileName,
+                                    const std::string& binaryFileName,
+                                    std::string& error);
+
+      /** Write a binary trace file.
+       * @param fileName Name of the binary file to write.
+       * @param records Data of the trace, one column per record.
+       * @param error Description of the error, if any.
+       * @return true if the file has been written.
+       */
+      bool writeBinaryTrace(const std::string& fileName,
+                            const Eigen::Ref<const Eigen::MatrixXd>& records,
+                            std::string& error);
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif // #ifndef __sot_torque_control_trace_file_H__
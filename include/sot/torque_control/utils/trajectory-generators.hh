@@ -39,66 +39,27 @@
 #include <sot/torque_control/signal-helper.hh>
 #include <sot/torque_control/utils/vector-conversions.hh>
 #include <sot/torque_control/utils/logger.hh>
+#include <sot/torque_control/utils/trace-file.hh>
 #include <map>
-#include <fstream>  /// to read text file
+#include <algorithm>
+#include <iostream>
 #include "boost/assign.hpp"
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 
 namespace dynamicgraph {
   namespace sot {
     namespace torque_control {
 
-      #define MAXBUFSIZE  ((int) 1000000)
-
-      Eigen::MatrixXd readMatrixFromFile(const char *filename)
-      {
-        int cols = 0, rows = 0;
-        double buff[MAXBUFSIZE];
-
-        // Read numbers from file into buffer.
-        std::ifstream infile;
-        infile.open(filename);
-        while (! infile.eof())
-        {
-          std::string line;
-          getline(infile, line);
-//          std::cout<<"Read line "<<rows<<"\n";
-
-          int temp_cols = 0;
-          std::stringstream stream(line);
-          while(! stream.eof())
-            stream >> buff[cols*rows+temp_cols++];
-
-          if (temp_cols == 0)
-            continue;
-
-          if (cols == 0)
-            cols = temp_cols;
-          else if(temp_cols!=cols && !infile.eof())
-          {
-            std::cout<<"Error while reading matrix from file, line "<<rows<<" has "<<temp_cols<<" columnds, while preceding lines had "<<cols<<" columnds\n";
-            std::cout<<line<<"\n";
-            break;
-          }
-
-          rows++;
-          if((rows+1)*cols>=MAXBUFSIZE)
-          {
-            std::cout<<"Max buffer size exceeded ("<<rows<<" rows, "<<cols<<" cols)\n";
-            break;
-          }
-        }
-        infile.close();
-        rows--;
-
-        // Populate matrix with numbers.
-        Eigen::MatrixXd result(rows,cols);
-        for (int i = 0; i < rows; i++)
-          for (int j = 0; j < cols; j++)
-            result(i,j) = buff[ cols*i+j ];
-
-        return result;
-      }
+      /** Read a matrix from a text file, one row per line.
+       *  The file is parsed row by row, so the only memory used is the
+       *  returned matrix. In case of error an empty matrix is returned.
+       */
+      Eigen::MatrixXd readMatrixFromFile(const char *filename);
 
       class AbstractTrajectoryGenerator
       {
@@ -140,6 +101,8 @@ namespace dynamicgraph {
           resizeAllData(size);
         }
 
+        virtual ~AbstractTrajectoryGenerator() {}
+
         AbstractTrajectoryGenerator(double dt, double traj_time, const Eigen::VectorXd &x_init, const Eigen::VectorXd &x_final)
         {
           assert(x_init.size()==x_final.size() && "Initial and final state must have the same size");
@@ -229,53 +192,151 @@ namespace dynamicgraph {
 
 
       /** Trajectory generator that reads the trajectory and its derivatives from a text file.
+       *  The file is memory mapped and streamed: only a window of the next rows
+       *  is kept in memory, so the length of the trajectory does not affect
+       *  the memory used nor the time taken to load it. loadTextFile parses the
+       *  first rows, then a background thread parses the next ones into the
+       *  window ahead of compute_next_point, which only copies a parsed row.
+       *  If compute_next_point catches up with the thread (e.g. in a simulation
+       *  running faster than real time) it waits for the row.
        * */
       class TextFileTrajectoryGenerator: public AbstractTrajectoryGenerator
       {
       protected:
-        Eigen::MatrixXd m_posTraj;
-        Eigen::MatrixXd m_velTraj;
-        Eigen::MatrixXd m_accTraj;
+        typedef Eigen::VectorXd::Index Index;
+
+        TextMatrixFileReader        m_file;
+        Eigen::MatrixXd             m_window;       /// parsed rows (pos, vel, acc), one per column, used as a ring buffer
+        boost::atomic<Index>        m_nbRows;       /// number of rows of the trajectory
+        boost::atomic<Index>        m_nbRowsRead;   /// number of rows parsed into the window
+        boost::atomic<Index>        m_firstRowUsed; /// first row still used by compute_next_point:
+                                                    /// the columns of the rows before it can be refilled
+        boost::atomic<bool>         m_stopReader;
+        boost::thread               m_reader;       /// thread parsing the rows ahead of compute_next_point
+        boost::mutex                m_readerMutex;
+        boost::condition_variable   m_readerWake;   /// notified by compute_next_point when it waits for a row
+
+        /** Parse the next row of the file into its column of the window. */
+        bool readNextRow()
+        {
+          const Index i = m_nbRowsRead;
+          if(!m_file.readRow(m_window.col(i % m_window.cols())))
+          {
+            sendMsg("Error while reading line "+toString(i)+" of trajectory file: the trajectory is stopped there",
+                    MSG_TYPE_ERROR_STREAM);
+            m_nbRows = i;
+            return false;
+          }
+          m_nbRowsRead = i+1;
+          return true;
+        }
+
+        /** Loop of m_reader: parse the rows while their columns are free,
+         *  otherwise wait for about a quarter of the window. */
+        void runReader()
+        {
+          const boost::posix_time::time_duration wait =
+            boost::posix_time::microseconds((long)(0.25e6*m_dt*m_window.cols())+1);
+          while(!m_stopReader && m_nbRowsRead<m_nbRows)
+          {
+            if(m_nbRowsRead-m_firstRowUsed < m_window.cols())
+            {
+              if(!readNextRow())
+                return;
+              continue;
+            }
+            boost::mutex::scoped_lock lock(m_readerMutex);
+            m_readerWake.timed_wait(lock, wait);
+          }
+        }
+
+        void stopReader()
+        {
+          m_stopReader = true;
+          m_readerWake.notify_one();
+          if(m_reader.joinable())
+            m_reader.join();
+        }
 
       public:
-        TextFileTrajectoryGenerator(double dt, Eigen::VectorXd::Index size):
-          AbstractTrajectoryGenerator(dt, 1.0, size)
+        TextFileTrajectoryGenerator(double dt, Index size, Index windowSize=256):
+          AbstractTrajectoryGenerator(dt, 1.0, size),
+          m_window(3*size, windowSize), m_nbRows(0), m_nbRowsRead(0), m_firstRowUsed(0),
+          m_stopReader(false)
         {}
 
+        ~TextFileTrajectoryGenerator()
+        {
+          stopReader();
+        }
+
         virtual bool loadTextFile(const std::string& fileName)
         {
-          Eigen::MatrixXd data = readMatrixFromFile(fileName.c_str());
-//          std::cout<<"Read matrix with "<<data.rows()<<" rows and "<<data.cols()<<" cols from text file\n";
-          if(data.cols()!=3*m_size)
+          stopReader();
+          std::string error;
+          if(!m_file.open(fileName, error))
           {
-            std::cout<<"Unexpected number of columns (expected "<<3*m_size<<", found "<<data.cols()<<")\n";
+            std::cout<<error<<"\n";
+            return false;
+          }
+          if(m_file.cols()!=3*m_size)
+          {
+            std::cout<<"Unexpected number of columns (expected "<<3*m_size<<", found "<<m_file.cols()<<")\n";
+            m_file.close();
             return false;
           }
 
-          m_traj_time = m_dt*(double)data.rows();
+          m_nbRows = m_file.rows();
+          m_nbRowsRead = 0;
+          m_firstRowUsed = 0;
+          m_traj_time = m_dt*(double)m_nbRows;
           m_t = 0.0;
 
-          m_posTraj = data.leftCols(m_size);
-          m_velTraj = data.middleCols(m_size,m_size);
-          m_accTraj = data.rightCols(m_size);
-
-          m_x_init = m_posTraj.row(0);
+          const Index n = std::min((Index)m_nbRows, m_window.cols());
+          while(m_nbRowsRead<n)
+            if(!readNextRow())
+              return false;
+          if(m_nbRows==0)
+            return false;
+          m_x_init = m_window.col(0).head(m_size);
 
+          if(m_nbRowsRead<m_nbRows)
+          {
+            m_stopReader = false;
+            m_reader = boost::thread(boost::bind(&TextFileTrajectoryGenerator::runReader, this));
+          }
           return true;
         }
 
+        /** Index of the row of the current time. m_t is a sum of m_dt, so it
+         *  is rounded rather than truncated, which could repeat a row. */
+        Index currentRow() const
+        {
+          return (Index)std::floor(m_t/m_dt+0.5);
+        }
+
         virtual const Eigen::VectorXd& compute_next_point()
         {
-	  Eigen::VectorXd::Index i = (Eigen::VectorXd::Index)std::floor(m_t/m_dt);
-          if(i<m_posTraj.rows())
+	  const Index i = currentRow();
+          while(i>=m_nbRowsRead && i<m_nbRows)
+          {
+            m_readerWake.notify_one();
+            boost::this_thread::yield();
+          }
+          // the rows before m_firstRowUsed may have been overwritten
+          if(i<m_nbRows && i>=m_firstRowUsed)
           {
-            m_x   = m_posTraj.row(i);
-            m_dx  = m_velTraj.row(i);
-            m_ddx = m_accTraj.row(i);
+            Eigen::MatrixXd::ColXpr row = m_window.col(i % m_window.cols());
+            m_x   = row.head(m_size);
+            m_dx  = row.segment(m_size, m_size);
+            m_ddx = row.tail(m_size);
+            m_firstRowUsed = i;
           }
           m_t += m_dt;
           return m_x;
         }
+
+        virtual bool isTrajectoryEnded(){ return currentRow()>=m_nbRows; }
       };
 
 
@@ -557,6 +618,312 @@ namespace dynamicgraph {
         }
       };
 
+      /** Generator of independent scalar trajectories for several channels
+       *  (e.g. the joints of a robot), each one with its own profile, starting
+       *  time and duration. It generates the same trajectories as one size-1
+       *  generator per channel, but all the channels sharing the same profile
+       *  are evaluated in a single loop over contiguous arrays, without virtual
+       *  calls nor temporary vectors.
+       */
+      class BatchTrajectoryGenerator
+      {
+      public:
+        typedef Eigen::VectorXd::Index Index;
+
+        enum Profile
+        {
+          PROFILE_NONE,         /// keep the current position
+          PROFILE_MIN_JERK,     /// see MinimumJerkTrajectoryGenerator
+          PROFILE_SINUSOID,     /// see SinusoidTrajectoryGenerator
+          PROFILE_TRIANGLE,     /// see TriangleTrajectoryGenerator
+          PROFILE_CONST_ACC,    /// see ConstantAccelerationTrajectoryGenerator
+          PROFILE_LIN_CHIRP,    /// see LinearChirpTrajectoryGenerator
+          N_PROFILES
+        };
+
+      protected:
+        double          m_dt;         /// control dt (sampling period of the trajectories)
+        Index           m_size;       /// number of channels
+
+        std::vector<Profile>              m_profile;    /// profile of each channel
+        std::vector< std::vector<Index> > m_channels;   /// channels of each profile
+        std::vector<Index>                m_ended;      /// channels whose trajectory ended at the last step
+
+        Eigen::VectorXd m_x;          /// current positions
+        Eigen::VectorXd m_dx;         /// current velocities
+        Eigen::VectorXd m_ddx;        /// current accelerations
+        Eigen::VectorXd m_x_init;     /// initial positions
+        Eigen::VectorXd m_x_final;    /// final positions
+        Eigen::VectorXd m_traj_time;  /// trajectory times (sec)
+        Eigen::VectorXd m_t;          /// current times
+
+        Eigen::VectorXd m_Tacc;               /// acceleration times of the triangles
+        std::vector<int> m_counter;           /// counters of the constant accelerations
+        std::vector<int> m_counter_max;       /// values of the counters at which the acceleration switches
+        std::vector<int> m_is_accelerating;   /// signs of the constant accelerations
+        Eigen::VectorXd m_k;                  /// frequency derivatives of the chirps
+        Eigen::VectorXd m_f0;                 /// initial frequencies of the chirps
+        Eigen::VectorXd m_f1;                 /// final frequencies of the chirps
+        Eigen::VectorXd m_phi_0;              /// phase shifts for the second half of the chirps
+
+        void set_profile(Index i, Profile p)
+        {
+          std::vector<Index>& old_channels = m_channels[m_profile[i]];
+          old_channels.erase(std::find(old_channels.begin(), old_channels.end(), i));
+          m_channels[p].push_back(i);
+          m_profile[i] = p;
+        }
+
+        /** Start a trajectory from the current position of channel i. */
+        void start(Index i, Profile p, double x_final, double traj_time)
+        {
+          m_x_init(i)    = m_x(i);
+          m_dx(i)        = 0.0;
+          m_t(i)         = 0.0;
+          m_x_final(i)   = x_final;
+          m_traj_time(i) = traj_time;
+          set_profile(i, p);
+        }
+
+      public:
+
+        BatchTrajectoryGenerator(double dt, Index size):
+          m_dt(dt), m_size(size), m_profile(size, PROFILE_NONE), m_channels(N_PROFILES),
+          m_counter(size, 0), m_counter_max(size, 0), m_is_accelerating(size, 1)
+        {
+          m_x.setZero(size);
+          m_dx.setZero(size);
+          m_ddx.setZero(size);
+          m_x_init.setZero(size);
+          m_x_final.setZero(size);
+          m_traj_time.setOnes(size);
+          m_t.setZero(size);
+          m_Tacc.setOnes(size);
+          m_k.setZero(size);
+          m_f0.setZero(size);
+          m_f1.setZero(size);
+          m_phi_0.setZero(size);
+
+          // reserve the memory so that the lists never need to be reallocated
+          for(int p=0; p<N_PROFILES; p++)
+            m_channels[p].reserve(size);
+          m_ended.reserve(size);
+          for(Index i=0; i<size; i++)
+            m_channels[PROFILE_NONE].push_back(i);
+        }
+
+        /** Stop the trajectory of channel i, keeping it at position x. */
+        void stop(Index i, double x)
+        {
+          set_profile(i, PROFILE_NONE);
+          m_x_init(i) = x;
+          m_x(i)      = x;
+          m_dx(i)     = 0.0;
+          m_ddx(i)    = 0.0;
+          m_t(i)      = 0.0;
+        }
+
+        bool start_min_jerk(Index i, double x_final, double traj_time)
+        {
+          if(traj_time<=0.0)
+            return false;
+          start(i, PROFILE_MIN_JERK, x_final, traj_time);
+          return true;
+        }
+
+        bool start_sinusoid(Index i, double x_final, double traj_time)
+        {
+          if(traj_time<=0.0)
+            return false;
+          start(i, PROFILE_SINUSOID, x_final, traj_time);
+          return true;
+        }
+
+        bool start_triangle(Index i, double x_final, double traj_time, double Tacc)
+        {
+          if(traj_time<=0.0 || Tacc<0.0 || Tacc>0.5*traj_time)
+            return false;
+          m_Tacc(i) = Tacc;
+          start(i, PROFILE_TRIANGLE, x_final, traj_time);
+          return true;
+        }
+
+        bool start_const_acc(Index i, double x_final, double traj_time)
+        {
+          if(traj_time<=0.0)
+            return false;
+          m_counter_max[i] = int(traj_time/m_dt);
+          m_counter[i] = int(0.5*m_counter_max[i]);
+          m_is_accelerating[i] = 1;
+          start(i, PROFILE_CONST_ACC, x_final, traj_time);
+          return true;
+        }
+
+        bool start_linear_chirp(Index i, double x_final, double f0, double f1, double traj_time)
+        {
+          if(traj_time<=0.0)
+            return false;
+          m_f0(i) = f0;
+          m_f1(i) = f1;
+          m_k(i) = 2.0*(f1-f0)/traj_time;
+          m_phi_0(i) = M_PI*traj_time*(f0-f1);
+          start(i, PROFILE_LIN_CHIRP, x_final, traj_time);
+          return true;
+        }
+
+        /** Compute the next point of all the channels. The channels whose
+         *  trajectory ended are stopped and listed in get_ended(). */
+        void compute_next_point()
+        {
+          m_ended.clear();
+          const double dt = m_dt;
+
+          const std::vector<Index>& min_jerk = m_channels[PROFILE_MIN_JERK];
+          for(size_t j=0; j<min_jerk.size(); j++)
+          {
+            const Index i = min_jerk[j];
+            const double T = m_traj_time(i);
+            if(m_t(i) <= T)
+            {
+              double td  = m_t(i)/T;
+              double td2 = td*td;
+              double td3 = td2*td;
+              double td4 = td3*td;
+              double td5 = td4*td;
+              double p   = 10*td3 - 15*td4 + 6*td5;
+              double dp  = (30*td2 - 60*td3 + 30*td4)/T;
+              double ddp = (60*td - 180*td2 + 120*td3)/(T*T);
+              double delta = m_x_final(i)-m_x_init(i);
+              m_x(i)   = m_x_init(i) + delta*p;
+              m_dx(i)  = delta*dp;
+              m_ddx(i) = delta*ddp;
+            }
+            m_t(i) += dt;
+            if(m_t(i) >= T)
+              m_ended.push_back(i);
+          }
+
+          const std::vector<Index>& sinusoid = m_channels[PROFILE_SINUSOID];
+          for(size_t j=0; j<sinusoid.size(); j++)
+          {
+            const Index i = sinusoid[j];
+            double f = 1.0/(2.0*m_traj_time(i));
+            double two_pi_f   = 2*M_PI*f;
+            double two_pi_f_t = two_pi_f*m_t(i);
+            double p   = 0.5*(1.0-cos(two_pi_f_t));
+            double dp  = 0.5*two_pi_f*sin(two_pi_f_t);
+            double ddp = 0.5*two_pi_f*two_pi_f*cos(two_pi_f_t);
+            double delta = m_x_final(i)-m_x_init(i);
+            m_x(i)   = m_x_init(i) + delta*p;
+            m_dx(i)  = delta*dp;
+            m_ddx(i) = delta*ddp;
+            m_t(i) += dt;
+          }
+
+          const std::vector<Index>& triangle = m_channels[PROFILE_TRIANGLE];
+          for(size_t j=0; j<triangle.size(); j++)
+          {
+            const Index i = triangle[j];
+            const double T = m_traj_time(i);
+            const double Tacc = m_Tacc(i);
+            double max_vel = (m_x_final(i)-m_x_init(i))/(T-Tacc);
+            double t = m_t(i);
+            int way = 1;
+            if(t > T)
+            {
+              way = -1;
+              t = t-T;
+            }
+            if(t < Tacc)
+            {
+              m_ddx(i) = way*max_vel / Tacc;
+              m_dx(i)  = t/Tacc *way*max_vel;
+            }
+            else if(t > T-Tacc)
+            {
+              m_ddx(i) = -way*max_vel / Tacc;
+              m_dx(i)  = (T-t)/Tacc *way*max_vel;
+            }
+            else
+            {
+              m_ddx(i) = 0.0 * max_vel;
+              m_dx(i)  = way*max_vel;
+            }
+            m_x(i) += dt*m_dx(i);
+            m_t(i) += dt;
+            if(m_t(i) >= 2*T) m_t(i) = m_t(i)-2*T;
+          }
+
+          const std::vector<Index>& const_acc = m_channels[PROFILE_CONST_ACC];
+          for(size_t j=0; j<const_acc.size(); j++)
+          {
+            const Index i = const_acc[j];
+            const double T = m_traj_time(i);
+            double ddx0 = 4.0*(m_x_final(i)-m_x_init(i))/(T*T);
+            if(m_counter[i]==m_counter_max[i])
+            {
+              m_counter[i] = 0;
+              m_is_accelerating[i] = !m_is_accelerating[i];
+            }
+            m_counter[i] += 1;
+
+            m_ddx(i) = m_is_accelerating[i] ? ddx0 : -ddx0;
+            m_x(i)  += dt*m_dx(i) + 0.5*dt*dt*m_ddx(i);
+            m_dx(i) += dt*m_ddx(i);
+            m_t(i)  += dt;
+          }
+
+          const std::vector<Index>& lin_chirp = m_channels[PROFILE_LIN_CHIRP];
+          for(size_t j=0; j<lin_chirp.size(); j++)
+          {
+            const Index i = lin_chirp[j];
+            const double T = m_traj_time(i);
+            const double t = m_t(i);
+            double f, phi;
+            if(t < 0.5*T)
+            {
+              f = m_f0(i) + m_k(i)*t;
+              phi = 2*M_PI*t*(m_f0(i) + 0.5*m_k(i)*t);
+            }
+            else
+            {
+              f = m_f1(i) + m_k(i)*(0.5*T - t);
+              phi = m_phi_0(i) + 2*M_PI*t*(m_f1(i) + 0.5*m_k(i)*(T - t));
+            }
+            double p   = 0.5*(1.0-cos(phi));
+            double dp  = M_PI*f*sin(phi);
+            double ddp = 2.0*M_PI*M_PI*f*f*cos(phi);
+            double delta = m_x_final(i)-m_x_init(i);
+            m_x(i)   = m_x_init(i) + delta*p;
+            m_dx(i)  = delta*dp;
+            m_ddx(i) = delta*ddp;
+            m_t(i) += dt;
+            if(m_t(i) >= T)
+              m_ended.push_back(i);
+          }
+
+          for(size_t j=0; j<m_ended.size(); j++)
+            stop(m_ended[j], m_x(m_ended[j]));
+        }
+
+        const Eigen::VectorXd& getPos() const { return m_x; }
+        const Eigen::VectorXd& getVel() const { return m_dx; }
+        const Eigen::VectorXd& getAcc() const { return m_ddx; }
+        Profile get_profile(Index i) const { return m_profile[i]; }
+
+        /** Channels whose trajectory ended during the last call to compute_next_point. */
+        const std::vector<Index>& get_ended() const { return m_ended; }
+
+        /** Same semantic as AbstractTrajectoryGenerator::isTrajectoryEnded:
+         *  endless profiles and stopped channels never end. */
+        bool isTrajectoryEnded(Index i) const
+        {
+          if(m_profile[i]==PROFILE_MIN_JERK || m_profile[i]==PROFILE_LIN_CHIRP)
+            return m_t(i) >= m_traj_time(i);
+          return false;
+        }
+      };
+
 
 
     }    // namespace torque_control
@@ -15,6 +15,8 @@ from dynamic_graph.sot.torque_control.control_manager import ControlManager
 from dynamic_graph.sot.torque_control.current_controller import CurrentController
 from dynamic_graph.sot.torque_control.admittance_controller import AdmittanceController
 from dynamic_graph.sot.torque_control.position_controller import PositionController
+from dynamic_graph.sot.torque_control.simulation_runner import SimulationRunner
+from dynamic_graph.sot.torque_control.monte_carlo_runner import MonteCarloRunner
 from dynamic_graph.tracer_real_time import TracerRealTime
 from dynamic_graph.sot.torque_control.utils.sot_utils import Bunch
 from dynamic_graph.sot.torque_control.utils.filter_utils import create_butter_lp_filter_Wn_05_N_3
@@ -538,6 +540,37 @@ def addSignalsToTracer(tracer, device):
     addTrace(tracer,device,'currents');
 
 
+def create_simulation_runner(device, signals, name='sim_runner'):
+    """
+    Create an entity that steps the device in C++ and records the given signals.
+    signals is a list of tuples (entity, signalName); the recorded data are
+    available in the output signal entityName_signalName of the runner.
+    Usage: runner.run(dt, N, recordingPeriod); runner.entityName_signalName.value
+    """
+    runner = SimulationRunner(name);
+    runner.init(device.name);
+    for (entity, signalName) in signals:
+        runner.addRecordedSignal('{0}.{1}'.format(entity.name, signalName),
+                                 '{0}_{1}'.format(entity.name, signalName));
+    return runner;
+
+def create_monte_carlo_runner(simulations, name='monte_carlo_runner'):
+    """
+    Create an entity that runs independent simulations in parallel.
+    simulations is a list of tuples (device, metrics), where metrics is a list of
+    tuples (metricName, (entity, signalName), (refEntity, refSignalName) or None, reduction).
+    Every simulation must be built with its own entities and robot_name.
+    Usage: runner.run(dt, N, nbThreads); runner.metrics.value
+    """
+    runner = MonteCarloRunner(name);
+    for (device, metrics) in simulations:
+        runner.addSimulation(device.name);
+        for (metricName, (entity, signalName), ref, reduction) in metrics:
+            refName = '' if ref is None else '{0}.{1}'.format(ref[0].name, ref[1]);
+            runner.addMetric(device.name, metricName, '{0}.{1}'.format(entity.name, signalName),
+                             refName, reduction);
+    return runner;
+
 def create_tracer(device, traj_gen=None, estimator_kin=None,
                   inv_dyn=None, torque_ctrl=None):
     tracer = TracerRealTime('motor_id_trace');
@@ -19,7 +19,7 @@
 #include <dynamic-graph/factory.h>
 
 #include <sot/torque_control/commands-helper.hh>
-#include <tsid/utils/stop-watch.hpp>
+#include <sot/torque_control/utils/stop-watch.hh>
 
 namespace dynamicgraph
 {
@@ -36,7 +36,9 @@ namespace dynamicgraph
       using namespace tsid::math;
       using namespace tsid::tasks;
 
-#define PROFILE_DQ_DES_COMPUTATION "Admittance control computation"
+      /// Name of the profiled section published by the signals latency and
+      /// deadline_misses, prefixed with the name of the entity
+      static const char* PROFILE_SECTION_NAME = "dqDes computation";
 
 #define REF_FORCE_SIGNALS m_fRightFootRefSIN << m_fLeftFootRefSIN
 //                          m_fRightHandRefSIN << m_fLeftHandRefSIN
@@ -51,7 +53,7 @@ namespace dynamicgraph
                           FORCE_SIGNALS << GAIN_SIGNALS << m_controlledJointsSIN << m_dampingSIN
 
 #define DES_VEL_SIGNALS m_vDesRightFootSOUT << m_vDesLeftFootSOUT //<< m_fRightHandErrorSOUT << m_fLeftHandErrorSOUT
-#define OUTPUT_SIGNALS      m_uSOUT << m_dqDesSOUT << DES_VEL_SIGNALS
+#define OUTPUT_SIGNALS      m_uSOUT << m_dqDesSOUT << DES_VEL_SIGNALS << m_latencySOUT << m_deadline_missesSOUT
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -105,11 +107,14 @@ namespace dynamicgraph
 //                                                                m_fRightHandRefSIN)
 //            ,CONSTRUCT_SIGNAL_OUT(fLeftHandError,   dynamicgraph::Vector, m_fLeftHandSIN <<
 //                                                                m_fLeftHandRefSIN)
+            ,CONSTRUCT_SIGNAL_OUT(latency,        dynamicgraph::Vector, m_dqDesSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(deadline_misses,dynamicgraph::Vector, m_dqDesSOUT)
             ,m_initSucceeded(false)
             ,m_useJacobianTranspose(true)
             ,m_firstIter(true)
       {
         Entity::signalRegistration( INPUT_SIGNALS << OUTPUT_SIGNALS );
+        m_profileDqDes = getProfiler().get_id(name+": "+PROFILE_SECTION_NAME);
 
         m_v_RF_int.setZero();
         m_v_LF_int.setZero();
@@ -127,6 +132,15 @@ namespace dynamicgraph
                                     docCommandVoid2("Initialize the entity.",
                                                     "Time period in seconds (double)",
                                                     "Robot name (string)")));
+        addCommand("setDeadline",
+                   makeCommandVoid1(*this, &AdmittanceController::setDeadline,
+                                    docCommandVoid1("Set the maximum computation time of dqDes, used to count the deadline misses (the control period by default).",
+                                                    "Deadline in seconds (double)")));
+      }
+
+      void AdmittanceController::setDeadline(const double& deadline)
+      {
+        getProfiler().set_deadline(m_profileDqDes, deadline);
       }
 
       void AdmittanceController::init(const double& dt, const std::string& robotRef)
@@ -141,6 +155,7 @@ namespace dynamicgraph
           return SEND_MSG("Init failed: signal controlledJoints is not plugged", MSG_TYPE_ERROR);
 
         m_dt = dt;
+        setDeadline(dt);
         m_initSucceeded = true;
 
         /* Retrieve m_robot_util  informations */
@@ -152,11 +167,9 @@ namespace dynamicgraph
 
         try
         {
-          vector<string> package_dirs;
-          m_robot = new robots::RobotWrapper(m_robot_util->m_urdf_filename,
-                                             package_dirs,
-                                             se3::JointModelFreeFlyer());
-          m_data = new se3::Data(m_robot->model());
+          m_robot = &getRobotModel(m_robot_util->m_urdf_filename, ROOT_JOINT_FREE_FLYER);
+          m_kinematics = getKinematicsCache(localName, m_robot_util->m_urdf_filename);
+          m_kinematicsClient = m_kinematics->addClient();
 
           assert(m_robot->nv()>=6);
           m_robot_util->m_nbJoints = m_robot->nv()-6;
@@ -227,7 +240,7 @@ namespace dynamicgraph
           return s;
         }
 
-        getProfiler().start(PROFILE_DQ_DES_COMPUTATION);
+        getProfiler().start(m_profileDqDes);
         {
           const Eigen::Vector6d v_des_LF = m_vDesLeftFootSOUT(iter);
           const Eigen::Vector6d v_des_RF = m_vDesRightFootSOUT(iter);
@@ -241,7 +254,8 @@ namespace dynamicgraph
 
           /// *** Compute all Jacobians ***
           m_robot_util->joints_sot_to_urdf(q_sot, m_q_urdf.tail(m_nj));
-          m_robot->computeAllTerms(*m_data, m_q_urdf, m_v_urdf);
+          m_data = &m_kinematics->compute(m_kinematicsClient, m_q_urdf, m_v_urdf,
+                                          KinematicsCache::JACOBIANS | KinematicsCache::FRAMES);
           m_robot->frameJacobianLocal(*m_data, m_frame_id_rf, m_J_RF);
           m_robot->frameJacobianLocal(*m_data, m_frame_id_lf, m_J_LF);
 
@@ -271,7 +285,7 @@ namespace dynamicgraph
 
           m_robot_util->joints_urdf_to_sot(m_dq_des_urdf, s);
         }
-        getProfiler().stop(PROFILE_DQ_DES_COMPUTATION);
+        getProfiler().stop(m_profileDqDes);
 
         return s;
       }
@@ -414,6 +428,20 @@ namespace dynamicgraph
 //        return s;
 //      }
 
+      DEFINE_SIGNAL_OUT_FUNCTION(latency,dynamicgraph::Vector)
+      {
+        m_dqDesSOUT(iter);
+        getProfiler().get_latencies(&m_profileDqDes, 1, s);
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(deadline_misses,dynamicgraph::Vector)
+      {
+        m_dqDesSOUT(iter);
+        getProfiler().get_deadline_misses(&m_profileDqDes, 1, s);
+        return s;
+      }
+
       /* --- COMMANDS ---------------------------------------------------------- */
 
       /* ------------------------------------------------------------------- */
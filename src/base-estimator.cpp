@@ -96,9 +96,13 @@ namespace dynamicgraph
             rotatedPoint(2) = q_tmp2(3);
       }
 
-#define PROFILE_BASE_POSITION_ESTIMATION    "base-est position estimation"
-#define PROFILE_BASE_VELOCITY_ESTIMATION    "base-est velocity estimation"
-#define PROFILE_BASE_KINEMATICS_COMPUTATION "base-est kinematics computation"
+      /// Sections published by the signals latency and deadline_misses, profiled
+      /// as "<entity name>: <section name>" so that the instances do not mix.
+      /// They are computed by different signals, so each one has its own deadline.
+      enum ProfileSection { PROFILE_BASE_KINEMATICS_COMPUTATION, PROFILE_BASE_POSITION_ESTIMATION,
+                            PROFILE_BASE_VELOCITY_ESTIMATION, N_PROFILE_SECTIONS };
+      static const char* PROFILE_SECTION_NAMES[N_PROFILE_SECTIONS] = { "kinematics computation", "position estimation",
+                                                                       "velocity estimation" };
 
 
 #define INPUT_SIGNALS     m_joint_positionsSIN << m_joint_velocitiesSIN << \
@@ -106,7 +110,8 @@ namespace dynamicgraph
                           m_w_lf_inSIN << m_w_rf_inSIN << m_K_fb_feet_posesSIN << m_lf_ref_xyzquatSIN << m_rf_ref_xyzquatSIN << m_accelerometerSIN << m_gyroscopeSIN
 #define OUTPUT_SIGNALS    m_qSOUT << m_vSOUT << m_q_lfSOUT << m_q_rfSOUT << m_q_imuSOUT << \
                           m_w_lfSOUT << m_w_rfSOUT << m_w_lf_filteredSOUT << m_w_rf_filteredSOUT << m_lf_xyzquatSOUT << m_rf_xyzquatSOUT << \ 
-                          m_v_acSOUT << m_a_acSOUT << m_v_kinSOUT << m_v_imuSOUT << m_v_gyrSOUT << m_v_flexSOUT
+                          m_v_acSOUT << m_a_acSOUT << m_v_kinSOUT << m_v_imuSOUT << m_v_gyrSOUT << m_v_flexSOUT << \
+                          m_latencySOUT << m_deadline_missesSOUT
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -166,6 +171,8 @@ namespace dynamicgraph
         ,CONSTRUCT_SIGNAL_OUT(w_rf,                       double, m_forceRLEGSIN)
         ,CONSTRUCT_SIGNAL_OUT(w_lf_filtered,              double, m_w_lfSOUT)
         ,CONSTRUCT_SIGNAL_OUT(w_rf_filtered,              double, m_w_rfSOUT)
+        ,CONSTRUCT_SIGNAL_OUT(latency,                    dynamicgraph::Vector, m_vSOUT)
+        ,CONSTRUCT_SIGNAL_OUT(deadline_misses,            dynamicgraph::Vector, m_vSOUT)
         ,m_initSucceeded(false)
         ,m_reset_foot_pos(true)
         ,m_w_imu(0.0)
@@ -175,9 +182,15 @@ namespace dynamicgraph
         ,m_fz_std_dev_lf(1.0)
         ,m_zmp_margin_lf(0.0)
         ,m_zmp_margin_rf(0.0)
+        ,m_kinematics(NULL)
+        ,m_model(NULL)
+        ,m_data(NULL)
       {
         Entity::signalRegistration( INPUT_SIGNALS << OUTPUT_SIGNALS );
 
+        for(int i=0; i<N_PROFILE_SECTIONS; i++)
+          m_profileSections.push_back(getProfiler().get_id(name+": "+PROFILE_SECTION_NAMES[i]));
+
         m_K_rf << 4034,23770,239018,707,502,936;
         m_K_lf << 4034,23770,239018,707,502,936;
         m_left_foot_sizes  << 0.130, -0.100,  0.075, -0.056;
@@ -266,6 +279,10 @@ namespace dynamicgraph
                    makeCommandVoid1(*this, &BaseEstimator::set_normal_force_margin_left_foot,
                                     docCommandVoid1("Set the normal force margin for the left foot",
                                                     "double")));
+        addCommand("set_deadline",
+                   makeCommandVoid1(*this, &BaseEstimator::set_deadline,
+                                    docCommandVoid1("Set the maximum computation time of the profiled sections (kinematics computation, position and velocity estimation), used to count their deadline misses (none by default)",
+                                                    "Deadline in seconds of each section, 0 for none (vector)")));
       }
 
       void BaseEstimator::init(const double & dt, const std::string& robotRef)
@@ -286,17 +303,18 @@ namespace dynamicgraph
             return;
           }
 
-          se3::urdf::buildModel(m_robot_util->m_urdf_filename,
-                                se3::JointModelFreeFlyer(), m_model);
+          m_kinematics = getKinematicsCache(localName, m_robot_util->m_urdf_filename);
+          m_kinematicsClient = m_kinematics->addClient();
+          m_model = &m_kinematics->model();
 
-          assert(m_model.existFrame(m_robot_util->m_foot_util.m_Left_Foot_Frame_Name));
-          assert(m_model.existFrame(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name));
-          assert(m_model.existFrame(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name));
-          m_left_foot_id  = m_model.getFrameId(m_robot_util->m_foot_util.m_Left_Foot_Frame_Name);
-          m_right_foot_id = m_model.getFrameId(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name);
-          m_IMU_body_id   = m_model.getFrameId(m_robot_util->m_imu_joint_name);
+          assert(m_model->existFrame(m_robot_util->m_foot_util.m_Left_Foot_Frame_Name));
+          assert(m_model->existFrame(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name));
+          assert(m_model->existFrame(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name));
+          m_left_foot_id  = m_model->getFrameId(m_robot_util->m_foot_util.m_Left_Foot_Frame_Name);
+          m_right_foot_id = m_model->getFrameId(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name);
+          m_IMU_body_id   = m_model->getFrameId(m_robot_util->m_imu_joint_name);
 
-          m_q_pin.setZero(m_model.nq);
+          m_q_pin.setZero(m_model->nq);
           m_q_pin[6]= 1.; // for quaternion
           m_q_sot.setZero(m_robot_util->m_nbJoints+6);
           m_v_pin.setZero(m_robot_util->m_nbJoints+6);
@@ -328,7 +346,8 @@ namespace dynamicgraph
           SEND_MSG("Init failed: Could load URDF :" + m_robot_util->m_urdf_filename, MSG_TYPE_ERROR);
           return;
         }
-        m_data = new se3::Data(m_model);
+        m_data = &m_kinematics->compute(m_kinematicsClient, m_q_pin, m_v_pin,
+                                        KinematicsCache::VELOCITIES | KinematicsCache::FRAMES);
         m_initSucceeded = true;
       }
 
@@ -450,6 +469,14 @@ namespace dynamicgraph
         m_fz_margin_lf = margin;
       }
 
+      void BaseEstimator::set_deadline(const dynamicgraph::Vector& deadlines)
+      {
+        if(deadlines.size()!=N_PROFILE_SECTIONS)
+          return SEND_MSG("The deadlines must be a vector of size "+toString(N_PROFILE_SECTIONS), MSG_TYPE_ERROR);
+        for(int i=0; i<N_PROFILE_SECTIONS; i++)
+          getProfiler().set_deadline(m_profileSections[i], deadlines(i));
+      }
+
       void BaseEstimator::compute_zmp(const Vector6 & w, Vector2 & zmp)
       {
         se3::Force f(w);
@@ -577,16 +604,16 @@ namespace dynamicgraph
         m_robot_util->joints_sot_to_urdf(qj, m_q_pin.tail(m_robot_util->m_nbJoints));
         m_robot_util->joints_sot_to_urdf(dq, m_v_pin.tail(m_robot_util->m_nbJoints));
 
-        getProfiler().start(PROFILE_BASE_KINEMATICS_COMPUTATION);
+        getProfiler().start(m_profileSections[PROFILE_BASE_KINEMATICS_COMPUTATION]);
 
         /* Compute kinematics assuming world is at free-flyer frame */
         m_q_pin.head<6>().setZero();
         m_q_pin(6) = 1.0;
         m_v_pin.head<6>().setZero();
-        se3::forwardKinematics(m_model, *m_data, m_q_pin, m_v_pin);
-        se3::framesForwardKinematics(m_model, *m_data);
+        m_data = &m_kinematics->compute(m_kinematicsClient, m_q_pin, m_v_pin,
+                                        KinematicsCache::VELOCITIES | KinematicsCache::FRAMES);
 
-        getProfiler().stop(PROFILE_BASE_KINEMATICS_COMPUTATION);
+        getProfiler().stop(m_profileSections[PROFILE_BASE_KINEMATICS_COMPUTATION]);
 
         return s;
       }
@@ -632,11 +659,9 @@ namespace dynamicgraph
         // if both weights are zero set them to a small positive value to avoid division by zero
         if(wR==0.0 && wL==0.0)
         {
-          SEND_WARNING_STREAM_MSG("The robot is flying!"+
-                                  ("- forceRLEG: "+toString(ftrf.transpose()))+
-                                   "- forceLLEG: "+toString(ftlf.transpose())+
-                                  "- m_right_foot_is_stable: "+toString(m_right_foot_is_stable)+
-                                  "- m_left_foot_is_stable: "+toString(m_left_foot_is_stable));
+          SEND_RECORD4(MSG_TYPE_WARNING_STREAM, "The robot is flying! - forceRLEG z: %.3f - forceLLEG z: %.3f"
+                       " - m_right_foot_is_stable: %.0f - m_left_foot_is_stable: %.0f",
+                       ftrf(2), ftlf(2), (double) m_right_foot_is_stable, (double) m_left_foot_is_stable);
           wR = 1e-3;
           wL = 1e-3;
         }
@@ -646,7 +671,7 @@ namespace dynamicgraph
         if(m_reset_foot_pos)
           reset_foot_positions_impl(ftlf, ftrf);
 
-        getProfiler().start(PROFILE_BASE_POSITION_ESTIMATION);
+        getProfiler().start(m_profileSections[PROFILE_BASE_POSITION_ESTIMATION]);
         {
           SE3 oMlfa, oMrfa, lfsMff, rfsMff;
           kinematics_estimation(ftrf, m_K_rf, m_oMrfs, m_right_foot_id, m_oMff_rf, oMrfa, rfsMff);
@@ -779,7 +804,7 @@ namespace dynamicgraph
           m_oMrfs_xyzquat(5) = quat_rf.y();
           m_oMrfs_xyzquat(6) = quat_rf.z();
         }
-        getProfiler().stop(PROFILE_BASE_POSITION_ESTIMATION);
+        getProfiler().stop(m_profileSections[PROFILE_BASE_POSITION_ESTIMATION]);
         return s;
       }
 
@@ -972,7 +997,7 @@ namespace dynamicgraph
         m_kinematics_computationsSINNER(iter);
         m_qSOUT(iter);
 
-        getProfiler().start(PROFILE_BASE_VELOCITY_ESTIMATION);
+        getProfiler().start(m_profileSections[PROFILE_BASE_VELOCITY_ESTIMATION]);
         {
           const Eigen::VectorXd& dq          = m_joint_velocitiesSIN(iter);
           const Eigen::Vector3d& acc_imu     = m_accelerometerSIN(iter);
@@ -1010,14 +1035,14 @@ namespace dynamicgraph
           }
 
           /* Compute foot velocities */
-          const Frame & f_lf = m_model.frames[m_left_foot_id];
+          const Frame & f_lf = m_model->frames[m_left_foot_id];
           const Motion v_lf_local = m_data->v[f_lf.parent];
           const SE3 ffMlf = m_data->oMi[f_lf.parent];
           Vector6 v_kin_l = -ffMlf.act(v_lf_local).toVector(); //this is the velocity of the base in the frame of the base.
           v_kin_l.head<3>()     = m_oRff * v_kin_l.head<3>();
           v_kin_l.segment<3>(3) = m_oRff * v_kin_l.segment<3>(3);
 
-          const Frame & f_rf = m_model.frames[m_right_foot_id];
+          const Frame & f_rf = m_model->frames[m_right_foot_id];
           const Motion v_rf_local = m_data->v[f_rf.parent];
           const SE3 ffMrf = m_data->oMi[f_rf.parent];
           Vector6 v_kin_r = -ffMrf.act(v_rf_local).toVector(); //this is the velocity of the base in the frame of the base.
@@ -1057,7 +1082,7 @@ namespace dynamicgraph
           const SE3 ffMchest(m_data->oMf[m_IMU_body_id]);
           const SE3 imuMff = (ffMchest * chestMimu).inverse();
           //gVw_a =  gVo_g + gHa.act(aVb_a)-gVb_g //angular velocity in the ankle from gyro and d_enc
-          const Frame & f_imu = m_model.frames[m_IMU_body_id];
+          const Frame & f_imu = m_model->frames[m_IMU_body_id];
           Vector3 gVo_a_l = Vector3(gyr_imu(0),gyr_imu(1),gyr_imu(2)) + (imuMff*ffMlf).act(v_lf_local).angular() - m_data->v[f_imu.parent].angular();
           Vector3 gVo_a_r = Vector3(gyr_imu(0),gyr_imu(1),gyr_imu(2)) + (imuMff*ffMrf).act(v_rf_local).angular() - m_data->v[f_imu.parent].angular();
           Motion v_gyr_ankle_l( Vector3(0.,0.,0.),  lfRimu * gVo_a_l);
@@ -1106,7 +1131,7 @@ namespace dynamicgraph
           const Vector3 imuVimu = m_oRchest.transpose() * ACvel;
           /* Here we could remove dc from gyrometer to remove bias*/  ///TODO 
           const Motion imuWimu(imuVimu,gyr_imu);
-          //const Frame & f_imu = m_model.frames[m_IMU_body_id];
+          //const Frame & f_imu = m_model->frames[m_IMU_body_id];
           const Motion ffWchest = m_data->v[f_imu.parent];
           //const SE3 ffMchest(m_data->oMf[m_IMU_body_id]);
           //const SE3 chestMimu(Matrix3::Identity(), +1.0*Vector3(-0.13, 0.0,  0.118)); ///TODO Read this transform from setable parameter /// TODO chesk the sign of the translation
@@ -1130,7 +1155,7 @@ namespace dynamicgraph
           s = m_v_sot;
 
         }
-        getProfiler().stop(PROFILE_BASE_VELOCITY_ESTIMATION);
+        getProfiler().stop(m_profileSections[PROFILE_BASE_VELOCITY_ESTIMATION]);
         return s;
       }
       
@@ -1206,6 +1231,20 @@ namespace dynamicgraph
         return s;
       }      
 
+      DEFINE_SIGNAL_OUT_FUNCTION(latency, dynamicgraph::Vector)
+      {
+        m_vSOUT(iter);
+        getProfiler().get_latencies(&m_profileSections[0], N_PROFILE_SECTIONS, s);
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(deadline_misses, dynamicgraph::Vector)
+      {
+        m_vSOUT(iter);
+        getProfiler().get_deadline_misses(&m_profileSections[0], N_PROFILE_SECTIONS, s);
+        return s;
+      }
+
       /* --- COMMANDS ---------------------------------------------------------- */
 
       /* ------------------------------------------------------------------- */
@@ -53,6 +53,27 @@ CausalFilter::CausalFilter(const double &timestep,
   assert(timestep>0.0 && "Timestep should be > 0");
   assert(m_filter_numerator.size() == m_filter_order_m);
   assert(m_filter_denominator.size() == m_filter_order_n);
+  m_input_term.setZero(xSize);
+  m_output_term.setZero(xSize);
+  compute_coefficient_tables();
+}
+
+
+/* The history of input and output is stored in circular buffers. The
+   coefficients multiplying each column of the buffers depend on the current
+   position in the buffer, so they are precomputed for every position. */
+void CausalFilter::compute_coefficient_tables()
+{
+  m_numerator_table.resize(m_filter_order_m, m_filter_order_m);
+  for(int k=0; k<m_filter_order_m; k++)
+    for(int i=0; i<m_filter_order_m; i++)
+      m_numerator_table(i,k) = m_filter_numerator[(k-i+m_filter_order_m) % m_filter_order_m];
+
+  const int n = m_filter_order_n-1;
+  m_denominator_table.resize(n, n);
+  for(int k=0; k<n; k++)
+    for(int i=0; i<n; i++)
+      m_denominator_table(i,k) = m_filter_denominator[1 + (k-i+n) % n];
 }
 
 
@@ -71,16 +92,9 @@ void CausalFilter::get_x_dx_ddx(const Eigen::VectorXd& base_x,
 
   input_buffer.col(pt_numerator) = base_x;
   
-  Eigen::VectorXd b(m_filter_order_m);
-  Eigen::VectorXd a(m_filter_order_n-1);
-  b.head(pt_numerator+1) = m_filter_numerator.head(pt_numerator+1).reverse();
-  b.tail(m_filter_order_m-pt_numerator-1) =
-    m_filter_numerator.tail(m_filter_order_m-pt_numerator-1).reverse();
-
-  a.head(pt_denominator+1) = m_filter_denominator.segment(1, pt_denominator+1).reverse();
-  a.tail(m_filter_order_n-pt_denominator-2) =
-    m_filter_denominator.tail(m_filter_order_n-pt_denominator-2).reverse();
-  x_output_dx_ddx.head(m_x_size) = (input_buffer*b-output_buffer*a)/m_filter_denominator[0];
+  m_input_term.noalias()  = input_buffer*m_numerator_table.col(pt_numerator);
+  m_output_term.noalias() = output_buffer*m_denominator_table.col(pt_denominator);
+  x_output_dx_ddx.head(m_x_size) = (m_input_term-m_output_term)/m_filter_denominator[0];
 
   //Finite Difference
   int pt_denominator_prev = (pt_denominator == 0) ? m_filter_order_n-2 : pt_denominator-1;  
@@ -124,5 +138,6 @@ void CausalFilter::switch_filter(const Eigen::VectorXd& filter_numerator,
   pt_numerator = 0;
   pt_denominator = 0;
 
+  compute_coefficient_tables();
   return;
 }
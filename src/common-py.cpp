@@ -56,7 +56,7 @@ BOOST_PYTHON_MODULE(common_sot_py)
   class_<RobotUtil>("RobotUtil")
     .def_readwrite("m_force_util",&RobotUtil::m_force_util)
     .def_readwrite("m_foot_util",&RobotUtil::m_foot_util)
-    .def_readwrite("m_urdf_to_sot",&RobotUtil::m_urdf_to_sot)
+    .def_readonly("m_urdf_to_sot",&RobotUtil::m_urdf_to_sot)
     .def_readonly("m_nbJoints",&RobotUtil::m_nbJoints)
     .def_readwrite("m_name_to_id",&RobotUtil::m_name_to_id)
     .def_readwrite("m_id_to_name",&RobotUtil::m_id_to_name)
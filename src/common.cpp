@@ -17,6 +17,7 @@
 #include <sot/torque_control/common.hh>
 #include <sot/core/debug.hh>
 #include <dynamic-graph/factory.h>
+#include <tsid/robots/robot-wrapper.hpp>
 
 namespace dynamicgraph
 {
@@ -169,7 +170,53 @@ namespace dynamicgraph
       }
 
       /**************** FromURDFToSot *************************/
+
+      /// Minimum average length of the joint segments for the conversions
+      /// to copy them rather than gather the joints one by one: a robot like
+      /// HRP-2 has runs of 1 to 7 joints, for which the gather is faster.
+      static const Index JOINT_SEGMENT_MIN_AVERAGE_LENGTH = 8;
+
+      /// Copy a run of joints. Eigen::Ref<VectorXd> has a unit inner stride,
+      /// so the joints of a JointSegment are contiguous in memory. The segments
+      /// are short, so an inline loop is faster than a call to memcpy.
+      static inline void copy_joints(const double* from, double* to, Index length)
+      {
+	for(Index k=0; k<length; k++)
+	  to[k] = from[k];
+      }
+
+      /// Copy the joints of urdf (URDF order) to sot (SoT order)
+      static inline void copy_urdf_to_sot(const RobotUtil & ru, const double* urdf, double* sot)
+      {
+	if(ru.m_urdf_to_sot_use_segments)
+	  for(std::size_t i=0; i<ru.m_urdf_to_sot_segments.size(); i++)
+	    {
+	      const JointSegment & seg = ru.m_urdf_to_sot_segments[i];
+	      copy_joints(urdf+seg.urdf, sot+seg.sot, seg.length);
+	    }
+	else
+	  for(std::size_t idx=0; idx<ru.m_urdf_to_sot.size(); idx++)
+	    sot[ru.m_urdf_to_sot[idx]] = urdf[idx];
+      }
+
+      /// Copy the joints of sot (SoT order) to urdf (URDF order)
+      static inline void copy_sot_to_urdf(const RobotUtil & ru, const double* sot, double* urdf)
+      {
+	if(ru.m_urdf_to_sot_use_segments)
+	  for(std::size_t i=0; i<ru.m_urdf_to_sot_segments.size(); i++)
+	    {
+	      const JointSegment & seg = ru.m_urdf_to_sot_segments[i];
+	      copy_joints(sot+seg.sot, urdf+seg.urdf, seg.length);
+	    }
+	else
+	  for(std::size_t idx=0; idx<ru.m_urdf_to_sot.size(); idx++)
+	    urdf[idx] = sot[ru.m_urdf_to_sot[idx]];
+      }
+
       RobotUtil::RobotUtil()
+        : m_urdf_to_sot_identity(false)
+        , m_urdf_to_sot_use_segments(false)
+        , m_nbJoints(0)
       {}
 
       void RobotUtil::
@@ -244,6 +291,7 @@ namespace dynamicgraph
 	    m_urdf_to_sot[(Index)idx] = urdf_to_sot[(Index)idx];
 	    m_dgv_urdf_to_sot[(Index)idx] = urdf_to_sot[(Index)idx];
 	  }
+	create_urdf_to_sot_segments();
       }
       
       void RobotUtil::
@@ -256,21 +304,55 @@ namespace dynamicgraph
 	    m_urdf_to_sot[idx] = (unsigned int)urdf_to_sot[idx];
 	  }
 	m_dgv_urdf_to_sot = urdf_to_sot;
+	create_urdf_to_sot_segments();
+      }
+
+      void RobotUtil::
+      create_urdf_to_sot_segments()
+      {
+	m_urdf_to_sot_segments.clear();
+	for(Index idx=0; idx<(Index)m_urdf_to_sot.size(); idx++)
+	  {
+	    if(!m_urdf_to_sot_segments.empty())
+	      {
+		JointSegment & last = m_urdf_to_sot_segments.back();
+		if(last.urdf+last.length==idx &&
+		   last.sot+last.length==m_urdf_to_sot[idx])
+		  {
+		    last.length++;
+		    continue;
+		  }
+	      }
+	    JointSegment seg;
+	    seg.urdf = idx;
+	    seg.sot = m_urdf_to_sot[idx];
+	    seg.length = 1;
+	    m_urdf_to_sot_segments.push_back(seg);
+	  }
+	m_urdf_to_sot_identity = m_urdf_to_sot_segments.size()==1 &&
+	  m_urdf_to_sot_segments[0].sot==0;
+	m_urdf_to_sot_use_segments = (Index)m_urdf_to_sot.size() >=
+	  JOINT_SEGMENT_MIN_AVERAGE_LENGTH*(Index)m_urdf_to_sot_segments.size();
       }
       
       bool RobotUtil::
       joints_urdf_to_sot(Eigen::ConstRefVector q_urdf, Eigen::RefVector q_sot)
       {
-	if (m_nbJoints==0)
+	assert(q_urdf.size()==static_cast<Eigen::VectorXd::Index>(m_nbJoints));
+	assert(q_sot.size()==static_cast<Eigen::VectorXd::Index>(m_nbJoints));
+
+	if (m_urdf_to_sot_identity)
+	  {
+	    q_sot = q_urdf;
+	    return true;
+	  }
+	if (m_urdf_to_sot_segments.empty())
 	  {
 	    SEND_MSG("set_urdf_to_sot should be called", MSG_TYPE_ERROR);
 	    return false;
 	  }
-	assert(q_urdf.size()==m_nbJoints);
-	assert(q_sot.size()==m_nbJoints);
-	
-	for(unsigned int idx=0;idx<m_nbJoints;idx++)
-	  q_sot[m_urdf_to_sot[idx]]=q_urdf[idx];	
+
+	copy_urdf_to_sot(*this, q_urdf.data(), q_sot.data());
 	return true;
       }
       
@@ -280,14 +362,45 @@ namespace dynamicgraph
 	assert(q_urdf.size()==static_cast<Eigen::VectorXd::Index>(m_nbJoints));
 	assert(q_sot.size()==static_cast<Eigen::VectorXd::Index>(m_nbJoints));
 
-	if (m_nbJoints==0)
+	if (m_urdf_to_sot_identity)
+	  {
+	    q_urdf = q_sot;
+	    return true;
+	  }
+	if (m_urdf_to_sot_segments.empty())
 	  {
 	    SEND_MSG("set_urdf_to_sot should be called", MSG_TYPE_ERROR);
 	    return false;
 	  }
-	
-	for(unsigned int idx=0;idx<m_nbJoints;idx++)
-	  q_urdf[idx]=q_sot[m_urdf_to_sot[idx]];	
+
+	copy_sot_to_urdf(*this, q_sot.data(), q_urdf.data());
+	return true;
+      }
+
+      bool RobotUtil::
+      joints_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::ConstRefVector v_sot,
+                         Eigen::ConstRefVector a_sot, Eigen::RefVector q_urdf,
+                         Eigen::RefVector v_urdf, Eigen::RefVector a_urdf)
+      {
+	assert(v_sot.size()==q_sot.size() && a_sot.size()==q_sot.size());
+	assert(v_urdf.size()==q_urdf.size() && a_urdf.size()==q_urdf.size());
+
+	if (m_urdf_to_sot_identity)
+	  {
+	    q_urdf = q_sot;
+	    v_urdf = v_sot;
+	    a_urdf = a_sot;
+	    return true;
+	  }
+	if (m_urdf_to_sot_segments.empty())
+	  {
+	    SEND_MSG("set_urdf_to_sot should be called", MSG_TYPE_ERROR);
+	    return false;
+	  }
+
+	copy_sot_to_urdf(*this, q_sot.data(), q_urdf.data());
+	copy_sot_to_urdf(*this, v_sot.data(), v_urdf.data());
+	copy_sot_to_urdf(*this, a_sot.data(), a_urdf.data());
 	return true;
       }
       
@@ -314,6 +427,31 @@ namespace dynamicgraph
 	return true;
       }
 
+      bool RobotUtil::
+      velocity_urdf_to_sot(Eigen::ConstRefVector q_urdf,
+                           Eigen::ConstRefVector v_urdf, Eigen::ConstRefVector a_urdf,
+                           Eigen::RefVector v_sot, Eigen::RefVector a_sot)
+      {
+        assert(q_urdf.size()==m_nbJoints+7);
+	assert(v_urdf.size()==m_nbJoints+6 && a_urdf.size()==m_nbJoints+6);
+	assert(v_sot.size()==m_nbJoints+6 && a_sot.size()==m_nbJoints+6);
+
+	if (m_nbJoints==0)
+	  {
+	    SEND_MSG("velocity_urdf_to_sot should be called", MSG_TYPE_ERROR);
+	    return false;
+	  }
+        const Eigen::Quaterniond q(q_urdf(6), q_urdf(3), q_urdf(4), q_urdf(5));
+        const Eigen::Matrix3d oRb = q.toRotationMatrix();
+        v_sot.head<3>()     = oRb*v_urdf.head<3>();
+        v_sot.segment<3>(3) = oRb*v_urdf.segment<3>(3);
+        a_sot.head<3>()     = oRb*a_urdf.head<3>();
+        a_sot.segment<3>(3) = oRb*a_urdf.segment<3>(3);
+        joints_urdf_to_sot(v_urdf.tail(m_nbJoints), v_sot.tail(m_nbJoints));
+        joints_urdf_to_sot(a_urdf.tail(m_nbJoints), a_sot.tail(m_nbJoints));
+	return true;
+      }
+
       bool RobotUtil::
       velocity_sot_to_urdf(Eigen::ConstRefVector q_urdf, Eigen::ConstRefVector v_sot,
                            Eigen::RefVector v_urdf)
@@ -399,8 +537,39 @@ namespace dynamicgraph
 	base_sot_to_urdf(q_sot.head<6>(), q_urdf.head<7>());
         joints_sot_to_urdf(q_sot.tail(m_nbJoints), 
 			   q_urdf.tail(m_nbJoints));
+	return true;
+      }
 
-	
+      bool RobotUtil::
+      config_velocity_sot_to_urdf(Eigen::ConstRefVector q_sot, Eigen::ConstRefVector v_sot,
+                                  Eigen::RefVector q_urdf, Eigen::RefVector v_urdf)
+      {
+        assert(q_urdf.size()==m_nbJoints+7);
+        assert(q_sot.size()==m_nbJoints+6);
+	assert(v_urdf.size()==m_nbJoints+6);
+	assert(v_sot.size()==m_nbJoints+6);
+
+	if (m_urdf_to_sot_segments.empty())
+	  {
+	    SEND_MSG("set_urdf_to_sot should be called", MSG_TYPE_ERROR);
+	    return false;
+	  }
+	base_sot_to_urdf(q_sot.head<6>(), q_urdf.head<7>());
+        // rotation from world to base frame, from the quaternion just computed
+        const Eigen::Quaterniond q(q_urdf(6), q_urdf(3), q_urdf(4), q_urdf(5));
+        const Eigen::Matrix3d oRb = q.toRotationMatrix();
+        v_urdf.head<3>()     = oRb.transpose()*v_sot.head<3>();
+        v_urdf.segment<3>(3) = oRb.transpose()*v_sot.segment<3>(3);
+
+	if (m_urdf_to_sot_identity)
+	  {
+	    q_urdf.tail(m_nbJoints) = q_sot.tail(m_nbJoints);
+	    v_urdf.tail(m_nbJoints) = v_sot.tail(m_nbJoints);
+	    return true;
+	  }
+	copy_sot_to_urdf(*this, q_sot.data()+6, q_urdf.data()+7);
+	copy_sot_to_urdf(*this, v_sot.data()+6, v_urdf.data()+6);
+	return true;
       }
       void RobotUtil::
       display(std::ostream &os) const
@@ -539,6 +708,29 @@ namespace dynamicgraph
 		  << std::endl;
 	return RefVoidRobotUtil();
       }
+
+      std::map<std::string,tsid::robots::RobotWrapper *> sgl_map_urdf_to_robot_model;
+
+      const tsid::robots::RobotWrapper & getRobotModel(const std::string &urdfFileName,
+                                                       RootJointType rootJoint)
+      {
+        const std::string key = urdfFileName +
+          (rootJoint==ROOT_JOINT_FREE_FLYER ? "#free-flyer" : "#fixed");
+        std::map<std::string,tsid::robots::RobotWrapper *>::iterator it =
+          sgl_map_urdf_to_robot_model.find(key);
+        if (it!=sgl_map_urdf_to_robot_model.end())
+          return *it->second;
+
+        std::vector<std::string> package_dirs;
+        tsid::robots::RobotWrapper * robot;
+        if (rootJoint==ROOT_JOINT_FREE_FLYER)
+          robot = new tsid::robots::RobotWrapper(urdfFileName, package_dirs,
+                                                 se3::JointModelFreeFlyer());
+        else
+          robot = new tsid::robots::RobotWrapper(urdfFileName, package_dirs);
+        sgl_map_urdf_to_robot_model[key] = robot;
+        return *robot;
+      }
       
     } // torque_control
   } // sot
@@ -21,7 +21,7 @@
 
 #include <sot/torque_control/commands-helper.hh>
 #include <tsid/utils/stop-watch.hpp>
-#include <tsid/utils/statistics.hpp>
+#include <sot/torque_control/utils/statistics.hh>
 
 using namespace tsid;
 
@@ -44,7 +44,7 @@ namespace dynamicgraph
 
 #define INPUT_SIGNALS  m_i_maxSIN << m_u_maxSIN << m_tau_maxSIN << \
                        m_tauSIN << m_tau_predictedSIN << m_i_measuredSIN
-#define OUTPUT_SIGNALS m_uSOUT << m_u_safeSOUT
+#define OUTPUT_SIGNALS m_uSOUT << m_u_safeSOUT << m_logger_dropped_messagesSOUT
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -69,12 +69,15 @@ namespace dynamicgraph
         ,CONSTRUCT_SIGNAL_OUT(u,              dynamicgraph::Vector, m_i_measuredSIN)
         ,CONSTRUCT_SIGNAL_OUT(u_safe,         dynamicgraph::Vector, INPUT_SIGNALS <<
                                                                     m_uSOUT)
+        ,CONSTRUCT_SIGNAL_OUT(logger_dropped_messages, dynamicgraph::Vector, m_u_safeSOUT)
         ,m_robot_util(RefVoidRobotUtil())
         ,m_initSucceeded(false)
         ,m_emergency_stop_triggered(false)
         ,m_is_first_iter(true)
         ,m_iter(0)
         ,m_sleep_time(0.0)
+        ,m_nbJointsInTransition(0)
+        ,m_nbJointsWithoutCtrlMode(0)
       {
 
         Entity::signalRegistration( INPUT_SIGNALS << OUTPUT_SIGNALS);
@@ -169,6 +172,11 @@ namespace dynamicgraph
                                     docCommandVoid1("Set the period used for printing in streaming.",
                                                     "Print period in seconds (double)")));
 
+        addCommand("setLoggerAsynchronous",
+                   makeCommandVoid1(*this, &ControlManager::setLoggerAsynchronous,
+                                    docCommandVoid1("Print the log messages from a background thread, so that the control loop never blocks on I/O.",
+                                                    "True to enable, false to disable (bool)")));
+
         addCommand("setSleepTime",
                    makeCommandVoid1(*this, &ControlManager::setSleepTime,
                                     docCommandVoid1("Set the time to sleep at every iteration (to slow down simulation).",
@@ -213,6 +221,9 @@ namespace dynamicgraph
         m_jointCtrlModes_current.resize(m_robot_util->m_nbJoints);
         m_jointCtrlModes_previous.resize(m_robot_util->m_nbJoints);
         m_jointCtrlModesCountDown.resize(m_robot_util->m_nbJoints,0);
+        m_nbJointsInTransition = 0;
+        m_nbJointsWithoutCtrlMode = m_robot_util->m_nbJoints;
+        m_ctrlModeWeights.setZero(m_robot_util->m_nbJoints, m_ctrlModes.size());
       }
 
 
@@ -224,7 +235,7 @@ namespace dynamicgraph
       {
         if(!m_initSucceeded)
         {
-          SEND_WARNING_STREAM_MSG("Cannot compute signal u before initialization!");
+          SEND_RECORD(MSG_TYPE_WARNING_STREAM, "Cannot compute signal u before initialization!");
           return s;
         }
 
@@ -239,43 +250,34 @@ namespace dynamicgraph
 
         getProfiler().start(PROFILE_PWM_DESIRED_COMPUTATION);
         {
-          // trigger computation of all ctrl inputs
-          for(unsigned int i=0; i<m_ctrlInputsSIN.size(); i++)
-            (*m_ctrlInputsSIN[i])(iter);
+          if(m_nbJointsWithoutCtrlMode>0)
+            SEND_RECORD1(MSG_TYPE_ERROR_STREAM, "You forgot to set the control mode of %.0f joints",
+                         m_nbJointsWithoutCtrlMode);
 
-          int cm_id, cm_id_prev;
-          for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
+          // blend the inputs of all ctrl modes with the weights of the joints
+          // (the inputs of the joints with weight 0 are masked out, they may be NaN)
+          s.setZero();
+          for(unsigned int i=0; i<m_ctrlInputsSIN.size(); i++)
           {
-            cm_id = m_jointCtrlModes_current[i].id;
-            if(cm_id<0)
-            {
-              SEND_MSG("You forgot to set the control mode of joint "+toString(i), MSG_TYPE_ERROR_STREAM);
-              continue;
-            }
-
-            const dynamicgraph::Vector& ctrl = (*m_ctrlInputsSIN[cm_id])(iter);
+            const dynamicgraph::Vector& ctrl = (*m_ctrlInputsSIN[i])(iter);
             assert(ctrl.size()==m_robot_util->m_nbJoints);
+            s.array() += (m_ctrlModeWeights.col(i).array()!=0.0).select(
+                           m_ctrlModeWeights.col(i).array()*ctrl.array(), 0.0);
+          }
 
+          // move the joints in transition towards their new ctrl mode
+          for(unsigned int i=0; m_nbJointsInTransition>0 && i<m_robot_util->m_nbJoints; i++)
+          {
+            if(m_jointCtrlModesCountDown[i]==0)
+              continue;
+            m_jointCtrlModesCountDown[i]--;
+            updateCtrlModeWeights(i);
             if(m_jointCtrlModesCountDown[i]==0)
-              s(i) = ctrl(i);
-            else
             {
-              cm_id_prev = m_jointCtrlModes_previous[i].id;
-              const dynamicgraph::Vector& ctrl_prev = (*m_ctrlInputsSIN[cm_id_prev])(iter);
-              assert(ctrl_prev.size()==m_robot_util->m_nbJoints);
-
-              double alpha = m_jointCtrlModesCountDown[i]/CTRL_MODE_TRANSITION_TIME_STEP;
-//              SEND_MSG("Joint "+toString(i)+" changing ctrl mode from "+toString(cm_id_prev)+
-//                       " to "+toString(cm_id)+" alpha="+toString(alpha),MSG_TYPE_DEBUG);
-              s(i) = alpha*ctrl_prev(i) + (1-alpha)*ctrl(i);
-              m_jointCtrlModesCountDown[i]--;
-
-              if(m_jointCtrlModesCountDown[i]==0)
-              {
-                SEND_MSG("Joint "+toString(i)+" changed ctrl mode from "+toString(cm_id_prev)+
-                         " to "+toString(cm_id),MSG_TYPE_INFO);
-                updateJointCtrlModesOutputSignal();
-              }
+              m_nbJointsInTransition--;
+              SEND_RECORD3(MSG_TYPE_INFO, "Joint %.0f changed ctrl mode from %.0f to %.0f", i,
+                           m_jointCtrlModes_previous[i].id, m_jointCtrlModes_current[i].id);
+              updateJointCtrlModesOutputSignal();
             }
           }
         }
@@ -294,11 +296,34 @@ namespace dynamicgraph
         return s;
       }
 
+      /// Index of the first element of v whose absolute value exceeds its limit, -1 if none.
+      /// The limits of all the joints are checked at once, the index is searched only on failure.
+      static Eigen::VectorXd::Index firstAboveLimit(const dynamicgraph::Vector& v,
+                                                    const dynamicgraph::Vector& limit)
+      {
+        assert(v.size()==limit.size());
+        if(!(v.array().abs() > limit.array()).any())
+          return -1;
+        Eigen::VectorXd::Index i = 0;
+        while(!(fabs(v(i)) > limit(i)))
+          i++;
+        return i;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(logger_dropped_messages,dynamicgraph::Vector)
+      {
+        m_u_safeSOUT(iter);
+        if(s.size()!=1)
+          s.resize(1);
+        s(0) = (double) getLogger().getDroppedMessages();
+        return s;
+      }
+
       DEFINE_SIGNAL_OUT_FUNCTION(u_safe,dynamicgraph::Vector)
       {
         if(!m_initSucceeded)
         {
-          SEND_WARNING_STREAM_MSG("Cannot compute signal u_safe before initialization!");
+          SEND_RECORD(MSG_TYPE_WARNING_STREAM, "Cannot compute signal u_safe before initialization!");
           return s;
         }
 
@@ -315,7 +340,7 @@ namespace dynamicgraph
           if ((*m_emergencyStopSIN[i]).isPlugged() && (*m_emergencyStopSIN[i])(iter)) 
           {
             m_emergency_stop_triggered = true;
-            SEND_MSG("Emergency Stop has been triggered by an external entity", MSG_TYPE_ERROR);
+            SEND_RECORD(MSG_TYPE_ERROR, "Emergency Stop has been triggered by an external entity");
           }
         }
 
@@ -323,37 +348,30 @@ namespace dynamicgraph
 
         if(!m_emergency_stop_triggered)
         {
-          for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
+          Eigen::VectorXd::Index i;
+          if((i=firstAboveLimit(tau, tau_max))>=0)
           {
-            if(fabs(tau(i)) > tau_max(i))
-            {
-              m_emergency_stop_triggered = true;
-              SEND_MSG("Estimated torque "+toString(tau(i))+" > max torque "+toString(tau_max(i))+
-                       " for joint "+ m_robot_util->get_name_from_id(i), MSG_TYPE_ERROR);
-            }
-
-            if(fabs(tau_predicted(i)) > tau_max(i))
-            {
-              m_emergency_stop_triggered = true;
-              SEND_MSG("Predicted torque "+toString(tau_predicted(i))+" > max torque "+toString(tau_max(i))+
-                       " for joint "+m_robot_util->get_name_from_id(i), MSG_TYPE_ERROR);
-            }
-
-            if(fabs(i_real(i)) > i_max(i))
-            {
-              m_emergency_stop_triggered = true;
-              SEND_MSG("Joint "+m_robot_util->get_name_from_id(i)+" measured current is too large: "+
-                       toString(i_real(i))+"A > "+toString(i_max(i))+"A", MSG_TYPE_ERROR);
-              break;
-            }
-
-            if(fabs(u(i)) > ctrl_max(i))
-            {
-              m_emergency_stop_triggered = true;
-              SEND_MSG("Joint "+m_robot_util->get_name_from_id(i)+" desired current is too large: "+
-                       toString(u(i))+"A > "+toString(ctrl_max(i))+"A", MSG_TYPE_ERROR);
-              break;
-            }
+            m_emergency_stop_triggered = true;
+            SEND_RECORD3(MSG_TYPE_ERROR, "Estimated torque %.3f > max torque %.3f for joint %.0f",
+                         tau(i), tau_max(i), i);
+          }
+          else if((i=firstAboveLimit(tau_predicted, tau_max))>=0)
+          {
+            m_emergency_stop_triggered = true;
+            SEND_RECORD3(MSG_TYPE_ERROR, "Predicted torque %.3f > max torque %.3f for joint %.0f",
+                         tau_predicted(i), tau_max(i), i);
+          }
+          else if((i=firstAboveLimit(i_real, i_max))>=0)
+          {
+            m_emergency_stop_triggered = true;
+            SEND_RECORD3(MSG_TYPE_ERROR, "Joint %.0f measured current is too large: %.3fA > %.3fA",
+                         i, i_real(i), i_max(i));
+          }
+          else if((i=firstAboveLimit(u, ctrl_max))>=0)
+          {
+            m_emergency_stop_triggered = true;
+            SEND_RECORD3(MSG_TYPE_ERROR, "Joint %.0f desired current is too large: %.3fA > %.3fA",
+                         i, u(i), ctrl_max(i));
           }
         }
 
@@ -383,6 +401,8 @@ namespace dynamicgraph
 
         // add the new control mode to the list of available control modes
         m_ctrlModes.push_back(name);
+        m_ctrlModeWeights.conservativeResize(Eigen::NoChange, m_ctrlModes.size());
+        m_ctrlModeWeights.col(m_ctrlModes.size()-1).setZero();
 
         // register the new signals and add the new signal dependecy
 	Eigen::VectorXd::Index i = m_ctrlModes.size()-1;
@@ -444,13 +464,16 @@ namespace dynamicgraph
           // first setting of the control mode
           m_jointCtrlModes_previous[jid] = cm;
           m_jointCtrlModes_current[jid]  = cm;
+          m_nbJointsWithoutCtrlMode--;
         }
         else
         {
           m_jointCtrlModesCountDown[jid] = CTRL_MODE_TRANSITION_TIME_STEP;
           m_jointCtrlModes_previous[jid] = m_jointCtrlModes_current[jid];
           m_jointCtrlModes_current[jid]  = cm;
+          m_nbJointsInTransition++;
         }
+        updateCtrlModeWeights(jid);
       }
 
       void ControlManager::getCtrlMode(const std::string& jointName)
@@ -482,6 +505,11 @@ namespace dynamicgraph
         getLogger().setStreamPrintPeriod(s);
       }
 
+      void ControlManager::setLoggerAsynchronous(const bool & async)
+      {
+        getLogger().setAsynchronous(async);
+      }
+
       void ControlManager::setSleepTime(const double &seconds)
       {
         if(seconds<0.0)
@@ -642,6 +670,18 @@ namespace dynamicgraph
 
       }
 
+      void ControlManager::updateCtrlModeWeights(unsigned int jid)
+      {
+        m_ctrlModeWeights.row(jid).setZero();
+        const int cm_id = m_jointCtrlModes_current[jid].id;
+        if(cm_id<0)
+          return;
+        const double alpha = m_jointCtrlModesCountDown[jid]/CTRL_MODE_TRANSITION_TIME_STEP;
+        if(alpha>0.0)
+          m_ctrlModeWeights(jid, m_jointCtrlModes_previous[jid].id) = alpha;
+        m_ctrlModeWeights(jid, cm_id) = 1.0-alpha;
+      }
+
       bool ControlManager::convertStringToCtrlMode(const std::string& name, CtrlMode& cm)
       {
         // Check if the ctrl mode name exists
@@ -19,6 +19,7 @@
 #include <sot/torque_control/commands-helper.hh>
 #include <sot/torque_control/ddp-actuator-solver.hh>
 #include <Eigen/Dense>
+#include <algorithm>
 
 namespace dynamicgraph
 {
@@ -49,28 +50,66 @@ namespace dynamicgraph
 	  CONSTRUCT_SIGNAL_IN (tau_measure,       dynamicgraph::Vector),
 	  CONSTRUCT_SIGNAL_IN (temp_measure,      dynamicgraph::Vector),
 	  CONSTRUCT_SIGNAL_OUT(tau,               dynamicgraph::Vector, m_pos_desSIN),
-	  m_T(3000),
+	  CONSTRUCT_SIGNAL_OUT(solve_time,        dynamicgraph::Vector, m_tauSOUT),
+	  CONSTRUCT_SIGNAL_OUT(iterations,        dynamicgraph::Vector, m_tauSOUT),
+	  m_maxJointId(-1),
+	  m_nbWorkers(0),
+	  m_poolRound(0),
+	  m_busyWorkers(0),
+	  m_poolAsync(false),
+	  m_stopWorkers(false),
+	  m_nextJoint(0),
+	  m_async(false),
+	  m_stopSolver(false),
+	  m_solverPeriod(1e-3),
+	  m_initSucceeded(false),
 	  m_dt(1e-3),
-	  m_iterMax(100),
+	  m_ambiant_temperature(25.0),
+	  m_T(3000),
 	  m_stopCrit(1e-5),
-	  m_solver(m_model,m_cost,
-		   DISABLE_FULLDDP,
-		   DISABLE_QPBOX)
+	  m_iterMax(100)
       {
 	Entity::signalRegistration( ALL_INPUT_SIGNALS << ALL_OUTPUT_SIGNALS );
 	addCommand("init",
 		   makeCommandVoid4(*this, &DdpActuatorSolver::param_init,
-				    docCommandVoid4("Initialize the DDP solver.",
+				    docCommandVoid4("Initialize the DDP solvers of the joints added with add_joint (joint 0 if none).",
 						    "Control timestep [s].",
 						    "Size of the preview window (in nb of samples)",
 						    "Max. nb. of iterations",
 						    "Stopping criteria")));
+	addCommand("add_joint",
+		   makeCommandVoid4(*this, &DdpActuatorSolver::add_joint,
+				    docCommandVoid4("Control a joint with its own DDP solver, from the next init.",
+						    "Index of the joint (int)",
+						    "Size of the preview window (in nb of samples)",
+						    "Max. nb. of iterations",
+						    "Stopping criteria")));
+	addCommand("start_async",
+		   makeCommandVoid1(*this, &DdpActuatorSolver::start_async,
+				    docCommandVoid1("Solve the DDP in a background thread (receding horizon).",
+						    "Period of the solver thread [s]")));
+	addCommand("stop_async",
+		   makeCommandVoid0(*this, &DdpActuatorSolver::stop_async,
+				    docCommandVoid0("Solve the DDP in the signal tau again.")));
+      }
 
+      DdpActuatorSolver::~DdpActuatorSolver()
+      {
+	stop_async();
+	stopWorkers();
+	for(size_t j=0; j<m_joints.size(); j++)
+	  delete m_joints[j];
       }
 
-      /* --- COMMANDS ---------------------------------------------------------- */
+      /* --- SIGNALS ---------------------------------------------------------- */
       DEFINE_SIGNAL_OUT_FUNCTION(tau, dynamicgraph::Vector)
       {
+	if(!m_initSucceeded)
+	{
+	  SEND_WARNING_STREAM_MSG("Cannot compute signal tau before initialization!");
+	  return s;
+	}
+
 	/// ---- Get the information -----
 	/// Desired position
 	const dynamicgraph::Vector &
@@ -87,44 +126,314 @@ namespace dynamicgraph
 	/// Measured torque
 	const dynamicgraph::Vector &
 	  tau_measure = m_tau_measureSIN(iter);
-	
-	DDPSolver<double,5,1>::stateVec_t xinit,xDes;
 
-	/// --- Initialize solver ---
-	xinit << pos_joint_measure(0),
-	  dx_measure(0),
-	  temp_measure(0),
-	  tau_measure(0),
-	  m_ambiant_temperature;
+	const long n = pos_des.size();
+	if(s.size()!=n)
+	{
+	  s.resize(n);
+	  m_solveTime.resize(n);
+	  m_iterations.resize(n);
+	}
+	s.setZero();
+	m_solveTime.setZero();
+	m_iterations.setZero();
+	if(m_maxJointId>=n || m_maxJointId>=pos_joint_measure.size() ||
+	   m_maxJointId>=dx_measure.size() || m_maxJointId>=temp_measure.size() ||
+	   m_maxJointId>=tau_measure.size())
+	{
+	  SEND_WARNING_STREAM_MSG("Input signals are too small for joint "+toString(m_maxJointId));
+	  return s;
+	}
+
+	/// --- Set the problem of each joint ---
+	for(size_t j=0; j<m_joints.size(); j++)
+	{
+	  JointDdp & joint = *m_joints[j];
+	  const int k = joint.param.jointId;
+	  DdpProblem & problem = m_async ? joint.problems.back() : joint.problem;
+	  problem.xInit << pos_joint_measure(k),
+	    dx_measure(k),
+	    temp_measure(k),
+	    tau_measure(k),
+	    m_ambiant_temperature;
+	  problem.xDes << pos_des(k), 0.0, 0.0, 0.0, 0.0;
+	  problem.iter = iter;
+	  if(m_async)
+	    /// --- Send the problem to the solver thread ---
+	    joint.problems.publish();
+	}
 
-	xDes << m_pos_desSIN(0), 0.0, 0.0, 0.0, 0.0;
+	if(!m_async)
+	  solveAllJoints(false);
+
+	/// --- Get the command of the last solution for this time step ---
+	for(size_t j=0; j<m_joints.size(); j++)
+	{
+	  JointDdp & joint = *m_joints[j];
+	  const int k = joint.param.jointId;
+	  const DdpPlan & plan = m_async ? joint.plans.front() : joint.plan;
+	  if(plan.iter<0)
+	    continue;
+	  const int i = std::min(std::max(iter-plan.iter, 0), (int)plan.u.size()-1);
+	  s(k) = plan.u[i];
+	  m_solveTime(k) = plan.solveTime;
+	  m_iterations(k) = plan.iterations;
+	}
+	return s;
+      }
 
-	m_solver.FirstInitSolver(xinit,xDes,m_T,m_dt,m_iterMax, m_stopCrit);
+      DEFINE_SIGNAL_OUT_FUNCTION(solve_time, dynamicgraph::Vector)
+      {
+	m_tauSOUT(iter);
+	s = m_solveTime;
+	return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(iterations, dynamicgraph::Vector)
+      {
+	m_tauSOUT(iter);
+	s = m_iterations;
+	return s;
+      }
+
+      void DdpActuatorSolver::solve(JointDdp & joint, const DdpProblem & problem, DdpPlan & plan)
+      {
+	const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	StateVector xInit = problem.xInit;
+	StateVector xDes = problem.xDes;
+	joint.solver.initSolver(xInit, xDes);
 
 	/// --- Solve the DDP --- 
-	m_solver.solveTrajectory();
+	joint.solver.solveTrajectory();
 
-	/// --- Get the command ---
-	DDPSolver<double,5,1>::traj lastTraj;
-	lastTraj = m_solver.getLastSolvedTrajectory();
+	/// --- Get the commands ---
+	const DDPSolver<double,5,1>::traj lastTraj = joint.solver.getLastSolvedTrajectory();
+	const unsigned int n = std::min((unsigned int)plan.u.size(), (unsigned int)lastTraj.uList.size());
+	for(unsigned int i=0; i<n; i++)
+	  plan.u[i] = lastTraj.uList[i](0);
+	plan.iter = problem.iter;
+	plan.iterations = lastTraj.iter;
+	plan.solveTime = 1e-6*(boost::posix_time::microsec_clock::universal_time()-start).total_microseconds();
+      }
 
-	DDPSolver<double,5,1>::commandVecTab_t uList;
-	uList = lastTraj.uList;
+      void DdpActuatorSolver::solveAllJoints(const bool async)
+      {
+	{
+	  boost::mutex::scoped_lock lock(m_poolMutex);
+	  m_poolAsync = async;
+	  m_nextJoint = 0;
+	  m_busyWorkers = m_nbWorkers;
+	  m_poolRound++;
+	}
+	m_poolStart.notify_all();
 
-	s = uList[0];
-	return s;
+	// the calling thread solves joints too, rather than only waiting
+	solveNextJoints();
+
+	boost::mutex::scoped_lock lock(m_poolMutex);
+	while(m_busyWorkers>0)
+	  m_poolDone.wait(lock);
       }
 
+      void DdpActuatorSolver::solveNextJoints()
+      {
+	for(int j=m_nextJoint++; j<(int)m_joints.size(); j=m_nextJoint++)
+	{
+	  JointDdp & joint = *m_joints[j];
+	  if(!m_poolAsync)
+	    solve(joint, joint.problem, joint.plan);
+	  else if(joint.problems.hasNewValue())
+	  {
+	    solve(joint, joint.problems.front(), joint.plans.back());
+	    joint.plans.publish();
+	  }
+	}
+      }
+
+      void DdpActuatorSolver::runWorker(unsigned int round)
+      {
+	while(true)
+	{
+	  {
+	    boost::mutex::scoped_lock lock(m_poolMutex);
+	    while(m_poolRound==round && !m_stopWorkers)
+	      m_poolStart.wait(lock);
+	    if(m_stopWorkers)
+	      return;
+	    round = m_poolRound;
+	  }
+
+	  solveNextJoints();
+
+	  boost::mutex::scoped_lock lock(m_poolMutex);
+	  if(--m_busyWorkers==0)
+	    m_poolDone.notify_one();
+	}
+      }
+
+      void DdpActuatorSolver::startWorkers()
+      {
+	// the thread calling solveAllJoints is the first worker of the pool
+	const int nbCores = std::max(1, (int) boost::thread::hardware_concurrency());
+	m_nbWorkers = std::min(nbCores, (int) m_joints.size()) - 1;
+	// m_poolRound is not reset by init: the workers wait for the next round
+	unsigned int round;
+	{
+	  boost::mutex::scoped_lock lock(m_poolMutex);
+	  m_stopWorkers = false;
+	  round = m_poolRound;
+	}
+	for(int i=0; i<m_nbWorkers; i++)
+	  m_workers.create_thread(boost::bind(&DdpActuatorSolver::runWorker, this, round));
+      }
+
+      void DdpActuatorSolver::stopWorkers()
+      {
+	{
+	  boost::mutex::scoped_lock lock(m_poolMutex);
+	  m_stopWorkers = true;
+	}
+	m_poolStart.notify_all();
+	m_workers.join_all();
+	m_nbWorkers = 0;
+      }
+
+      void DdpActuatorSolver::runSolver()
+      {
+	while(!m_stopSolver)
+	{
+	  const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	  solveAllJoints(true);
+	  const boost::posix_time::time_duration elapsed =
+	    boost::posix_time::microsec_clock::universal_time() - start;
+	  const long wait_us = (long)(1e6*m_solverPeriod) - elapsed.total_microseconds();
+	  if(wait_us>0)
+	    boost::this_thread::sleep(boost::posix_time::microseconds(wait_us));
+	}
+      }
+
+      /* --- COMMANDS ---------------------------------------------------------- */
       void DdpActuatorSolver::
       param_init(const double &timestep,
 		 const int &T,
 		 const int &nbItMax,
 		 const double &stopCriteria)
       {
+	if(timestep<=0.0)
+	  return SEND_MSG("Init failed: timestep must be positive", MSG_TYPE_ERROR);
+	if(T<=0)
+	  return SEND_MSG("Init failed: the size of the preview window must be positive", MSG_TYPE_ERROR);
+	stop_async();
+	stopWorkers();
+	m_initSucceeded = false;
+
 	m_T = T;
 	m_dt = timestep;
 	m_iterMax = nbItMax;
 	m_stopCrit = stopCriteria;
+
+	std::vector<JointParameters> params = m_jointParameters;
+	if(params.empty())
+	{
+	  JointParameters p = {0, m_T, m_iterMax, m_stopCrit};
+	  params.push_back(p);
+	}
+
+	for(size_t j=0; j<m_joints.size(); j++)
+	  delete m_joints[j];
+	m_joints.clear();
+	m_maxJointId = -1;
+
+	DdpProblem problem;
+	problem.xInit.setZero();
+	problem.xDes.setZero();
+	problem.iter = -1;
+	for(size_t j=0; j<params.size(); j++)
+	{
+	  JointDdp * joint = new JointDdp(params[j]);
+	  /// The trajectories of the solver are allocated once here, then
+	  /// initSolver only sets the initial and desired states
+	  StateVector xInit = problem.xInit, xDes = problem.xDes;
+	  joint->solver.FirstInitSolver(xInit, xDes, joint->param.T, m_dt,
+					joint->param.iterMax, joint->param.stopCrit);
+	  joint->problem = problem;
+	  joint->plan.iter = -1;
+	  joint->plan.u.assign(joint->param.T, 0.0);
+	  joint->plan.solveTime = 0.0;
+	  joint->plan.iterations = 0;
+	  joint->problems.reset(problem);
+	  joint->plans.reset(joint->plan);
+	  m_joints.push_back(joint);
+	  m_maxJointId = std::max(m_maxJointId, joint->param.jointId);
+	}
+
+	startWorkers();
+	m_initSucceeded = true;
+	SEND_MSG("Initialized the DDP of "+toString(m_joints.size())+" joints, solved on "+
+		 toString(m_nbWorkers+1)+" threads", MSG_TYPE_INFO);
+      }
+
+      void DdpActuatorSolver::add_joint(const int &jointId,
+					const int &T,
+					const int &nbItMax,
+					const double &stopCriteria)
+      {
+	if(jointId<0)
+	  return SEND_MSG("The index of the joint must be non negative", MSG_TYPE_ERROR);
+	if(T<=0)
+	  return SEND_MSG("The size of the preview window must be positive", MSG_TYPE_ERROR);
+	for(size_t j=0; j<m_jointParameters.size(); j++)
+	  if(m_jointParameters[j].jointId==jointId)
+	    return SEND_MSG("Joint "+toString(jointId)+" has already been added", MSG_TYPE_ERROR);
+	JointParameters p = {jointId, (unsigned int)T, (unsigned int)nbItMax, stopCriteria};
+	m_jointParameters.push_back(p);
+	if(m_initSucceeded)
+	  SEND_MSG("Joint "+toString(jointId)+" will be controlled after the next init", MSG_TYPE_INFO);
+      }
+
+      void DdpActuatorSolver::start_async(const double &period)
+      {
+	if(!m_initSucceeded)
+	  return SEND_MSG("Cannot start the solver thread before initialization", MSG_TYPE_ERROR);
+	if(period<=0.0)
+	  return SEND_MSG("The period of the solver thread must be positive", MSG_TYPE_ERROR);
+	stop_async();
+	m_solverPeriod = period;
+	// forget the problems and solutions of a previous run
+	for(size_t j=0; j<m_joints.size(); j++)
+	{
+	  JointDdp & joint = *m_joints[j];
+	  DdpProblem problem = joint.problem;
+	  problem.iter = -1;
+	  joint.problems.reset(problem);
+	  DdpPlan plan = joint.plan;
+	  plan.iter = -1;
+	  joint.plans.reset(plan);
+	}
+	m_stopSolver = false;
+	m_async = true;
+	m_thread = boost::thread(boost::bind(&DdpActuatorSolver::runSolver, this));
+      }
+
+      void DdpActuatorSolver::stop_async()
+      {
+	if(!m_async)
+	  return;
+	// tau keeps reading the solutions of the thread until it has stopped
+	m_stopSolver = true;
+	m_thread.join();
+	m_async = false;
+      }
+
+      void DdpActuatorSolver::display(std::ostream &os) const
+      {
+	os << "DdpActuatorSolver "<<getName()<<": "<<m_joints.size()<<" joints solved on "
+	   <<m_nbWorkers+1<<" threads, time step "<<m_dt<<" s, solved "
+	   <<(m_async ? "in background every "+toString(m_solverPeriod)+" s" : "at each time step")
+	   <<"\n";
+	for(size_t j=0; j<m_joints.size(); j++)
+	  os << "  joint "<<m_joints[j]->param.jointId<<": horizon "<<m_joints[j]->param.T
+	     <<" time steps, "<<m_joints[j]->param.iterMax<<" iterations max\n";
       }
       
     } // namespace torque_control
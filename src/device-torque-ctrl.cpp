@@ -62,7 +62,8 @@ DeviceTorqueCtrl::DeviceTorqueCtrl(std::string RobotName):
   CONSTRUCT_SIGNAL_IN(kp_constraints,              dynamicgraph::Vector),
   CONSTRUCT_SIGNAL_IN(kd_constraints,              dynamicgraph::Vector),
   CONSTRUCT_SIGNAL_IN(rotor_inertias,              dynamicgraph::Vector),
-  CONSTRUCT_SIGNAL_IN(gear_ratios,                 dynamicgraph::Vector)
+  CONSTRUCT_SIGNAL_IN(gear_ratios,                 dynamicgraph::Vector),
+  m_fdSolver(FD_SOLVER_SVD)
 {
   forcesSIN_[0] = new SignalPtr<dynamicgraph::Vector, int>(NULL, "DeviceTorqueCtrl::input(vector6)::inputForceRLEG");
   forcesSIN_[1] = new SignalPtr<dynamicgraph::Vector, int>(NULL, "DeviceTorqueCtrl::input(vector6)::inputForceLLEG");
@@ -107,6 +108,10 @@ DeviceTorqueCtrl::DeviceTorqueCtrl(std::string RobotName):
               "\n      take one floating point number as input\n\n";
   addCommand("increment", makeCommandVoid1((Device&)*this,
                                            &Device::increment, docstring));
+  addCommand("setForwardDynamicsSolver",
+             makeCommandVoid1(*this, &DeviceTorqueCtrl::setForwardDynamicsSolver,
+                              docCommandVoid1("Set the solver of the constrained forward dynamics: svd (default) or cholesky, which is faster.",
+                                              "Solver name (string)")));
   addCommand("init",
              makeCommandVoid2(*this, &DeviceTorqueCtrl::init,
                               docCommandVoid2("Initialize the entity.",
@@ -142,9 +147,8 @@ void DeviceTorqueCtrl::init(const double& dt, const std::string& robotRef)
 
   try
   {
-    vector<string> package_dirs;
-    m_robot = new robots::RobotWrapper(urdfFile, 
-				      package_dirs, se3::JointModelFreeFlyer());
+    // copy of the shared model, because the rotor inertias and gear ratios are set below
+    m_robot = new robots::RobotWrapper(getRobotModel(urdfFile, ROOT_JOINT_FREE_FLYER));
     m_data = new se3::Data(m_robot->model());
     m_robot->rotor_inertias(rotor_inertias);
     m_robot->gear_ratios(gear_ratios);
@@ -164,6 +168,8 @@ void DeviceTorqueCtrl::init(const double& dt, const std::string& robotRef)
     m_f.setZero(m_nk);
     m_Jc.setZero(m_nk, m_robot->nv());
     m_dJcv.setZero(m_nk);
+    m_Minv_JcT.setZero(m_robot->nv(), m_nk);
+    m_JMinvJcT.setZero(m_nk, m_nk);
 
     m_contactRF = new TaskSE3Equality("contact_rfoot", *m_robot,
                                       m_robot_util->m_foot_util.m_Right_Foot_Frame_Name);
@@ -253,6 +259,16 @@ void DeviceTorqueCtrl::setControlInputType(const std::string& cit)
   return Device::setControlInputType(cit);
 }
 
+void DeviceTorqueCtrl::setForwardDynamicsSolver(const std::string& solver)
+{
+  if(solver=="svd")
+    m_fdSolver = FD_SOLVER_SVD;
+  else if(solver=="cholesky")
+    m_fdSolver = FD_SOLVER_CHOLESKY;
+  else
+    SEND_MSG("Unknown forward dynamics solver "+solver+", use svd or cholesky", MSG_TYPE_ERROR);
+}
+
 void DeviceTorqueCtrl::computeForwardDynamics()
 {
   const Vector & tauDes = controlSIN.accessCopy();
@@ -270,10 +286,47 @@ void DeviceTorqueCtrl::computeForwardDynamics()
   assert(m_K.rows()==m_nj+6+12 && m_K.cols()==m_nj+6+12);
   m_Jc.topRows<6>()                       = constrRF.matrix();
   m_Jc.bottomRows<6>()                    = constrLF.matrix();
-  Matrix JcT = m_Jc.transpose();
   m_dJcv.head<6>()                        = constrRF.vector();
   m_dJcv.tail<6>()                        = constrLF.vector();
 
+  const Matrix & M = m_robot->mass(*m_data);
+  const Vector & h = m_robot->nonLinearEffects(*m_data);
+  m_robot_util->joints_sot_to_urdf(tauDes, m_tau_np6.tail(m_nj));
+
+  if(m_fdSolver==FD_SOLVER_CHOLESKY)
+    computeForwardDynamicsCholesky(M, h);
+  else
+    computeForwardDynamicsSvd(M, h);
+}
+
+void DeviceTorqueCtrl::computeForwardDynamicsCholesky(const Matrix& M, const Vector& h)
+{
+  // The dynamics M*dv + h - Jc^T*f = tau and the constraint Jc*dv = dJcv are
+  // solved with the Schur complement of M:
+  //   (Jc*M^{-1}*Jc^T)*f = dJcv - Jc*M^{-1}*(tau-h)
+  //   dv = M^{-1}*(tau - h + Jc^T*f)
+  // which only needs the Cholesky decompositions of M and of a matrix of the
+  // size of the contact forces, and does not allocate memory.
+  m_M_chol.compute(M);
+  m_dv = m_tau_np6 - h;
+  m_M_chol.solveInPlace(m_dv);
+  m_Minv_JcT = m_Jc.transpose();
+  m_M_chol.solveInPlace(m_Minv_JcT);
+
+  m_JMinvJcT.noalias() = m_Jc*m_Minv_JcT;
+  m_JMinvJcT.diagonal().array() += m_numericalDamping*m_numericalDamping;
+  m_JMinvJcT_chol.compute(m_JMinvJcT);
+  m_f = m_dJcv;
+  m_f.noalias() -= m_Jc*m_dv;
+  m_JMinvJcT_chol.solveInPlace(m_f);
+
+  m_dv.noalias() += m_Minv_JcT*m_f;
+}
+
+void DeviceTorqueCtrl::computeForwardDynamicsSvd(const Matrix& M, const Vector& h)
+{
+  Matrix JcT = m_Jc.transpose();
+
   // compute constraint solution: ddqBar = - Jc^+ * dJc * dq
   m_Jc_svd.compute(m_Jc, Eigen::ComputeThinU | Eigen::ComputeFullV);
   tsid::math::solveWithDampingFromSvd(m_Jc_svd, m_dJcv,
@@ -284,10 +337,7 @@ void DeviceTorqueCtrl::computeForwardDynamics()
   m_Z = m_Jc_svd.matrixV().rightCols(m_nj+6-r);
 
   // compute constrained accelerations ddq_c = (Z^T*M*Z)^{-1}*Z^T*(S^T*tau - h - M*ddqBar)
-  const Matrix & M = m_robot->mass(*m_data);
-  const Vector & h = m_robot->nonLinearEffects(*m_data);
   m_ZMZ = m_Z.transpose()*M*m_Z;
-  m_robot_util->joints_sot_to_urdf(tauDes, m_tau_np6.tail(m_nj));
   m_dv_c = m_Z.transpose()*(m_tau_np6 - h - M*m_dvBar);
   Vector rhs = m_dv_c;
 //  m_ZMZ_chol.compute(m_ZMZ);
@@ -341,8 +391,7 @@ void DeviceTorqueCtrl::integrate( const double & dt )
     m_v += dt*m_dv;
 
     m_robot_util->config_urdf_to_sot(m_q, m_q_sot);
-    m_robot_util->velocity_urdf_to_sot(m_q, m_v, m_v_sot);
-    m_robot_util->velocity_urdf_to_sot(m_q, m_dv, m_dv_sot);
+    m_robot_util->velocity_urdf_to_sot(m_q, m_v, m_dv, m_v_sot, m_dv_sot);
 
     state_                = m_q_sot;
     velocity_             = m_v_sot;
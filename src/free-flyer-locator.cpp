@@ -37,11 +37,15 @@ namespace dynamicgraph
 
       typedef Eigen::Vector6d Vector6;
 
-#define PROFILE_FREE_FLYER_COMPUTATION          "Free-flyer position computation"
-#define PROFILE_FREE_FLYER_VELOCITY_COMPUTATION "Free-flyer velocity computation"
+      /// Sections published by the signals latency and deadline_misses, profiled
+      /// as "<entity name>: <section name>" so that the instances do not mix.
+      /// They are computed by different signals, so each one has its own deadline.
+      enum ProfileSection { PROFILE_FREE_FLYER_COMPUTATION, PROFILE_FREE_FLYER_VELOCITY_COMPUTATION, N_PROFILE_SECTIONS };
+      static const char* PROFILE_SECTION_NAMES[N_PROFILE_SECTIONS] = { "position computation", "velocity computation" };
 
 #define INPUT_SIGNALS     m_base6d_encodersSIN << m_joint_velocitiesSIN
-#define OUTPUT_SIGNALS    m_base6dFromFoot_encodersSOUT << m_freeflyer_aaSOUT << m_vSOUT
+#define OUTPUT_SIGNALS    m_base6dFromFoot_encodersSOUT << m_freeflyer_aaSOUT << m_vSOUT << \
+                          m_latencySOUT << m_deadline_missesSOUT
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -63,13 +67,19 @@ namespace dynamicgraph
             ,CONSTRUCT_SIGNAL_OUT(base6dFromFoot_encoders,    dynamicgraph::Vector, m_kinematics_computationsSINNER)
             ,CONSTRUCT_SIGNAL_OUT(freeflyer_aa,               dynamicgraph::Vector, m_base6dFromFoot_encodersSOUT)
             ,CONSTRUCT_SIGNAL_OUT(v,                          dynamicgraph::Vector, m_kinematics_computationsSINNER)
+            ,CONSTRUCT_SIGNAL_OUT(latency,                    dynamicgraph::Vector, m_base6dFromFoot_encodersSOUT << m_vSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(deadline_misses,            dynamicgraph::Vector, m_base6dFromFoot_encodersSOUT << m_vSOUT)
 	    ,m_initSucceeded(false)
+	    ,m_kinematics(0)
 	    ,m_model(0)
     	    ,m_data(0)
 	    ,m_robot_util(RefVoidRobotUtil())
       {
         Entity::signalRegistration( INPUT_SIGNALS << OUTPUT_SIGNALS );
 
+        for(int i=0; i<N_PROFILE_SECTIONS; i++)
+          m_profileSections.push_back(getProfiler().get_id(name+": "+PROFILE_SECTION_NAMES[i]));
+
         /* Commands. */
         addCommand("init",
                    makeCommandVoid1(*this, &FreeFlyerLocator::init,
@@ -80,13 +90,16 @@ namespace dynamicgraph
                    makeCommandVoid0(*this, &FreeFlyerLocator::displayRobotUtil,
                                     docCommandVoid0("Display the robot util data set linked with this free flyer locator.")));
 
+        addCommand("setDeadline",
+                   makeCommandVoid1(*this, &FreeFlyerLocator::setDeadline,
+                                    docCommandVoid1("Set the maximum computation time of the profiled sections (position and velocity computation), used to count their deadline misses (disabled by default).",
+                                                    "Deadline in seconds of each section, 0 for none (vector)")));
+
       }
       FreeFlyerLocator::~FreeFlyerLocator()
       {
-	if (m_model)
-	  delete m_model;
-	if (m_data)
-	  delete m_data;
+	if (m_kinematics)
+	  m_kinematics->removeClient(m_kinematicsClient);
       }
 
       void FreeFlyerLocator::init(const std::string& robotRef)
@@ -106,11 +119,9 @@ namespace dynamicgraph
 	      return;
 	    }
 
-	  m_model = new se3::Model();
-	  m_model->name.assign("EmptyRobot");
-
-          se3::urdf::buildModel(m_robot_util->m_urdf_filename,
-				se3::JointModelFreeFlyer(),*m_model);
+          m_kinematics = getKinematicsCache(localName, m_robot_util->m_urdf_filename);
+          m_kinematicsClient = m_kinematics->addClient();
+          m_model = &m_kinematics->model();
 	  assert(m_model->nv == m_robot_util->m_nbJoints+6);
           assert(m_model->existFrame(m_robot_util->m_foot_util.m_Left_Foot_Frame_Name));
           assert(m_model->existFrame(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name));
@@ -127,7 +138,8 @@ namespace dynamicgraph
           std::cout << e.what();
           return SEND_MSG("Init failed: Could load URDF :" + m_robot_util->m_urdf_filename, MSG_TYPE_ERROR);
         }
-        m_data = new se3::Data(*m_model);
+        m_data = &m_kinematics->compute(m_kinematicsClient, m_q_pin, m_v_pin,
+                                        KinematicsCache::VELOCITIES | KinematicsCache::FRAMES);
         m_initSucceeded = true;
       }
 
@@ -155,8 +167,8 @@ namespace dynamicgraph
         m_robot_util->joints_sot_to_urdf(dq, m_v_pin.tail(m_robot_util->m_nbJoints));
 
         /* Compute kinematic and return q with freeflyer */
-        se3::forwardKinematics(*m_model, *m_data, m_q_pin, m_v_pin);
-        se3::framesForwardKinematics(*m_model, *m_data);
+        m_data = &m_kinematics->compute(m_kinematicsClient, m_q_pin, m_v_pin,
+                                        KinematicsCache::VELOCITIES | KinematicsCache::FRAMES);
 
         return s;
       }
@@ -173,7 +185,7 @@ namespace dynamicgraph
         
         m_kinematics_computationsSINNER(iter);
 
-        getProfiler().start(PROFILE_FREE_FLYER_COMPUTATION);
+        getProfiler().start(m_profileSections[PROFILE_FREE_FLYER_COMPUTATION]);
         {
           const Eigen::VectorXd& q= m_base6d_encodersSIN(iter);     //n+6
           assert(q.size()==m_robot_util->m_nbJoints+6     && "Unexpected size of signal base6d_encoder");
@@ -195,7 +207,7 @@ namespace dynamicgraph
 
           s = m_q_sot;
         }
-        getProfiler().stop(PROFILE_FREE_FLYER_COMPUTATION);
+        getProfiler().stop(m_profileSections[PROFILE_FREE_FLYER_COMPUTATION]);
 
         return s;
       }
@@ -237,7 +249,7 @@ namespace dynamicgraph
 
         m_kinematics_computationsSINNER(iter);
 
-        getProfiler().start(PROFILE_FREE_FLYER_VELOCITY_COMPUTATION);
+        getProfiler().start(m_profileSections[PROFILE_FREE_FLYER_VELOCITY_COMPUTATION]);
         {
           const Eigen::VectorXd& dq= m_joint_velocitiesSIN(iter);
           assert(dq.size()==m_robot_util->m_nbJoints     && "Unexpected size of signal joint_velocities");
@@ -256,8 +268,24 @@ namespace dynamicgraph
 
           s = m_v_sot;
         }
-        getProfiler().stop(PROFILE_FREE_FLYER_VELOCITY_COMPUTATION);
+        getProfiler().stop(m_profileSections[PROFILE_FREE_FLYER_VELOCITY_COMPUTATION]);
+
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(latency,dynamicgraph::Vector)
+      {
+        m_base6dFromFoot_encodersSOUT(iter);
+        m_vSOUT(iter);
+        getProfiler().get_latencies(&m_profileSections[0], N_PROFILE_SECTIONS, s);
+        return s;
+      }
 
+      DEFINE_SIGNAL_OUT_FUNCTION(deadline_misses,dynamicgraph::Vector)
+      {
+        m_base6dFromFoot_encodersSOUT(iter);
+        m_vSOUT(iter);
+        getProfiler().get_deadline_misses(&m_profileSections[0], N_PROFILE_SECTIONS, s);
         return s;
       }
 
@@ -267,6 +295,14 @@ namespace dynamicgraph
 	m_robot_util->display(std::cout);
       }
 
+      void FreeFlyerLocator::setDeadline(const dynamicgraph::Vector& deadlines)
+      {
+        if(deadlines.size()!=N_PROFILE_SECTIONS)
+          return SEND_MSG("The deadlines must be a vector of size "+toString(N_PROFILE_SECTIONS), MSG_TYPE_ERROR);
+        for(int i=0; i<N_PROFILE_SECTIONS; i++)
+          getProfiler().set_deadline(m_profileSections[i], deadlines(i));
+      }
+
       /* ------------------------------------------------------------------- */
       /* --- ENTITY -------------------------------------------------------- */
       /* ------------------------------------------------------------------- */
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <sot/torque_control/utils/hqp-solver-bank.hh>
+#include <sot/torque_control/utils/hqp-fixed-sizes.hh>  // generated by CMake
+#include <tsid/solvers/solver-HQP-eiquadprog.hpp>
+#include <tsid/solvers/solver-HQP-eiquadprog-rt.hpp>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      using namespace tsid::solvers;
+
+      HqpSolverBank::HqpSolverBank()
+        : m_dynamicSize(NULL)
+      {}
+
+      HqpSolverBank::~HqpSolverBank()
+      {
+        clear();
+      }
+
+      void HqpSolverBank::init(const std::string & name, unsigned int nVar, unsigned int nEq, unsigned int nIn)
+      {
+        clear();
+        m_name = name;
+        m_dynamicSize = SolverHQPFactory::createNewSolver(SOLVER_HQP_EIQUADPROG_FAST, name);
+        m_dynamicSize->resize(nVar, nEq, nIn);
+
+#define HQP_FIXED_SIZE(n, neq, nin) addFixedSize<n, neq, nin>();
+        HQP_FIXED_SIZES
+#undef HQP_FIXED_SIZE
+      }
+
+      void HqpSolverBank::setMaximumIterations(unsigned int maxIter)
+      {
+        if(m_dynamicSize!=NULL)
+          m_dynamicSize->setMaximumIterations(maxIter);
+        for(std::size_t i=0; i<m_solvers.size(); i++)
+          m_solvers[i].solver->setMaximumIterations(maxIter);
+      }
+
+      void HqpSolverBank::clear()
+      {
+        delete m_dynamicSize;
+        m_dynamicSize = NULL;
+        for(std::size_t i=0; i<m_solvers.size(); i++)
+          delete m_solvers[i].solver;
+        m_solvers.clear();
+      }
+
+      void HqpSolverBank::reserve(unsigned int nVar, unsigned int nEq, unsigned int nIn)
+      {
+        if(findSolver(nVar, nEq, nIn)!=NULL)
+          return;
+        SolverHQPBase * solver = SolverHQPFactory::createNewSolver(SOLVER_HQP_EIQUADPROG_FAST,
+                                                                   sizeName(m_name, nVar, nEq, nIn));
+        solver->resize(nVar, nEq, nIn);
+        Entry e = {nVar, nEq, nIn, solver, false};
+        m_solvers.push_back(e);
+      }
+
+      std::string HqpSolverBank::sizeName(const std::string & prefix, unsigned int nVar, unsigned int nEq, unsigned int nIn)
+      {
+        std::ostringstream ss;
+        ss<<prefix<<"_"<<nVar<<"_"<<nEq<<"_"<<nIn;
+        return ss.str();
+      }
+
+    } // namespace torque_control
+  } // namespace sot
+} // namespace dynamicgraph
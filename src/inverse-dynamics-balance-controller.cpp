@@ -22,8 +22,9 @@
 
 #include <sot/torque_control/commands-helper.hh>
 
-#include <tsid/utils/stop-watch.hpp>
-#include <tsid/utils/statistics.hpp>
+#include <sot/torque_control/utils/stop-watch.hh>
+#include <sot/torque_control/utils/statistics.hh>
+#include <sot/torque_control/utils/malloc-guard.hh>
 #include <tsid/solvers/solver-HQP-factory.hxx>
 #include <tsid/solvers/solver-HQP-eiquadprog.hpp>
 #include <tsid/solvers/solver-HQP-eiquadprog-rt.hpp>
@@ -55,13 +56,22 @@ namespace dynamicgraph
       
 #define REQUIRE_FINITE(A) assert(is_finite(A))
 
-      //Size to be aligned                "-------------------------------------------------------"
-#define PROFILE_TAU_DES_COMPUTATION "InvDynBalCtrl: desired tau"
-#define PROFILE_HQP_SOLUTION        "InvDynBalCtrl: HQP"
-#define PROFILE_PREPARE_INV_DYN     "InvDynBalCtrl: prepare inv-dyn"
-#define PROFILE_READ_INPUT_SIGNALS  "InvDynBalCtrl: read input signals"
+      /// Sections published by the signals latency and deadline_misses, profiled
+      /// as "<entity name>: <section name>" so that the instances do not mix.
+      /// The first section contains the others and is the one with a deadline.
+      enum ProfileSection { PROFILE_TAU_DES_COMPUTATION, PROFILE_READ_INPUT_SIGNALS,
+                            PROFILE_PREPARE_INV_DYN, PROFILE_HQP_SOLUTION, N_PROFILE_SECTIONS };
+      static const char* PROFILE_SECTION_NAMES[N_PROFILE_SECTIONS] = { "desired tau", "read input signals",
+                                                                       "prepare inv-dyn", "HQP" };
 
 #define ZERO_FORCE_THRESHOLD 1e-3
+/// weight of the task of the joints that are not controlled (see active_joints_checked)
+#define BLOCKED_JOINTS_TASK_WEIGHT 1e3
+/// Margin between the min and max normal forces of a contact at the end of its removal
+#define CONTACT_TRANSITION_FORCE_MARGIN 1e-3
+/// Decay per solution of the estimate of the time of an iteration of the HQP
+/// solvers, which follows the peaks of the measures and forgets them slowly
+#define SOLVER_ITERATION_TIME_DECAY 0.99
 
 #define INPUT_SIGNALS         m_com_ref_posSIN \
   << m_com_ref_velSIN \
@@ -147,7 +157,11 @@ namespace dynamicgraph
   << m_right_foot_acc_desSOUT \
   << m_left_foot_acc_desSOUT \
   << m_dv_desSOUT \
-  << m_MSOUT
+  << m_MSOUT \
+  << m_latencySOUT \
+  << m_deadline_missesSOUT \
+  << m_hqp_failuresSOUT \
+  << m_fallback_levelSOUT
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -255,6 +269,10 @@ namespace dynamicgraph
             ,CONSTRUCT_SIGNAL_OUT(right_foot_acc,             dg::Vector, m_tau_desSOUT)
             ,CONSTRUCT_SIGNAL_OUT(left_foot_acc_des,          dg::Vector, m_tau_desSOUT)
             ,CONSTRUCT_SIGNAL_OUT(right_foot_acc_des,         dg::Vector, m_tau_desSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(latency,                    dg::Vector, m_tau_desSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(deadline_misses,            dg::Vector, m_tau_desSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(hqp_failures,               dg::Vector, m_tau_desSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(fallback_level,             dg::Vector, m_tau_desSOUT)
             ,CONSTRUCT_SIGNAL_INNER(active_joints_checked,    dg::Vector, m_active_jointsSIN)
             ,m_initSucceeded(false)
             ,m_enabled(false)
@@ -262,10 +280,30 @@ namespace dynamicgraph
             ,m_firstTime(true)
             ,m_timeLast(0)
             ,m_contactState(DOUBLE_SUPPORT)
+            ,m_contactTransitionDuration(0.0)
+            ,m_contactPhase(PHASE_DOUBLE_SUPPORT)
+            ,m_useWarmStart(false)
+            ,m_rtMode(false)
+            ,m_hqpFailures(0)
+            ,m_hqpStatusLast(HQP_STATUS_OPTIMAL)
+            ,m_timeErrors(0)
+            ,m_fallbackLevel(FALLBACK_NONE)
+            ,m_fallbackTicks(0)
+            ,m_maxExtrapolationTicks(5)
+            ,m_maxSolveTime(0.0)
+            ,m_maxSolverIterations(0)
+            ,m_defaultSolverIterations(0)
+            ,m_iterationTime(0.0)
+            ,m_tickStartNs(0)
+            ,m_hqpSolved(false)
+            ,m_hqpSolverLast(NULL)
 	    ,m_robot_util(RefVoidRobotUtil())
       {
         Entity::signalRegistration( INPUT_SIGNALS << OUTPUT_SIGNALS );
 
+        for(int i=0; i<N_PROFILE_SECTIONS; i++)
+          m_profileSections.push_back(getProfiler().get_id(name+": "+PROFILE_SECTION_NAMES[i]));
+
         m_zmp_des_RF.setZero();
         m_zmp_des_LF.setZero();
         m_zmp_des_RF_local.setZero();
@@ -277,6 +315,8 @@ namespace dynamicgraph
         m_com_offset.setZero();
         m_v_RF_int.setZero();
         m_v_LF_int.setZero();
+        for(int i=0; i<4; i++)
+          m_fallbacks[i] = 0;
 
         /* Commands. */
         addCommand("init",
@@ -299,6 +339,32 @@ namespace dynamicgraph
                                     docCommandVoid1("Remove the contact at the left foot.",
                                                     "Transition time in seconds (double)")));
 
+        addCommand("setWarmStart",
+                   makeCommandVoid1(*this, &InverseDynamicsBalanceController::setWarmStart,
+                                    docCommandVoid1("Enable/disable the warm start of the HQP solver with the active set of the previous iteration.",
+                                                    "Warm start flag (bool)")));
+
+        addCommand("setRealTimeMode",
+                   makeCommandVoid1(*this, &InverseDynamicsBalanceController::setRealTimeMode,
+                                    docCommandVoid1("In real-time mode tau_des does not allocate memory: statistics and messages are disabled and errors are only counted (print this entity to see them).",
+                                                    "Real-time mode flag (bool)")));
+
+        addCommand("setDeadline",
+                   makeCommandVoid1(*this, &InverseDynamicsBalanceController::setDeadline,
+                                    docCommandVoid1("Set the maximum computation time of tau_des, used to count its deadline misses (the control period by default).",
+                                                    "Deadline in seconds (double)")));
+
+        addCommand("setSolverBudget",
+                   makeCommandVoid2(*this, &InverseDynamicsBalanceController::setSolverBudget,
+                                    docCommandVoid2("Set the budget of the HQP: the solvers are limited to the iterations that fit in the time left before the max time since the start of tau_des (estimated from the last solutions). If none fit, or a solver reaches its limit, tau_des is computed by a fallback (see fallback_level).",
+                                                    "Max time in seconds, 0 for no limit (double)",
+                                                    "Max number of iterations of the HQP solvers, 0 to keep their default (int)")));
+
+        addCommand("setMaxExtrapolation",
+                   makeCommandVoid1(*this, &InverseDynamicsBalanceController::setMaxExtrapolation,
+                                    docCommandVoid1("Set the max number of consecutive ticks for which tau_des can be extrapolated from the last HQP solutions, before solving the reduced HQP.",
+                                                    "Number of ticks (int)")));
+
 	
       }
 
@@ -312,72 +378,113 @@ namespace dynamicgraph
 
       void InverseDynamicsBalanceController::removeRightFootContact(const double& transitionTime)
       {
-        if(m_contactState == DOUBLE_SUPPORT)
-        {
+        if(removeContact(LEFT_SUPPORT, transitionTime))
           SEND_MSG("Remove right foot contact in "+toString(transitionTime)+" s", MSG_TYPE_INFO);
-          bool res = m_invDyn->removeRigidContact(m_contactRF->name(), transitionTime);
-          if(!res)
-          {
-            const HQPData & hqpData = m_invDyn->computeProblemData(m_t, m_q_urdf, m_v_urdf);
-            SEND_MSG("Error while remove right foot contact."+tsid::solvers::HQPDataToString(hqpData, false), MSG_TYPE_ERROR);
-          }
-          const double & w_feet = m_w_feetSIN.accessCopy();
-          m_invDyn->addMotionTask(*m_taskRF, w_feet, 1);
-          if(transitionTime>m_dt)
-          {
-            m_contactState = LEFT_SUPPORT_TRANSITION;
-            m_contactTransitionTime = m_t + transitionTime;
-          }
-          else
-            m_contactState = LEFT_SUPPORT;
-        }
       }
 
       void InverseDynamicsBalanceController::removeLeftFootContact(const double& transitionTime)
       {
-        if(m_contactState == DOUBLE_SUPPORT)
-        {
+        if(removeContact(RIGHT_SUPPORT, transitionTime))
           SEND_MSG("Remove left foot contact in "+toString(transitionTime)+" s", MSG_TYPE_INFO);
-          bool res = m_invDyn->removeRigidContact(m_contactLF->name(), transitionTime);
-          if(!res)
-          {
-            const HQPData & hqpData = m_invDyn->computeProblemData(m_t, m_q_urdf, m_v_urdf);
-            SEND_MSG("Error while remove right foot contact."+tsid::solvers::HQPDataToString(hqpData, false), MSG_TYPE_ERROR);
-          }
-          const double & w_feet = m_w_feetSIN.accessCopy();
-          m_invDyn->addMotionTask(*m_taskLF, w_feet, 1);
-          if(transitionTime>m_dt)
-          {
-            m_contactState = RIGHT_SUPPORT_TRANSITION;
-            m_contactTransitionTime = m_t + transitionTime;
-          }
-          else
-            m_contactState = RIGHT_SUPPORT;
-        }
       }
 
-      void InverseDynamicsBalanceController::addRightFootContact(const double& transitionTime)
+      void InverseDynamicsBalanceController::addRightFootContact(const double& /*transitionTime*/)
       {
-        if(m_contactState == LEFT_SUPPORT)
+        if(addContact(LEFT_SUPPORT))
+          SEND_MSG("Add right foot contact", MSG_TYPE_INFO);
+      }
+
+      void InverseDynamicsBalanceController::addLeftFootContact(const double& /*transitionTime*/)
+      {
+        if(addContact(RIGHT_SUPPORT))
+          SEND_MSG("Add left foot contact", MSG_TYPE_INFO);
+      }
+
+      bool InverseDynamicsBalanceController::removeContact(const ContactState support, const double transitionTime)
+      {
+        if(m_contactState != DOUBLE_SUPPORT)
+          return false;
+        const bool left = support==LEFT_SUPPORT;
+        if(transitionTime>m_dt)
         {
-          SEND_MSG("Add right foot contact in "+toString(transitionTime)+" s", MSG_TYPE_INFO);
-          m_invDyn->addRigidContact(*m_contactRF);
-          m_invDyn->removeTask(m_taskRF->name(), transitionTime);
-          m_contactState = DOUBLE_SUPPORT;
+          // both contacts are kept until the end of the transition, while
+          // tau_des decreases the max force of the contact being removed
+          m_contactState = left ? LEFT_SUPPORT_TRANSITION : RIGHT_SUPPORT_TRANSITION;
+          m_contactTransitionTime = m_t + transitionTime;
+          m_contactTransitionDuration = transitionTime;
+          setContactPhase(left ? PHASE_LEFT_SUPPORT_TRANSITION : PHASE_RIGHT_SUPPORT_TRANSITION);
         }
+        else
+        {
+          m_contactState = support;
+          setContactPhase(left ? PHASE_LEFT_SUPPORT : PHASE_RIGHT_SUPPORT);
+        }
+        return true;
       }
 
-      void InverseDynamicsBalanceController::addLeftFootContact(const double& transitionTime)
+      bool InverseDynamicsBalanceController::addContact(const ContactState support)
       {
-        if(m_contactState == RIGHT_SUPPORT)
+        if(m_contactState != support)
+          return false;
+        m_contactState = DOUBLE_SUPPORT;
+        setContactPhase(PHASE_DOUBLE_SUPPORT);
+        return true;
+      }
+
+      void InverseDynamicsBalanceController::setContactPhase(const ContactPhase phase)
+      {
+        // The warm start of the phase keeps the active set of the last time in
+        // this phase: QpWarmStart checks its feasibility before using it.
+        m_contactPhase = phase;
+        m_invDyn = m_invDynPhases[phase];
+        m_invDynReduced = m_invDynReducedPhases[phase];
+      }
+
+      void InverseDynamicsBalanceController::updateTaskWeight(TaskMotion & task, const double weight)
+      {
+        for(int i=0; i<NB_CONTACT_PHASES; i++)
         {
-          SEND_MSG("Add left foot contact in "+toString(transitionTime)+" s", MSG_TYPE_INFO);
-          m_invDyn->addRigidContact(*m_contactLF);
-          m_invDyn->removeTask(m_taskLF->name(), transitionTime);
-          m_contactState = DOUBLE_SUPPORT;
+          m_invDynPhases[i]->updateTaskWeight(task.name(), weight);
+          if(&task==m_taskPosture)
+            m_invDynReducedPhases[i]->updateTaskWeight(task.name(), weight);
         }
       }
 
+      void InverseDynamicsBalanceController::setWarmStart(const bool& warmStart)
+      {
+        m_useWarmStart = warmStart;
+        for(int i=0; i<NB_CONTACT_PHASES; i++)
+          m_qpWarmStart[i].reset();
+        SEND_MSG("HQP warm start "+string(warmStart ? "enabled" : "disabled"), MSG_TYPE_INFO);
+      }
+
+      void InverseDynamicsBalanceController::setRealTimeMode(const bool& rtMode)
+      {
+        m_rtMode = rtMode;
+        SEND_MSG("Real-time mode "+string(rtMode ? "enabled" : "disabled")+". HQP failures: "+toString(m_hqpFailures)+
+                 ", last failure status: "+toString(m_hqpStatusLast)+", time errors: "+toString(m_timeErrors), MSG_TYPE_INFO);
+      }
+
+      void InverseDynamicsBalanceController::setDeadline(const double& deadline)
+      {
+        getProfiler().set_deadline(m_profileSections[PROFILE_TAU_DES_COMPUTATION], deadline);
+      }
+
+      void InverseDynamicsBalanceController::setSolverBudget(const double& maxTime, const int& maxIterations)
+      {
+        if(maxTime<0.0 || maxIterations<0)
+          return SEND_MSG("The solver budget cannot be negative", MSG_TYPE_ERROR);
+        m_maxSolveTime = maxTime;
+        m_maxSolverIterations = maxIterations;
+      }
+
+      void InverseDynamicsBalanceController::setMaxExtrapolation(const int& nbTicks)
+      {
+        if(nbTicks<0)
+          return SEND_MSG("The number of ticks cannot be negative", MSG_TYPE_ERROR);
+        m_maxExtrapolationTicks = nbTicks;
+      }
+
       void InverseDynamicsBalanceController::init(const double& dt, 
 						  const std::string& robotRef)
       {
@@ -415,6 +522,7 @@ namespace dynamicgraph
 
         m_w_com = m_w_comSIN(0);
         m_w_posture = m_w_postureSIN(0);
+        m_w_feet = m_w_feetSIN(0);
         const double & w_forces = m_w_forcesSIN(0);
 //        const double & w_base_orientation = m_w_base_orientationSIN(0);
 //        const double & w_torques = m_w_torquesSIN(0);
@@ -425,10 +533,9 @@ namespace dynamicgraph
 
         try
         {
-          vector<string> package_dirs;
-          m_robot = new robots::RobotWrapper(m_robot_util->m_urdf_filename,
-					     package_dirs, 
-					     se3::JointModelFreeFlyer());
+          // copy of the shared model, because the rotor inertias and gear ratios are set below
+          m_robot = new robots::RobotWrapper(getRobotModel(m_robot_util->m_urdf_filename,
+                                                           ROOT_JOINT_FREE_FLYER));
 
           assert(m_robot->nv()>=6);
 	  m_robot_util->m_nbJoints = m_robot->nv()-6;
@@ -442,21 +549,22 @@ namespace dynamicgraph
 
           m_dv_sot.setZero(m_robot->nv());
           m_tau_sot.setZero(m_robot->nv()-6);
+          m_tau_hqp.setZero(m_robot->nv()-6);
+          m_tau_hqp_prev.setZero(m_robot->nv()-6);
+          m_tau_gravity_urdf.setZero(m_robot->nv()-6);
+          m_hqpSolved = false;
           m_f.setZero(24);
           m_q_urdf.setZero(m_robot->nq());
           m_v_urdf.setZero(m_robot->nv());
           m_J_RF.setZero(6, m_robot->nv());
           m_J_LF.setZero(6, m_robot->nv());
 
-          m_invDyn = new InverseDynamicsFormulationAccForce("invdyn", *m_robot);
-
           m_contactRF = new Contact6d("contact_rfoot", *m_robot, 
 				      m_robot_util->m_foot_util.m_Right_Foot_Frame_Name,
                                       contactPoints, contactNormal,
                                       mu, fMin, fMaxRF, w_forces);
           m_contactRF->Kp(kp_contact);
           m_contactRF->Kd(kd_contact);
-          m_invDyn->addRigidContact(*m_contactRF);
 
           m_contactLF = new Contact6d("contact_lfoot", *m_robot, 
 				      m_robot_util->m_foot_util.m_Left_Foot_Frame_Name,
@@ -464,7 +572,6 @@ namespace dynamicgraph
                                       mu, fMin, fMaxLF, w_forces);
           m_contactLF->Kp(kp_contact);
           m_contactLF->Kd(kd_contact);
-          m_invDyn->addRigidContact(*m_contactLF);
 
           if(m_f_ref_left_footSIN.isPlugged() && m_f_ref_right_footSIN.isPlugged())
           {
@@ -475,7 +582,6 @@ namespace dynamicgraph
           m_taskCom = new TaskComEquality("task-com", *m_robot);
           m_taskCom->Kp(kp_com);
           m_taskCom->Kd(kd_com);
-          m_invDyn->addMotionTask(*m_taskCom, m_w_com, 1);
 
           m_taskRF = new TaskSE3Equality("task-rf", *m_robot, m_robot_util->m_foot_util.m_Right_Foot_Frame_Name);
           m_taskRF->Kp(kp_feet);
@@ -488,7 +594,65 @@ namespace dynamicgraph
           m_taskPosture = new TaskJointPosture("task-posture", *m_robot);
           m_taskPosture->Kp(kp_posture);
           m_taskPosture->Kd(kd_posture);
-          m_invDyn->addMotionTask(*m_taskPosture, m_w_posture, 1);
+
+          // The task of the joints that are not controlled is added now with a
+          // zero weight, so that enabling it does not change the size of the HQP.
+          // Its mask (which resizes the task) is computed from the active joints
+          // known at init, so that enabling the controller only sets its weight.
+          m_active_joints_urdf.setZero(m_robot->nv()-6);
+          m_blocked_joints.setOnes(m_robot->nv()-6);
+          m_blocked_joints_enabled.setOnes(m_robot->nv()-6);
+          if(m_active_jointsSIN.isPlugged() &&
+             m_active_jointsSIN.accessCopy().size()==(long)m_robot_util->m_nbJoints)
+          {
+            m_robot_util->joints_sot_to_urdf(m_active_jointsSIN.accessCopy(), m_active_joints_urdf);
+            if(m_active_joints_urdf.any())
+              m_blocked_joints = (m_active_joints_urdf.array()==0.0).cast<double>();
+          }
+          m_taskBlockedJoints = new TaskJointPosture("task-blocked-joints", *m_robot);
+          m_taskBlockedJoints->mask(m_blocked_joints);
+          m_taskBlockedJoints->setReference(TrajectorySample(m_robot->nv()-6));
+
+          // One formulation per contact phase, so that a contact switch only
+          // changes m_invDyn instead of resizing the problem and its solver.
+          // They share the contacts and the tasks, so their references and
+          // gains are set once. Each phase only has the task of the foot that
+          // is not in contact or that is being removed, with its weight.
+          // The reduced formulations, used by the fallback FALLBACK_REDUCED_HQP,
+          // only have the contacts and the posture task.
+          for(int i=0; i<NB_CONTACT_PHASES; i++)
+          {
+            const bool rfContact = i!=PHASE_LEFT_SUPPORT;
+            const bool lfContact = i!=PHASE_RIGHT_SUPPORT;
+            const bool rfTask = i==PHASE_LEFT_SUPPORT || i==PHASE_LEFT_SUPPORT_TRANSITION;
+            const bool lfTask = i==PHASE_RIGHT_SUPPORT || i==PHASE_RIGHT_SUPPORT_TRANSITION;
+            InverseDynamicsFormulationAccForce * invDyn =
+                new InverseDynamicsFormulationAccForce("invdyn-"+toString(i), *m_robot);
+            InverseDynamicsFormulationAccForce * invDynReduced =
+                new InverseDynamicsFormulationAccForce("invdyn-reduced-"+toString(i), *m_robot);
+            if(rfContact)
+            {
+              invDyn->addRigidContact(*m_contactRF);
+              invDynReduced->addRigidContact(*m_contactRF);
+            }
+            if(lfContact)
+            {
+              invDyn->addRigidContact(*m_contactLF);
+              invDynReduced->addRigidContact(*m_contactLF);
+            }
+            invDyn->addMotionTask(*m_taskCom, m_w_com, 1);
+            invDyn->addMotionTask(*m_taskPosture, m_w_posture, 1);
+            invDyn->addMotionTask(*m_taskBlockedJoints, 0.0, 1);
+            if(rfTask)
+              invDyn->addMotionTask(*m_taskRF, m_w_feet, 1);
+            if(lfTask)
+              invDyn->addMotionTask(*m_taskLF, m_w_feet, 1);
+            invDynReduced->addMotionTask(*m_taskPosture, m_w_posture, 1);
+            m_invDynPhases[i] = invDyn;
+            m_invDynReducedPhases[i] = invDynReduced;
+          }
+          m_contactState = DOUBLE_SUPPORT;
+          setContactPhase(PHASE_DOUBLE_SUPPORT);
 
           m_sampleCom = TrajectorySample(3);
           m_samplePosture = TrajectorySample(m_robot->nv()-6);
@@ -496,13 +660,22 @@ namespace dynamicgraph
           m_frame_id_rf = (int)m_robot->model().getFrameId(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name);
           m_frame_id_lf = (int)m_robot->model().getFrameId(m_robot_util->m_foot_util.m_Left_Foot_Frame_Name);
 
-          m_hqpSolver = SolverHQPFactory::createNewSolver(SOLVER_HQP_EIQUADPROG_FAST,
-                                                          "eiquadprog-fast");
-          m_hqpSolver->resize(m_invDyn->nVar(), m_invDyn->nEq(), m_invDyn->nIn());
-          m_hqpSolver_60_36_34 = SolverHQPFactory::createNewSolver<60,36,34>(SOLVER_HQP_EIQUADPROG_RT,
-                                                                             "eiquadprog_rt_60_36_34");
-          m_hqpSolver_48_30_17 = SolverHQPFactory::createNewSolver<48,30,17>(SOLVER_HQP_EIQUADPROG_RT,
-                                                                             "eiquadprog_rt_48_30_17");
+          // a solver of each size, fixed if listed in HQP_FIXED_SIZES
+          m_hqpSolvers.init("eiquadprog-fast", m_invDyn->nVar(), m_invDyn->nEq(), m_invDyn->nIn());
+          for(int i=0; i<NB_CONTACT_PHASES; i++)
+          {
+            const InverseDynamicsFormulationAccForce * invDyn = m_invDynPhases[i];
+            const InverseDynamicsFormulationAccForce * invDynReduced = m_invDynReducedPhases[i];
+            m_hqpSolvers.reserve(invDyn->nVar(), invDyn->nEq(), invDyn->nIn());
+            m_hqpSolverReduced[i] = SolverHQPFactory::createNewSolver(SOLVER_HQP_EIQUADPROG_FAST,
+                                                                      "eiquadprog-fast-reduced-"+toString(i));
+            m_hqpSolverReduced[i]->resize(invDynReduced->nVar(), invDynReduced->nEq(), invDynReduced->nIn());
+            m_qpWarmStart[i].resize(invDyn->nVar(), invDyn->nEq(), invDyn->nIn());
+            m_qpWarmStart[i].reset();
+          }
+          m_hqpSolverLast = m_hqpSolvers.getSolver(m_invDyn->nVar(), m_invDyn->nEq(), m_invDyn->nIn());
+          m_defaultSolverIterations = m_hqpSolverLast->getMaximumIterations();
+          m_iterationTime = 0.0;
         }
         catch (const std::exception& e)
         {
@@ -510,6 +683,7 @@ namespace dynamicgraph
           return SEND_MSG("Init failed: Could load URDF :" + m_robot_util->m_urdf_filename, MSG_TYPE_ERROR);
         }
         m_dt = dt;
+        setDeadline(dt);
         m_initSucceeded = true;
       }
 
@@ -532,28 +706,31 @@ namespace dynamicgraph
             m_enabled = true ;
 
             s = active_joints_sot;
-            Eigen::VectorXd active_joints_urdf(m_robot_util->m_nbJoints);
-            m_robot_util->joints_sot_to_urdf(active_joints_sot, active_joints_urdf);
-//            joints_sot_to_urdf(active_joints_sot, active_joints_urdf);
-
-            m_taskBlockedJoints = new TaskJointPosture("task-posture", *m_robot);
-            Eigen::VectorXd blocked_joints(m_robot_util->m_nbJoints);
-            for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
-              if(active_joints_urdf(i)==0.0)
-                blocked_joints(i) = 1.0;
+            m_robot_util->joints_sot_to_urdf(active_joints_sot, m_active_joints_urdf);
+            m_blocked_joints_enabled = (m_active_joints_urdf.array()==0.0).cast<double>();
+            SEND_RECORD1(MSG_TYPE_INFO, "Controller enabled, blocked joints: %.0f", m_blocked_joints_enabled.sum());
+            // The mask computed at init is kept if the blocked joints are the
+            // same. Otherwise the task is resized, which allocates memory: in
+            // real-time mode it is only done at the first tick.
+            if(m_blocked_joints_enabled!=m_blocked_joints && m_blocked_joints_enabled.any())
+            {
+              if(!m_rtMode || m_firstTime)
+              {
+                m_blocked_joints = m_blocked_joints_enabled;
+                m_taskBlockedJoints->mask(m_blocked_joints);
+              }
               else
-                blocked_joints(i) = 0.0;
-            SEND_MSG("Blocked joints: "+toString(blocked_joints.transpose()), MSG_TYPE_INFO);
-            m_taskBlockedJoints->mask(blocked_joints);
-            TrajectorySample ref_zero(m_robot_util->m_nbJoints);
-            m_taskBlockedJoints->setReference(ref_zero);
-            m_invDyn->addMotionTask(*m_taskBlockedJoints, 1.0, 0);
+                SEND_RECORD(MSG_TYPE_ERROR, "Active joints different from init: the mask of the blocked joints is not updated in real-time mode");
+            }
+            if(m_blocked_joints_enabled.any())
+              updateTaskWeight(*m_taskBlockedJoints, BLOCKED_JOINTS_TASK_WEIGHT);
           }
         }
         else if (!active_joints_sot.any())
         {
           /* from some ON to all OFF */
           m_enabled = false ;
+          updateTaskWeight(*m_taskBlockedJoints, 0.0);
         }
         if (m_enabled == false)
           for(int i=0; i<m_robot_util->m_nbJoints; i++)
@@ -571,7 +748,30 @@ namespace dynamicgraph
         if(s.size()!=m_robot_util->m_nbJoints)
           s.resize(m_robot_util->m_nbJoints);
 
-        getProfiler().start(PROFILE_TAU_DES_COMPUTATION);
+        // A second call at the same iteration returns the torques of the first
+        // one, before any profiled section is started
+        if(!m_firstTime && m_timeLast == iter)
+        {
+          m_timeErrors++;
+          SEND_RECORD2(MSG_TYPE_ERROR, "Last time %.0f is not current time-1: %.0f", m_timeLast, iter);
+          s = m_tau_sot;
+          return s;
+        }
+
+        // After the first iteration the real-time mode forbids dynamic memory
+        // allocation in the whole tick, including the computation of the
+        // problem data, the HQP and the contact switches (the formulations of
+        // all the phases are prepared at the first iteration). Eigen checks it
+        // when assertions are enabled, unit_test_balance_controller_rt checks
+        // any allocation. Eigen's check is process-wide, so it is skipped
+        // while graphs are stepped in parallel (see isMallocGuardEnabled).
+        const bool rt = m_rtMode && !m_firstTime && isMallocGuardEnabled();
+        if(rt)
+        {
+          EIGEN_MALLOC_NOT_ALLOWED
+        }
+        m_tickStartNs = getProfiler().take_time_ns();
+        getProfiler().start(m_profileSections[PROFILE_TAU_DES_COMPUTATION]);
 
         // use reference contact wrenches (if plugged) to determine contact phase
         if(m_f_ref_left_footSIN.isPlugged() && m_f_ref_right_footSIN.isPlugged())
@@ -585,34 +785,36 @@ namespace dynamicgraph
           {
             if(f_ref_left_foot.norm() < ZERO_FORCE_THRESHOLD)
             {
-              removeLeftFootContact(0.0);
+              removeContact(RIGHT_SUPPORT, 0.0);
             }
             else if(f_ref_right_foot.norm() < ZERO_FORCE_THRESHOLD)
             {
-              removeRightFootContact(0.0);
+              removeContact(LEFT_SUPPORT, 0.0);
             }
           }
           else if(m_contactState == LEFT_SUPPORT && f_ref_right_foot.norm()>ZERO_FORCE_THRESHOLD)
           {
-            addRightFootContact(0.0);
+            addContact(LEFT_SUPPORT);
           }
           else if(m_contactState == RIGHT_SUPPORT && f_ref_left_foot.norm()>ZERO_FORCE_THRESHOLD)
           {
-            addLeftFootContact(0.0);
+            addContact(RIGHT_SUPPORT);
           }
         }
 
         if(m_contactState == RIGHT_SUPPORT_TRANSITION && m_t >= m_contactTransitionTime)
         {
           m_contactState = RIGHT_SUPPORT;
+          setContactPhase(PHASE_RIGHT_SUPPORT);
         }
         else if(m_contactState == LEFT_SUPPORT_TRANSITION && m_t >= m_contactTransitionTime)
         {
           m_contactState = LEFT_SUPPORT;
+          setContactPhase(PHASE_LEFT_SUPPORT);
         }
 
-        getProfiler().start(PROFILE_READ_INPUT_SIGNALS);
-        m_w_feetSIN(iter);
+        getProfiler().start(m_profileSections[PROFILE_READ_INPUT_SIGNALS]);
+        const double & w_feet = m_w_feetSIN(iter);
         m_active_joints_checkedSINNER(iter);
         const VectorN6& q_sot = m_qSIN(iter);
         assert(q_sot.size()==m_robot_util->m_nbJoints+6);
@@ -675,11 +877,9 @@ namespace dynamicgraph
           m_taskLF->Kd(kd_feet);
         }
 
-        getProfiler().stop(PROFILE_READ_INPUT_SIGNALS);
-
-        getProfiler().start(PROFILE_PREPARE_INV_DYN);
-        m_robot_util->config_sot_to_urdf(q_sot, m_q_urdf);
-        m_robot_util->velocity_sot_to_urdf(m_q_urdf, v_sot, m_v_urdf);
+        getProfiler().stop(m_profileSections[PROFILE_READ_INPUT_SIGNALS]);
+        getProfiler().start(m_profileSections[PROFILE_PREPARE_INV_DYN]);
+        m_robot_util->config_velocity_sot_to_urdf(q_sot, v_sot, m_q_urdf, m_v_urdf);
 
         m_sampleCom.pos = x_com_ref - m_com_offset;
         m_sampleCom.vel = dx_com_ref;
@@ -691,12 +891,11 @@ namespace dynamicgraph
         {
 //          SEND_MSG("Change w_com from "+toString(m_w_com)+" to "+toString(w_com), MSG_TYPE_INFO);
           m_w_com = w_com;
-          m_invDyn->updateTaskWeight(m_taskCom->name(), w_com);
+          updateTaskWeight(*m_taskCom, w_com);
         }
 
-        m_robot_util->joints_sot_to_urdf(q_ref, m_samplePosture.pos);
-        m_robot_util->joints_sot_to_urdf(dq_ref, m_samplePosture.vel);
-        m_robot_util->joints_sot_to_urdf(ddq_ref, m_samplePosture.acc);
+        m_robot_util->joints_sot_to_urdf(q_ref, dq_ref, ddq_ref, m_samplePosture.pos,
+                                         m_samplePosture.vel, m_samplePosture.acc);
         m_taskPosture->setReference(m_samplePosture);
         m_taskPosture->Kp(kp_posture);
         m_taskPosture->Kd(kd_posture);
@@ -704,7 +903,13 @@ namespace dynamicgraph
         {
 //          SEND_MSG("Change posture from "+toString(m_w_posture)+" to "+toString(w_posture), MSG_TYPE_INFO);
           m_w_posture = w_posture;
-          m_invDyn->updateTaskWeight(m_taskPosture->name(), w_posture);
+          updateTaskWeight(*m_taskPosture, w_posture);
+        }
+        if(m_w_feet != w_feet)
+        {
+          m_w_feet = w_feet;
+          updateTaskWeight(*m_taskRF, w_feet);
+          updateTaskWeight(*m_taskLF, w_feet);
         }
 
         const double & fMin = m_f_minSIN(0);
@@ -720,6 +925,16 @@ namespace dynamicgraph
         m_contactRF->Kp(kp_contact);
         m_contactRF->Kd(kd_contact);
         m_contactRF->setRegularizationTaskWeight(w_forces);
+        // During a transition the max normal force of the contact being removed
+        // decreases to its min force, so that the foot can be lifted smoothly
+        if(m_contactState == LEFT_SUPPORT_TRANSITION || m_contactState == RIGHT_SUPPORT_TRANSITION)
+        {
+          const double alpha = std::min(1.0, 1.0 - (m_contactTransitionTime-m_t)/m_contactTransitionDuration);
+          if(m_contactState == LEFT_SUPPORT_TRANSITION)
+            m_contactRF->setMaxNormalForce((1.0-alpha)*fMaxRF + alpha*(fMin+CONTACT_TRANSITION_FORCE_MARGIN));
+          else
+            m_contactLF->setMaxNormalForce((1.0-alpha)*fMaxLF + alpha*(fMin+CONTACT_TRANSITION_FORCE_MARGIN));
+        }
 
         if(m_firstTime)
         {
@@ -735,67 +950,120 @@ namespace dynamicgraph
                                             m_robot->model().getJointId(m_robot_util->m_foot_util.m_Right_Foot_Frame_Name));
           m_contactRF->setReference(H_rf);
           SEND_MSG("Setting right foot reference to "+toString(H_rf), MSG_TYPE_DEBUG);
+
+          // solve once the problems of all the phases, so that the memory of
+          // their data and solvers is allocated before the real-time ticks
+          for(int i=0; i<NB_CONTACT_PHASES; i++)
+          {
+            InverseDynamicsFormulationAccForce * invDyn = m_invDynPhases[i];
+            m_hqpSolvers.getSolver(invDyn->nVar(), invDyn->nEq(), invDyn->nIn())
+                ->solve(invDyn->computeProblemData(m_t, m_q_urdf, m_v_urdf));
+            m_hqpSolverReduced[i]->solve(m_invDynReducedPhases[i]->computeProblemData(m_t, m_q_urdf, m_v_urdf));
+          }
         }
         else if(m_timeLast != iter-1)
         {
-          SEND_MSG("Last time "+toString(m_timeLast)+" is not current time-1: "+toString(iter), MSG_TYPE_ERROR);
-          if(m_timeLast == iter)
-          {
-            s = m_tau_sot;
-            return s;
-          }
+          m_timeErrors++;
+          SEND_RECORD2(MSG_TYPE_ERROR, "Last time %.0f is not current time-1: %.0f", m_timeLast, iter);
         }
         m_timeLast = iter;
 
         const HQPData & hqpData = m_invDyn->computeProblemData(m_t, m_q_urdf, m_v_urdf);
-        getProfiler().stop(PROFILE_PREPARE_INV_DYN);
-
-        getProfiler().start(PROFILE_HQP_SOLUTION);
-        SolverHQPBase * solver = m_hqpSolver;
-        if(m_invDyn->nVar()==60 && m_invDyn->nEq()==36 && m_invDyn->nIn()==34)
+        getProfiler().stop(m_profileSections[PROFILE_PREPARE_INV_DYN]);
+        getProfiler().start(m_profileSections[PROFILE_HQP_SOLUTION]);
+
+        SolverHQPBase * solver = m_hqpSolvers.getSolver(m_invDyn->nVar(), m_invDyn->nEq(), m_invDyn->nIn());
+        m_hqpSolverLast = solver;
+        if(!rt)
+          getStatistics().store(m_hqpSolvers.isDynamicSize(solver) ? "solver dynamic size" : "solver fixed size", 1.0);
+
+        // The warm start state does not belong to any solver, so it is kept
+        // when switching between fixed-size and dynamic-size solvers.
+        // If no iteration fits in the time left by the preparation of the
+        // problem the HQP is skipped (solPtr stays NULL) and a fallback
+        // computes the torques.
+        const HQPOutput * solPtr = NULL;
+        const unsigned int maxIterations = solverIterationBudget();
+        const bool skipHqp = maxIterations==0;
+        if(m_useWarmStart && !skipHqp)
         {
-          solver = m_hqpSolver_60_36_34;
-          getStatistics().store("solver fixed size 60_36_34", 1.0);
+          QpWarmStart & qpWarmStart = m_qpWarmStart[m_contactPhase];
+          if(qpWarmStart.solve(hqpData))
+            solPtr = &qpWarmStart.getOutput();
+          if(!rt)
+            getStatistics().store("solver warm start hit", solPtr!=NULL ? 1.0 : 0.0);
         }
-        else if(m_invDyn->nVar()==48 && m_invDyn->nEq()==30 && m_invDyn->nIn()==17)
+        if(solPtr==NULL && !skipHqp)
         {
-          solver = m_hqpSolver_48_30_17;
-          getStatistics().store("solver fixed size 48_30_17", 1.0);
+          solver->setMaximumIterations(maxIterations);
+          const int64_t solveStartNs = getProfiler().take_time_ns();
+          solPtr = &solver->solve(hqpData);
+          updateIterationTime(solveStartNs, solPtr->iterations);
+          if(m_useWarmStart)
+          {
+            if(solPtr->status==HQP_STATUS_OPTIMAL)
+              m_qpWarmStart[m_contactPhase].store(hqpData, *solPtr);
+            else
+              m_qpWarmStart[m_contactPhase].reset();
+          }
         }
-        else
-          getStatistics().store("solver dynamic size", 1.0);
+        getProfiler().stop(m_profileSections[PROFILE_HQP_SOLUTION]);
 
-        const HQPOutput & sol = solver->solve(hqpData);
-        getProfiler().stop(PROFILE_HQP_SOLUTION);
+        if(solPtr!=NULL && solPtr->status==HQP_STATUS_OPTIMAL)
+        {
+          const HQPOutput & sol = *solPtr;
+          if(!rt)
+          {
+            getStatistics().store("active inequalities", (sol.activeSet.array()>=0).count());
+            // iterations of the iterative solver, not run on warm start hits
+            if(solPtr!=&m_qpWarmStart[m_contactPhase].getOutput())
+              getStatistics().store("solver iterations", sol.iterations);
+            if(ddx_com_ref.norm()>1e-3)
+              getStatistics().store("com ff ratio", ddx_com_ref.norm()/m_taskCom->getConstraint().vector().norm());
+          }
 
-        if(sol.status!=HQP_STATUS_OPTIMAL)
+          m_dv_urdf = m_invDyn->getAccelerations(sol);
+          m_robot_util->velocity_urdf_to_sot(m_q_urdf, m_dv_urdf, m_dv_sot);
+          if(m_invDyn->getContactForces(m_contactRF->name(), sol, m_f.head<12>()))
+            m_f_RF.noalias() = m_contactRF->getForceGeneratorMatrix() * m_f.head<12>();
+          if(m_invDyn->getContactForces(m_contactLF->name(), sol, m_f.tail<12>()))
+            m_f_LF.noalias() = m_contactLF->getForceGeneratorMatrix() * m_f.tail<12>();
+          m_robot_util->joints_urdf_to_sot(m_invDyn->getActuatorForces(sol), m_tau_sot);
+
+          // the extrapolation needs two solutions of consecutive ticks
+          m_tau_hqp_prev = (m_fallbackTicks==0 && m_hqpSolved) ? m_tau_hqp : m_tau_sot;
+          m_tau_hqp = m_tau_sot;
+          m_hqpSolved = true;
+          m_fallbackTicks = 0;
+          m_fallbackLevel = FALLBACK_NONE;
+        }
+        else
         {
-          SEND_ERROR_STREAM_MSG("HQP solver failed to find a solution: "+toString(sol.status));
-          SEND_DEBUG_STREAM_MSG(tsid::solvers::HQPDataToString(hqpData, false));
-          SEND_DEBUG_STREAM_MSG("q="+toString(q_sot.transpose(),1,5));
-          SEND_DEBUG_STREAM_MSG("v="+toString(v_sot.transpose(),1,5));
-          s.setZero();
-          return s;
+          if(solPtr!=NULL)
+          {
+            m_hqpFailures++;
+            m_hqpStatusLast = solPtr->status;
+            SEND_RECORD1(MSG_TYPE_ERROR_STREAM, "HQP solver failed to find a solution: %.0f", solPtr->status);
+            if(!rt)
+            {
+              SEND_DEBUG_STREAM_MSG(tsid::solvers::HQPDataToString(hqpData, false));
+              SEND_DEBUG_STREAM_MSG("q="+toString(q_sot.transpose(),1,5));
+              SEND_DEBUG_STREAM_MSG("v="+toString(v_sot.transpose(),1,5));
+            }
+          }
+          // dv_des and f_des keep the values of the last solution of the HQP
+          computeFallbackTorques();
         }
-
-        getStatistics().store("active inequalities", sol.activeSet.size());
-        getStatistics().store("solver iterations", sol.iterations);
-        if(ddx_com_ref.norm()>1e-3)
-          getStatistics().store("com ff ratio", ddx_com_ref.norm()/m_taskCom->getConstraint().vector().norm());
-
-        m_dv_urdf = m_invDyn->getAccelerations(sol);
-        m_robot_util->velocity_urdf_to_sot(m_q_urdf, m_dv_urdf, m_dv_sot);
-        Eigen::Matrix<double,12,1> tmp;
-        if(m_invDyn->getContactForces(m_contactRF->name(), sol, tmp))
-          m_f_RF = m_contactRF->getForceGeneratorMatrix() * tmp;
-        if(m_invDyn->getContactForces(m_contactLF->name(), sol, tmp))
-          m_f_LF = m_contactLF->getForceGeneratorMatrix() * tmp;
-        m_robot_util->joints_urdf_to_sot(m_invDyn->getActuatorForces(sol), m_tau_sot);
+        m_fallbacks[m_fallbackLevel]++;
 
         m_tau_sot += kp_pos.cwiseProduct(q_ref-q_sot.tail(m_robot_util->m_nbJoints)) +
                      kd_pos.cwiseProduct(dq_ref-v_sot.tail(m_robot_util->m_nbJoints));
 
-        getProfiler().stop(PROFILE_TAU_DES_COMPUTATION);
+        if(rt)
+        {
+          EIGEN_MALLOC_ALLOWED
+        }
+        getProfiler().stop(m_profileSections[PROFILE_TAU_DES_COMPUTATION]);
         m_t += m_dt;
 
         s = m_tau_sot;
@@ -803,6 +1071,130 @@ namespace dynamicgraph
         return s;
       }
 
+      DEFINE_SIGNAL_OUT_FUNCTION(latency,dynamicgraph::Vector)
+      {
+        m_tau_desSOUT(iter);
+        getProfiler().get_latencies(&m_profileSections[0], N_PROFILE_SECTIONS, s);
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(deadline_misses,dynamicgraph::Vector)
+      {
+        m_tau_desSOUT(iter);
+        getProfiler().get_deadline_misses(&m_profileSections[0], N_PROFILE_SECTIONS, s);
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(hqp_failures,dynamicgraph::Vector)
+      {
+        m_tau_desSOUT(iter);
+        if(s.size()!=1)
+          s.resize(1);
+        s(0) = m_hqpFailures;
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(fallback_level,dynamicgraph::Vector)
+      {
+        m_tau_desSOUT(iter);
+        if(s.size()!=1)
+          s.resize(1);
+        s(0) = m_fallbackLevel;
+        return s;
+      }
+
+      unsigned int InverseDynamicsBalanceController::solverIterationBudget()
+      {
+        const unsigned int maxIterations = m_maxSolverIterations>0 ? (unsigned int)m_maxSolverIterations
+                                                                   : m_defaultSolverIterations;
+        if(m_maxSolveTime<=0.0)
+          return maxIterations;
+        const double timeLeft = m_maxSolveTime - 1e-9*(getProfiler().take_time_ns()-m_tickStartNs);
+        if(timeLeft<=0.0)
+          return 0;
+        // no estimate of the time of an iteration before the first solution
+        if(m_iterationTime<=0.0)
+          return maxIterations;
+        // the set-up of the solver (factorization of the Hessian) counts as one iteration
+        const double fittingIterations = timeLeft/m_iterationTime - 1.0;
+        if(fittingIterations<1.0)
+          return 0;
+        return fittingIterations<maxIterations ? (unsigned int)fittingIterations : maxIterations;
+      }
+
+      void InverseDynamicsBalanceController::updateIterationTime(const int64_t solveStartNs,
+                                                                 const int iterations)
+      {
+        const double iterationTime = 1e-9*(getProfiler().take_time_ns()-solveStartNs)/(iterations+1);
+        m_iterationTime = std::max(iterationTime, SOLVER_ITERATION_TIME_DECAY*m_iterationTime);
+      }
+
+      void InverseDynamicsBalanceController::computeFallbackTorques()
+      {
+        m_fallbackTicks++;
+        if(m_hqpSolved && m_fallbackTicks<=m_maxExtrapolationTicks)
+        {
+          // the last solution is m_fallbackTicks ticks old
+          m_fallbackLevel = FALLBACK_EXTRAPOLATION;
+          m_tau_sot = m_tau_hqp + double(m_fallbackTicks)*(m_tau_hqp-m_tau_hqp_prev);
+          return;
+        }
+
+        const unsigned int maxIterations = solverIterationBudget();
+        if(maxIterations>0)
+        {
+          const HQPData & hqpData = m_invDynReduced->computeProblemData(m_t, m_q_urdf, m_v_urdf);
+          SolverHQPBase * solver = m_hqpSolverReduced[m_contactPhase];
+          solver->setMaximumIterations(maxIterations);
+          const int64_t solveStartNs = getProfiler().take_time_ns();
+          const HQPOutput & sol = solver->solve(hqpData);
+          updateIterationTime(solveStartNs, sol.iterations);
+          if(sol.status==HQP_STATUS_OPTIMAL)
+          {
+            m_fallbackLevel = FALLBACK_REDUCED_HQP;
+            m_robot_util->joints_urdf_to_sot(m_invDynReduced->getActuatorForces(sol), m_tau_sot);
+            return;
+          }
+        }
+
+        // Compensation of h(q,v) consistent with the contacts of the phase: the
+        // contact wrenches f of min norm balance the base rows of h, i.e.
+        // Jc_b^T f = h_b, and tau = h_j - Jc_j^T f. With f = Jc_b lambda this is
+        // the 6x6 system (sum_i Jb_i^T Jb_i) lambda = h_b, solved without
+        // allocating memory. h(q,v) and the joint Jacobians have already been
+        // computed by computeProblemData.
+        m_fallbackLevel = FALLBACK_GRAVITY;
+        const se3::Data & data = m_invDyn->data();
+        const tsid::math::Vector & h = m_robot->nonLinearEffects(data);
+        const long nj = m_tau_gravity_urdf.size();
+        const bool rfContact = m_contactPhase!=PHASE_LEFT_SUPPORT;
+        const bool lfContact = m_contactPhase!=PHASE_RIGHT_SUPPORT;
+        Eigen::Matrix<double,6,6> A = Eigen::Matrix<double,6,6>::Zero();
+        if(rfContact)
+        {
+          m_robot->frameJacobianLocal(data, m_frame_id_rf, m_J_RF);
+          A.noalias() += m_J_RF.leftCols<6>().transpose() * m_J_RF.leftCols<6>();
+        }
+        if(lfContact)
+        {
+          m_robot->frameJacobianLocal(data, m_frame_id_lf, m_J_LF);
+          A.noalias() += m_J_LF.leftCols<6>().transpose() * m_J_LF.leftCols<6>();
+        }
+        const Vector6 lambda = A.ldlt().solve(h.head<6>());
+        m_tau_gravity_urdf = h.tail(nj);
+        if(rfContact)
+        {
+          const Vector6 f = m_J_RF.leftCols<6>() * lambda;
+          m_tau_gravity_urdf.noalias() -= m_J_RF.rightCols(nj).transpose() * f;
+        }
+        if(lfContact)
+        {
+          const Vector6 f = m_J_LF.leftCols<6>() * lambda;
+          m_tau_gravity_urdf.noalias() -= m_J_LF.rightCols(nj).transpose() * f;
+        }
+        m_robot_util->joints_urdf_to_sot(m_tau_gravity_urdf, m_tau_sot);
+      }
+
       DEFINE_SIGNAL_OUT_FUNCTION(M,dynamicgraph::Matrix)
       {
         if(!m_initSucceeded)
@@ -1302,7 +1694,12 @@ namespace dynamicgraph
         {
           getProfiler().report_all(3, os);
           getStatistics().report_all(1, os);
-          os<<"QP size: nVar "<<m_invDyn->nVar()<<" nEq "<<m_invDyn->nEq()<<" nIn "<<m_invDyn->nIn()<<"\n";
+          os<<"QP size: nVar "<<m_invDyn->nVar()<<" nEq "<<m_invDyn->nEq()<<" nIn "<<m_invDyn->nIn()
+            <<", solver "<<m_hqpSolverLast->name()
+            <<(m_hqpSolvers.isDynamicSize(m_hqpSolverLast) ? " (add this size to HQP_FIXED_SIZES to use a fixed-size solver)" : "")<<"\n";
+          os<<"HQP failures: "<<m_hqpFailures<<" (last status "<<m_hqpStatusLast<<"), time errors: "<<m_timeErrors<<"\n";
+          os<<"Ticks computed by HQP: "<<m_fallbacks[FALLBACK_NONE]<<", extrapolation: "<<m_fallbacks[FALLBACK_EXTRAPOLATION]
+            <<", reduced HQP: "<<m_fallbacks[FALLBACK_REDUCED_HQP]<<", gravity compensation: "<<m_fallbacks[FALLBACK_GRAVITY]<<"\n";
         }
         catch (ExceptionSignal e) {}
       }
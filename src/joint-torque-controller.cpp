@@ -88,15 +88,18 @@ namespace dynamicgraph
         ,CONSTRUCT_SIGNAL_IN(motorParameterKa_n, dynamicgraph::Vector)
         ,CONSTRUCT_SIGNAL_IN(polySignDq        , dynamicgraph::Vector)
         ,CONSTRUCT_SIGNAL_IN(torque_integral_saturation, dynamicgraph::Vector)
+        ,CONSTRUCT_SIGNAL_INNER(motor_coefficients,  dynamicgraph::Matrix, MODEL_INPUT_SIGNALS <<
+                                                                           m_coulomb_friction_compensation_percentageSIN)
         ,CONSTRUCT_SIGNAL_OUT(u,                     dynamicgraph::Vector, ESTIMATOR_INPUT_SIGNALS <<
                                                                            TORQUE_CONTROL_INPUT_SIGNALS <<
                                                                            VEL_CONTROL_INPUT_SIGNALS <<
-                                                                           MODEL_INPUT_SIGNALS <<
+                                                                           m_motor_coefficientsSINNER <<
                                                                            m_torque_error_integralSOUT)
         ,CONSTRUCT_SIGNAL_OUT(torque_error_integral, dynamicgraph::Vector, m_jointsTorquesSIN <<
                                                                            m_jointsTorquesDesiredSIN <<
                                                                            TORQUE_INTEGRAL_INPUT_SIGNALS )
-        ,CONSTRUCT_SIGNAL_OUT(smoothSignDq,          dynamicgraph::Vector, m_jointsVelocitiesSIN )
+        ,CONSTRUCT_SIGNAL_OUT(smoothSignDq,          dynamicgraph::Vector, m_jointsVelocitiesSIN <<
+                                                                           m_motor_coefficientsSINNER)
       {
         Entity::signalRegistration( ALL_INPUT_SIGNALS << ALL_OUTPUT_SIGNALS);
 
@@ -146,6 +149,7 @@ namespace dynamicgraph
         m_dt = timestep;
         m_tau_star.setZero(m_robot_util->m_nbJoints);
         m_current_des.setZero(m_robot_util->m_nbJoints);
+        m_dq_motor.setZero(m_robot_util->m_nbJoints);
         m_tauErrIntegral.setZero(m_robot_util->m_nbJoints);
 //        m_dqDesIntegral.setZero(m_robot_util->m_nbJoints);
         m_dqErrIntegral.setZero(m_robot_util->m_nbJoints);
@@ -161,6 +165,30 @@ namespace dynamicgraph
       /* --- SIGNALS ---------------------------------------------------------- */
       /* --- SIGNALS ---------------------------------------------------------- */
 
+      DEFINE_SIGNAL_INNER_FUNCTION(motor_coefficients, dynamicgraph::Matrix)
+      {
+        const Eigen::VectorXd& colFricCompPerc    = m_coulomb_friction_compensation_percentageSIN(iter);
+        const Eigen::VectorXd& motorParameterKt_p = m_motorParameterKt_pSIN(iter);
+        const Eigen::VectorXd& motorParameterKt_n = m_motorParameterKt_nSIN(iter);
+        const Eigen::VectorXd& motorParameterKf_p = m_motorParameterKf_pSIN(iter);
+        const Eigen::VectorXd& motorParameterKf_n = m_motorParameterKf_nSIN(iter);
+        const Eigen::VectorXd& motorParameterKv_p = m_motorParameterKv_pSIN(iter);
+        const Eigen::VectorXd& motorParameterKv_n = m_motorParameterKv_nSIN(iter);
+        const Eigen::VectorXd& motorParameterKa_p = m_motorParameterKa_pSIN(iter);
+        const Eigen::VectorXd& motorParameterKa_n = m_motorParameterKa_nSIN(iter);
+        const Eigen::VectorXd& polySignDq         = m_polySignDqSIN(iter);
+
+        MotorModel::packCoefficients(motorParameterKt_p, motorParameterKt_n,
+                                     motorParameterKf_p, motorParameterKf_n,
+                                     motorParameterKv_p, motorParameterKv_n,
+                                     motorParameterKa_p, motorParameterKa_n,
+                                     polySignDq, s);
+        // the coulomb friction compensation scales both Kf_p and Kf_n
+        s.col(MOTOR_KF_MEAN)      = s.col(MOTOR_KF_MEAN).cwiseProduct(colFricCompPerc);
+        s.col(MOTOR_KF_HALF_DIFF) = s.col(MOTOR_KF_HALF_DIFF).cwiseProduct(colFricCompPerc);
+        return s;
+      }
+
       DEFINE_SIGNAL_OUT_FUNCTION(u, dynamicgraph::Vector)
       {
         const Eigen::VectorXd& q                  = m_jointsPositionsSIN(iter);
@@ -176,16 +204,6 @@ namespace dynamicgraph
         const Eigen::VectorXd& kd_vel             = m_KdVelSIN(iter);
         const Eigen::VectorXd& ki_vel             = m_KiVelSIN(iter);
         const Eigen::VectorXd& tauErrInt          = m_torque_error_integralSOUT(iter);
-        const Eigen::VectorXd& colFricCompPerc    = m_coulomb_friction_compensation_percentageSIN(iter);
-        const Eigen::VectorXd& motorParameterKt_p = m_motorParameterKt_pSIN(iter);
-        const Eigen::VectorXd& motorParameterKt_n = m_motorParameterKt_nSIN(iter);
-        const Eigen::VectorXd& motorParameterKf_p = m_motorParameterKf_pSIN(iter);
-        const Eigen::VectorXd& motorParameterKf_n = m_motorParameterKf_nSIN(iter);
-        const Eigen::VectorXd& motorParameterKv_p = m_motorParameterKv_pSIN(iter);
-        const Eigen::VectorXd& motorParameterKv_n = m_motorParameterKv_nSIN(iter);
-        const Eigen::VectorXd& motorParameterKa_p = m_motorParameterKa_pSIN(iter);
-        const Eigen::VectorXd& motorParameterKa_n = m_motorParameterKa_nSIN(iter);
-        const Eigen::VectorXd& polySignDq         = m_polySignDqSIN(iter);
 //        const Eigen::VectorXd& dq_thr =        m_dq_thresholdSIN(iter);
 
         m_tau_star = tau_d + kp.cwiseProduct(tau_d - tau) + tauErrInt - kd.cwiseProduct(dtau);
@@ -214,21 +232,11 @@ namespace dynamicgraph
         if(saturating)
           SEND_INFO_STREAM_MSG("Saturate dqErr integral: "+toString(m_dqErrIntegral.head<12>()));
 
-        for(int i=0; i<(int)m_robot_util->m_nbJoints; i++)
-        {
-          m_current_des(i) = motorModel.getCurrent(m_tau_star(i),
-                                                   dq(i+offset)+kd_vel(i)*(dq_des(i)-dq(i+offset)) + m_dqErrIntegral(i), //ki_vel(i)*(m_dqDesIntegral(i)-q(i)),
-                                                   ddq(i+offset),
-                                                   motorParameterKt_p(i),
-                                                   motorParameterKt_n(i),
-                                                   motorParameterKf_p(i)*colFricCompPerc(i),
-                                                   motorParameterKf_n(i)*colFricCompPerc(i),
-                                                   motorParameterKv_p(i),
-                                                   motorParameterKv_n(i),
-                                                   motorParameterKa_p(i),
-                                                   motorParameterKa_n(i),
-                                                   polySignDq(i));
-        }
+        const unsigned int nj = m_robot_util->m_nbJoints;
+        m_dq_motor = dq.segment(offset, nj) + m_dqErrIntegral;
+        m_dq_motor += kd_vel.cwiseProduct(dq_des - dq.segment(offset, nj));
+        const dynamicgraph::Matrix& K = m_motor_coefficientsSINNER(iter);
+        motorModel.getCurrent(m_tau_star, m_dq_motor, ddq.segment(offset, nj), K, m_current_des);
 
         s = m_current_des;
         return s;
@@ -258,12 +266,11 @@ namespace dynamicgraph
       DEFINE_SIGNAL_OUT_FUNCTION(smoothSignDq, dynamicgraph::Vector)
       {
         const Eigen::VectorXd& dq =            m_jointsVelocitiesSIN(iter);
-        const Eigen::VectorXd& polySignDq =    m_polySignDqSIN(iter);
+        const dynamicgraph::Matrix& K =        m_motor_coefficientsSINNER(iter);
         if(s.size()!=(int)m_robot_util->m_nbJoints)
           s.resize(m_robot_util->m_nbJoints);
 	
-        for(int i=0; i<(int)m_robot_util->m_nbJoints; i++)
-          s(i) = motorModel.smoothSign(dq[i], 0.1, polySignDq[i]); //TODO Use Eigen binaryexpr
+        motorModel.smoothSign(dq.head(m_robot_util->m_nbJoints), 0.1, K, s);
         return s;
       }
 
@@ -35,8 +35,8 @@ namespace dynamicgraph
       using namespace Eigen;
 
 //Size to be aligned                         "-------------------------------------------------------"
-#define PROFILE_POSITION_DESIRED_COMPUTATION "TrajGen: reference joint traj computation              "
-#define PROFILE_FORCE_DESIRED_COMPUTATION    "TrajGen: reference force computation                   "
+STOP_WATCH_REGISTER(PROFILE_POSITION_DESIRED_COMPUTATION, "TrajGen: reference joint traj computation              ");
+STOP_WATCH_REGISTER(PROFILE_FORCE_DESIRED_COMPUTATION,    "TrajGen: reference force computation                   ");
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -206,24 +206,7 @@ namespace dynamicgraph
         m_dt = dt;
 
         m_status.resize(m_robot_util->m_nbJoints,JTG_STOP);
-        m_minJerkTrajGen.resize(m_robot_util->m_nbJoints);
-        m_sinTrajGen.resize(m_robot_util->m_nbJoints);
-        m_triangleTrajGen.resize(m_robot_util->m_nbJoints);
-        m_constAccTrajGen.resize(m_robot_util->m_nbJoints);
-        m_linChirpTrajGen.resize(m_robot_util->m_nbJoints);
-        m_currentTrajGen.resize(m_robot_util->m_nbJoints);
-        m_noTrajGen.resize(m_robot_util->m_nbJoints);
-
-        for(int i=0; i<m_robot_util->m_nbJoints; i++)
-        {
-          m_minJerkTrajGen[i]   = new MinimumJerkTrajectoryGenerator(dt,5.0,1);
-          m_sinTrajGen[i]       = new SinusoidTrajectoryGenerator(dt,5.0,1);
-          m_triangleTrajGen[i]  = new TriangleTrajectoryGenerator(dt,5.0,1);
-          m_constAccTrajGen[i]  = new ConstantAccelerationTrajectoryGenerator(dt,5.0,1);
-          m_linChirpTrajGen[i]  = new LinearChirpTrajectoryGenerator(dt,5.0,1);
-          m_noTrajGen[i]        = new NoTrajectoryGenerator(1);
-          m_currentTrajGen[i]   = m_noTrajGen[i];
-        }
+        m_jointTrajGen = new BatchTrajectoryGenerator(dt, m_robot_util->m_nbJoints);
         m_textFileTrajGen = new TextFileTrajectoryGenerator(dt, m_robot_util->m_nbJoints);
 
         for(int i=0; i<4; i++)
@@ -266,7 +249,7 @@ namespace dynamicgraph
               return s;
             }
             for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
-              m_noTrajGen[i]->set_initial_point(base6d_encoders(6+i));
+              m_jointTrajGen->stop(i, base6d_encoders(6+i));
             m_firstIter = false;
           }
 
@@ -281,7 +264,7 @@ namespace dynamicgraph
               s(i) = qRef[i];
               if(m_textFileTrajGen->isTrajectoryEnded())
               {
-                m_noTrajGen[i]->set_initial_point(s(i));
+                m_jointTrajGen->stop(i, s(i));
                 m_status[i] = JTG_STOP;
               }
             }
@@ -290,18 +273,15 @@ namespace dynamicgraph
           }
           else
           {
-            for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
+            m_jointTrajGen->compute_next_point();
+            s = m_jointTrajGen->getPos();
+            const std::vector<BatchTrajectoryGenerator::Index>& ended = m_jointTrajGen->get_ended();
+            for(unsigned int j=0; j<ended.size(); j++)
             {
-              s(i) = m_currentTrajGen[i]->compute_next_point()(0);
-              if(m_currentTrajGen[i]->isTrajectoryEnded())
-              {
-                m_currentTrajGen[i] = m_noTrajGen[i];
-                m_noTrajGen[i]->set_initial_point(s(i));
-                m_status[i] = JTG_STOP;
-                SEND_MSG("Trajectory of joint "+
-			 m_robot_util->get_name_from_id(i)+
-			 " ended.", MSG_TYPE_INFO);
-              }
+              m_status[ended[j]] = JTG_STOP;
+              SEND_MSG("Trajectory of joint "+
+		       m_robot_util->get_name_from_id(ended[j])+
+		       " ended.", MSG_TYPE_INFO);
             }
           }
 
@@ -329,8 +309,7 @@ namespace dynamicgraph
             s(i) = m_textFileTrajGen->getVel()[i];
         }
         else
-          for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
-            s(i) = m_currentTrajGen[i]->getVel()(0);
+          s = m_jointTrajGen->getVel();
 
         return s;
       }
@@ -354,8 +333,7 @@ namespace dynamicgraph
             s(i) = m_textFileTrajGen->getAcc()[i];
         }
         else
-          for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
-            s(i) = m_currentTrajGen[i]->getAcc()(0);
+          s = m_jointTrajGen->getAcc();
 
         return s;
       }
@@ -465,7 +443,7 @@ namespace dynamicgraph
         {
           for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
           {
-            if(!m_currentTrajGen[i]->isTrajectoryEnded())
+            if(!m_jointTrajGen->isTrajectoryEnded(i))
             {
               output=false;
               SEND_MSG("Trajectory of joint "+
@@ -494,7 +472,7 @@ namespace dynamicgraph
         bool needToMoveToInitConf = false;
         const VectorXd& qInit = m_textFileTrajGen->get_initial_point();
         for(unsigned int i=0; i<m_robot_util->m_nbJoints; i++)
-          if(fabs(qInit[i] - m_currentTrajGen[i]->getPos()(0)) > 0.001)
+          if(fabs(qInit[i] - m_jointTrajGen->getPos()(i)) > 0.001)
           {
             needToMoveToInitConf = true;
             SEND_MSG("Joint "+m_robot_util->get_name_from_id(i)+" is too far from initial configuration so first i will move it there.", MSG_TYPE_WARNING);
@@ -508,11 +486,8 @@ namespace dynamicgraph
             if(!isJointInRange(i, qInit[i]))
               return;
 
-            m_minJerkTrajGen[i]->set_initial_point(m_noTrajGen[i]->getPos());
-            m_minJerkTrajGen[i]->set_final_point(qInit[i]);
-            m_minJerkTrajGen[i]->set_trajectory_time(4.0);
+            m_jointTrajGen->start_min_jerk(i, qInit[i], 4.0);
             m_status[i] = JTG_MIN_JERK;
-            m_currentTrajGen[i] = m_minJerkTrajGen[i];
           }
           return;
         }
@@ -538,12 +513,9 @@ namespace dynamicgraph
         if(!isJointInRange(i, qFinal))
           return;
 
-        m_sinTrajGen[i]->set_initial_point(m_noTrajGen[i]->getPos());
-        SEND_MSG("Set initial point of sinusoid to "+toString(m_sinTrajGen[i]->getPos()),MSG_TYPE_DEBUG);
-        m_sinTrajGen[i]->set_final_point(qFinal);
-        m_sinTrajGen[i]->set_trajectory_time(time);
+        m_jointTrajGen->start_sinusoid(i, qFinal, time);
+        SEND_MSG("Set initial point of sinusoid to "+toString(m_jointTrajGen->getPos()(i)),MSG_TYPE_DEBUG);
         m_status[i]         = JTG_SINUSOID;
-        m_currentTrajGen[i] = m_sinTrajGen[i];
       }
 
       void JointTrajectoryGenerator::startTriangle(const std::string& jointName, const double& qFinal, const double& time, const double& Tacc)
@@ -559,18 +531,14 @@ namespace dynamicgraph
         if(!isJointInRange(i, qFinal))
           return;
 
-        m_triangleTrajGen[i]->set_initial_point(m_noTrajGen[i]->getPos());
-        SEND_MSG("Set initial point of triangular trajectory to "+toString(m_triangleTrajGen[i]->getPos()),MSG_TYPE_DEBUG);
-        m_triangleTrajGen[i]->set_final_point(qFinal);
-
-        if(!m_triangleTrajGen[i]->set_trajectory_time(time))
+        if(time<=0.0)
           return SEND_MSG("Trajectory time cannot be negative.", MSG_TYPE_ERROR);
 
-        if(!m_triangleTrajGen[i]->set_acceleration_time(Tacc))
+        if(!m_jointTrajGen->start_triangle(i, qFinal, time, Tacc))
           return SEND_MSG("Acceleration time cannot be negative or larger than half the trajectory time.", MSG_TYPE_ERROR);
+        SEND_MSG("Set initial point of triangular trajectory to "+toString(m_jointTrajGen->getPos()(i)),MSG_TYPE_DEBUG);
 
         m_status[i]         = JTG_TRIANGLE;
-        m_currentTrajGen[i] = m_triangleTrajGen[i];
       }
 
       void JointTrajectoryGenerator::startConstAcc(const std::string& jointName, const double& qFinal, const double& time)
@@ -588,12 +556,9 @@ namespace dynamicgraph
         if(!isJointInRange(i, qFinal))
           return;
 
-        m_constAccTrajGen[i]->set_initial_point(m_noTrajGen[i]->getPos());
-        SEND_MSG("Set initial point of const-acc trajectory to "+toString(m_constAccTrajGen[i]->getPos()),MSG_TYPE_DEBUG);
-        m_constAccTrajGen[i]->set_final_point(qFinal);
-        m_constAccTrajGen[i]->set_trajectory_time(time);
+        m_jointTrajGen->start_const_acc(i, qFinal, time);
+        SEND_MSG("Set initial point of const-acc trajectory to "+toString(m_jointTrajGen->getPos()(i)),MSG_TYPE_DEBUG);
         m_status[i]         = JTG_CONST_ACC;
-        m_currentTrajGen[i] = m_constAccTrajGen[i];
       }
 
       void JointTrajectoryGenerator::startForceSinusoid(const std::string& forceName, const int& axis, const double& fFinal, const double& time)
@@ -643,18 +608,9 @@ namespace dynamicgraph
         if(f0<=0.0)
           return SEND_MSG("Frequency has to be positive "+toString(f0),MSG_TYPE_ERROR);
 
-        if(!m_linChirpTrajGen[i]->set_initial_point(m_noTrajGen[i]->getPos()))
-          return SEND_MSG("Error while setting initial point "+toString(m_noTrajGen[i]->getPos()), MSG_TYPE_ERROR);
-        if(!m_linChirpTrajGen[i]->set_final_point(qFinal))
-          return SEND_MSG("Error while setting final point "+toString(qFinal), MSG_TYPE_ERROR);
-        if(!m_linChirpTrajGen[i]->set_trajectory_time(time))
+        if(!m_jointTrajGen->start_linear_chirp(i, qFinal, f0, f1, time))
           return SEND_MSG("Error while setting trajectory time "+toString(time), MSG_TYPE_ERROR);
-        if(!m_linChirpTrajGen[i]->set_initial_frequency(f0))
-          return SEND_MSG("Error while setting initial frequency "+toString(f0), MSG_TYPE_ERROR);
-        if(!m_linChirpTrajGen[i]->set_final_frequency(f1))
-          return SEND_MSG("Error while setting final frequency "+toString(f1), MSG_TYPE_ERROR);
         m_status[i]         = JTG_LIN_CHIRP;
-        m_currentTrajGen[i] = m_linChirpTrajGen[i];
       }
 
       void JointTrajectoryGenerator::startForceLinearChirp(const string& forceName, const int& axis, const double& fFinal, const double& f0, const double& f1, const double& time)
@@ -707,11 +663,8 @@ namespace dynamicgraph
         if(!isJointInRange(i, qFinal))
           return;
 
-        m_minJerkTrajGen[i]->set_initial_point(m_noTrajGen[i]->getPos());
-        m_minJerkTrajGen[i]->set_final_point(qFinal);
-        m_minJerkTrajGen[i]->set_trajectory_time(time);
+        m_jointTrajGen->start_min_jerk(i, qFinal, time);
         m_status[i] = JTG_MIN_JERK;
-        m_currentTrajGen[i] = m_minJerkTrajGen[i];
       }
 
       void JointTrajectoryGenerator::moveForce(const string& forceName, const int& axis, const double& fFinal, const double& time)
@@ -750,8 +703,7 @@ namespace dynamicgraph
           {
             m_status[i] = JTG_STOP;
             // update the initial position
-            m_noTrajGen[i]->set_initial_point(base6d_encoders(6+i));
-            m_currentTrajGen[i] = m_noTrajGen[i];
+            m_jointTrajGen->stop(i, base6d_encoders(6+i));
           }
           return;
         }
@@ -759,9 +711,8 @@ namespace dynamicgraph
         unsigned int i;
         if(convertJointNameToJointId(jointName,i)==false)
           return;
-        m_noTrajGen[i]->set_initial_point(base6d_encoders(6+i));  // update the initial position
+        m_jointTrajGen->stop(i, base6d_encoders(6+i));  // update the initial position
         m_status[i] = JTG_STOP;
-        m_currentTrajGen[i] = m_noTrajGen[i];
       }
 
       void JointTrajectoryGenerator::stopForce(const std::string& forceName)
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/utils/kinematics-cache.hh>
+
+#include <map>
+#include <sot/torque_control/common.hh>
+#include <tsid/robots/robot-wrapper.hpp>
+#include <pinocchio/algorithm/kinematics.hpp>
+#include <pinocchio/algorithm/frames.hpp>
+#include <pinocchio/algorithm/jacobian.hpp>
+#include <pinocchio/algorithm/center-of-mass.hpp>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      using namespace std;
+
+      KinematicsCache::KinematicsCache(const se3::Model& model)
+        : m_model(model)
+      {}
+
+      KinematicsCache::~KinematicsCache()
+      {
+        for(size_t i=0; i<m_entries.size(); i++)
+        {
+          delete m_entries[i]->data;
+          delete m_entries[i];
+        }
+      }
+
+      int KinematicsCache::addClient()
+      {
+        m_clientEntries.push_back(NULL);
+        return (int)m_clientEntries.size()-1;
+      }
+
+      void KinematicsCache::removeClient(int client)
+      {
+        if(m_clientEntries[client]!=NULL)
+          m_clientEntries[client]->nbClients--;
+        m_clientEntries[client] = NULL;
+      }
+
+      KinematicsCache::Entry* KinematicsCache::findEntry(const Eigen::VectorXd& q,
+                                                         const Eigen::VectorXd& v,
+                                                         bool needVelocities)
+      {
+        for(size_t i=0; i<m_entries.size(); i++)
+        {
+          Entry* e = m_entries[i];
+          if(e->computed==0 || e->q!=q)
+            continue;
+          // velocities not computed yet can be added to the entry
+          if(needVelocities && (e->computed & VELOCITIES) && e->v!=v)
+            continue;
+          return e;
+        }
+        return NULL;
+      }
+
+      KinematicsCache::Entry* KinematicsCache::getWritableEntry(int client)
+      {
+        // the entry of the client can be overwritten if nobody else is reading it
+        Entry* e = m_clientEntries[client];
+        if(e!=NULL && e->nbClients==1)
+          return e;
+        for(size_t i=0; i<m_entries.size(); i++)
+          if(m_entries[i]->nbClients==0)
+            return m_entries[i];
+
+        // at most one entry per client is ever created
+        e = new Entry();
+        e->data = new se3::Data(m_model);
+        e->q.setZero(m_model.nq);
+        e->v.setZero(m_model.nv);
+        e->computed = 0;
+        e->nbClients = 0;
+        m_entries.push_back(e);
+        return e;
+      }
+
+      const se3::Data& KinematicsCache::compute(int client,
+                                                const Eigen::VectorXd& q,
+                                                const Eigen::VectorXd& v,
+                                                int quantities)
+      {
+        assert(q.size()==m_model.nq && "Unexpected size of configuration vector");
+        const bool needVelocities = (quantities & VELOCITIES)!=0;
+        assert((!needVelocities || v.size()==m_model.nv) && "Unexpected size of velocity vector");
+
+        Entry* e = findEntry(q, v, needVelocities);
+        if(e==NULL)
+        {
+          e = getWritableEntry(client);
+          e->q = q;
+          e->computed = 0;
+        }
+        if(m_clientEntries[client]!=e)
+        {
+          if(m_clientEntries[client]!=NULL)
+            m_clientEntries[client]->nbClients--;
+          e->nbClients++;
+          m_clientEntries[client] = e;
+        }
+
+        se3::Data& data = *e->data;
+        const int missing = quantities & ~e->computed;
+        if(missing==0)
+          return data;
+
+        // the Jacobians are computed together with the joint placements
+        if(missing & JACOBIANS)
+        {
+          se3::computeJacobians(m_model, data, q);
+          e->computed |= JACOBIANS | POSITIONS;
+        }
+        if(missing & VELOCITIES)
+        {
+          se3::forwardKinematics(m_model, data, q, v);
+          e->v = v;
+          e->computed |= VELOCITIES | POSITIONS;
+        }
+        else if((missing & (POSITIONS | FRAMES | COM)) && !(e->computed & POSITIONS))
+        {
+          se3::forwardKinematics(m_model, data, q);
+          e->computed |= POSITIONS;
+        }
+        if(missing & FRAMES)
+        {
+          se3::framesForwardKinematics(m_model, data);
+          e->computed |= FRAMES;
+        }
+        if(missing & COM)
+        {
+          se3::centerOfMass(m_model, data, q, true, false);
+          e->computed |= COM;
+        }
+        return data;
+      }
+
+      std::map<std::string, KinematicsCache *> sgl_map_robot_to_kinematics_cache;
+
+      KinematicsCache * getKinematicsCache(const std::string &robotName,
+                                           const std::string &urdfFileName)
+      {
+        const std::string key = robotName+"#"+urdfFileName;
+        std::map<std::string, KinematicsCache *>::iterator it =
+          sgl_map_robot_to_kinematics_cache.find(key);
+        if(it!=sgl_map_robot_to_kinematics_cache.end())
+          return it->second;
+
+        KinematicsCache * cache =
+          new KinematicsCache(getRobotModel(urdfFileName, ROOT_JOINT_FREE_FLYER).model());
+        sgl_map_robot_to_kinematics_cache[key] = cache;
+        return cache;
+      }
+
+    } // namespace torquecontrol
+  } // namespace sot
+} // namespace dynamicgraph
@@ -21,9 +21,12 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <iomanip>      // std::setprecision
 #include <sot/torque_control/utils/logger.hh>
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
 
 namespace dynamicgraph
 {
@@ -33,16 +36,35 @@ namespace dynamicgraph
     {
       using namespace std;
 
+      /// The loggers set with setThreadLogger are owned by the caller
+      static void keepThreadLogger(Logger*) {}
+
+      static boost::thread_specific_ptr<Logger>& threadLogger()
+      {
+        static boost::thread_specific_ptr<Logger> p(&keepThreadLogger);
+        return p;
+      }
+
       Logger& getLogger()
       {
         static Logger l(0.001, 1.0);
-        return l;
+        Logger* t = threadLogger().get();
+        return t!=NULL ? *t : l;
+      }
+
+      void setThreadLogger(Logger* logger)
+      {
+        threadLogger().reset(logger);
       }
 
       Logger::Logger(double timeSample, double streamPrintPeriod)
         : m_timeSample(timeSample),
           m_streamPrintPeriod(streamPrintPeriod),
-          m_printCountdown(0.0)
+          m_printCountdown(0.0),
+          m_streamPrintTicks(0),
+          m_async(false),
+          m_droppedMsgs(0),
+          m_droppedMsgsPrinted(0)
       {
 #ifdef LOGGER_VERBOSITY_ERROR
         m_lv = VERBOSITY_ERROR;
@@ -56,6 +78,19 @@ namespace dynamicgraph
 #ifdef LOGGER_VERBOSITY_ALL
         m_lv = VERBOSITY_ALL;
 #endif
+        for(int i=0; i<LOGGER_MAX_STREAM_MSGS; i++)
+        {
+          m_stream_msg_counters[i].state = SLOT_EMPTY;
+          m_stream_msg_counters[i].file = NULL;
+          m_stream_msg_counters[i].line = 0;
+          m_stream_msg_counters[i].countdown = 0;
+        }
+        updateStreamPrintTicks();
+      }
+
+      Logger::~Logger()
+      {
+        setAsynchronous(false);
       }
 
       void Logger::countdown()
@@ -65,38 +100,209 @@ namespace dynamicgraph
         m_printCountdown -= m_timeSample;
       }
 
-      void Logger::sendMsg(string msg, MsgType type, const char* file, int line)
+      bool Logger::isAllowedByVerbosity(MsgType type)
+      {
+        return !(m_lv==VERBOSITY_NONE ||
+                 (m_lv==VERBOSITY_ERROR && !isErrorMsg(type)) ||
+                 (m_lv==VERBOSITY_WARNING_ERROR && !(isWarningMsg(type) || isErrorMsg(type))) ||
+                 (m_lv==VERBOSITY_INFO_WARNING_ERROR && isDebugMsg(type)));
+      }
+
+      void Logger::updateStreamPrintTicks()
+      {
+        m_streamPrintTicks = (long) (m_streamPrintPeriod/m_timeSample + 0.5);
+      }
+
+      Logger::StreamMsgCounter* Logger::getStreamMsgCounter(const char* file, int line)
+      {
+        size_t h = (reinterpret_cast<size_t>(file) ^ (static_cast<size_t>(line)*2654435761u));
+        for(int k=0; k<LOGGER_MAX_STREAM_MSGS; k++)
+        {
+          StreamMsgCounter & c = m_stream_msg_counters[(h+k) % LOGGER_MAX_STREAM_MSGS];
+          int state = c.state.load(boost::memory_order_acquire);
+          if(state==SLOT_EMPTY)
+          {
+            // if counter doesn't exist then add one, unless another thread claims the slot first
+            if(c.state.compare_exchange_strong(state, SLOT_CLAIMED, boost::memory_order_acq_rel))
+            {
+              c.file = file;
+              c.line = line;
+              c.countdown.store(0, boost::memory_order_relaxed);
+              c.state.store(SLOT_READY, boost::memory_order_release);
+              return &c;
+            }
+          }
+          // the key of a claimed slot is not known yet: the message is printed
+          if(state==SLOT_CLAIMED)
+            return NULL;
+          if(c.file==file && c.line==line)
+            return &c;
+        }
+        return NULL;
+      }
+
+      bool Logger::isStreamMsgDue(MsgType type, const char* file, int line)
+      {
+        if(!isAllowedByVerbosity(type))
+          return false;
+        StreamMsgCounter* c = getStreamMsgCounter(file, line);
+        if(c==NULL)
+          return true;
+        // if counter is greater than 0 then decrement it and do not print
+        long n = c->countdown.load(boost::memory_order_relaxed);
+        while(n>0)
+          if(c->countdown.compare_exchange_weak(n, n-1, boost::memory_order_relaxed))
+            return false;
+        return true;
+      }
+
+      bool Logger::isMsgDue(MsgType type, const char* file, int line)
+      {
+        if(!isAllowedByVerbosity(type))
+          return false;
+        if(!isStreamMsg(type))
+          return true;
+
+        StreamMsgCounter* c = getStreamMsgCounter(file, line);
+        if(c==NULL)
+          return true;
+        long n = c->countdown.load(boost::memory_order_relaxed);
+        while(true)
+        {
+          // if counter is greater than 0 then decrement it and do not print,
+          // otherwise reset counter and print
+          const long next = n>0 ? n-1 : m_streamPrintTicks.load(boost::memory_order_relaxed);
+          if(c->countdown.compare_exchange_weak(n, next, boost::memory_order_relaxed))
+            return n<=0;
+        }
+      }
+
+      void Logger::sendMsg(const string& msg, MsgType type, const char* file, int line)
+      {
+        sendMsg(msg.c_str(), type, file, line);
+      }
+
+      void Logger::sendMsg(const char* msg, MsgType type, const char* file, int line)
       {
-        if(m_lv==VERBOSITY_NONE ||
-          (m_lv==VERBOSITY_ERROR && !isErrorMsg(type)) ||
-          (m_lv==VERBOSITY_WARNING_ERROR && !(isWarningMsg(type) || isErrorMsg(type))) ||
-          (m_lv==VERBOSITY_INFO_WARNING_ERROR && isDebugMsg(type)))
+        if(!isMsgDue(type, file, line))
           return;
 
-        // if print is allowed by current verbosity level
-        if(isStreamMsg(type))
+        if(!m_async)
+          return print(msg);
+
+        LoggerRecord r;
+        r.type = type;
+        r.file = file;
+        r.line = line;
+        r.format = NULL;
+        r.nbArgs = 0;
+        strncpy(r.msg, msg, LOGGER_MSG_MAX_LENGTH-1);
+        r.msg[LOGGER_MSG_MAX_LENGTH-1] = '\0';
+        if(!m_queue.bounded_push(r))
+          m_droppedMsgs++;
+      }
+
+      void Logger::sendRecord(MsgType type, const char* file, int line,
+                              const char* source, const char* format, int nbArgs,
+                              double a0, double a1, double a2, double a3)
+      {
+        if(!isMsgDue(type, file, line))
+          return;
+
+        LoggerRecord r;
+        r.type = type;
+        r.file = file;
+        r.line = line;
+        r.format = format;
+        r.nbArgs = nbArgs<LOGGER_RECORD_MAX_ARGS ? nbArgs : LOGGER_RECORD_MAX_ARGS;
+        r.args[0] = a0;
+        r.args[1] = a1;
+        r.args[2] = a2;
+        r.args[3] = a3;
+        strncpy(r.source, source, LOGGER_SOURCE_MAX_LENGTH-1);
+        r.source[LOGGER_SOURCE_MAX_LENGTH-1] = '\0';
+
+        if(!m_async)
+        {
+          formatRecord(r, r.msg);
+          return print(r.msg);
+        }
+        if(!m_queue.bounded_push(r))
+          m_droppedMsgs++;
+      }
+
+      void Logger::formatRecord(const LoggerRecord & r, char* buffer)
+      {
+        if(r.format==NULL)
+        {
+          if(buffer!=r.msg)
+            strcpy(buffer, r.msg);
+          return;
+        }
+        int n = snprintf(buffer, LOGGER_MSG_MAX_LENGTH, "[%s] ", r.source);
+        if(n<0 || n>=LOGGER_MSG_MAX_LENGTH)
+          return;
+        const double* a = r.args;
+        switch(r.nbArgs)
         {
-          // check whether counter already exists
-          string id = file+toString(line);
-          map<string,double>::iterator it = m_stream_msg_counters.find(id);
-          if(it == m_stream_msg_counters.end())
+        case 0:  snprintf(buffer+n, LOGGER_MSG_MAX_LENGTH-n, "%s", r.format); break;
+        case 1:  snprintf(buffer+n, LOGGER_MSG_MAX_LENGTH-n, r.format, a[0]); break;
+        case 2:  snprintf(buffer+n, LOGGER_MSG_MAX_LENGTH-n, r.format, a[0], a[1]); break;
+        case 3:  snprintf(buffer+n, LOGGER_MSG_MAX_LENGTH-n, r.format, a[0], a[1], a[2]); break;
+        default: snprintf(buffer+n, LOGGER_MSG_MAX_LENGTH-n, r.format, a[0], a[1], a[2], a[3]); break;
+        }
+      }
+
+      void Logger::print(const char* msg)
+      {
+        printf("%s\n", msg);
+        fflush(stdout); // Prints to screen or whatever your standard out is
+      }
+
+      void Logger::setAsynchronous(bool async)
+      {
+        if(async == m_async)
+          return;
+        if(async)
+        {
+          m_async = true;
+          m_thread = boost::thread(boost::bind(&Logger::run, this));
+          return;
+        }
+        m_async = false;
+        m_thread.join();
+      }
+
+      void Logger::run()
+      {
+        LoggerRecord r;
+        char buffer[LOGGER_MSG_MAX_LENGTH];
+        while(true)
+        {
+          // read the flag before emptying the queue so that no message is left behind
+          const bool async = m_async;
+          while(m_queue.pop(r))
           {
-            // if counter doesn't exist then add one
-            m_stream_msg_counters.insert(make_pair(id, 0.0));
-            it = m_stream_msg_counters.find(id);
+            formatRecord(r, buffer);
+            print(buffer);
           }
 
-          // if counter is greater than 0 then decrement it and do not print
-          if(it->second>0.0)
+          const unsigned long dropped = m_droppedMsgs;
+          if(dropped != m_droppedMsgsPrinted)
           {
-            it->second -= m_timeSample;
-            return;
+            print(("[Logger] "+toString(dropped-m_droppedMsgsPrinted)+" messages dropped because the queue was full").c_str());
+            m_droppedMsgsPrinted = dropped;
           }
-          else  // otherwise reset counter and print
-            it->second = m_streamPrintPeriod;
+
+          if(!async)
+            return;
+          boost::this_thread::sleep(boost::posix_time::milliseconds(LOGGER_THREAD_PERIOD_MS));
         }
-        printf("%s\n", msg.c_str());
-        fflush(stdout); // Prints to screen or whatever your standard out is
+      }
+
+      void Logger::setVerbosity(LoggerVerbosity lv)
+      {
+        m_lv = lv;
       }
 
       bool Logger::setTimeSample(double t)
@@ -104,6 +310,7 @@ namespace dynamicgraph
         if(t<=0.0)
           return false;
         m_timeSample = t;
+        updateStreamPrintTicks();
         return true;
       }
 
@@ -112,6 +319,7 @@ namespace dynamicgraph
         if(s<=0.0)
           return false;
         m_streamPrintPeriod = s;
+        updateStreamPrintTicks();
         return true;
       }
       
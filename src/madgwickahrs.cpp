@@ -33,7 +33,7 @@ namespace dynamicgraph
 
       typedef Eigen::Vector6d Vector6;
 
-#define PROFILE_MADGWICKAHRS_COMPUTATION          "MadgwickAHRS computation"
+STOP_WATCH_REGISTER(PROFILE_MADGWICKAHRS_COMPUTATION,          "MadgwickAHRS computation");
 
 #define INPUT_SIGNALS     m_accelerometerSIN << m_gyroscopeSIN
 #define OUTPUT_SIGNALS    m_imu_quatSOUT
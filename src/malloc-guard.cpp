@@ -0,0 +1,46 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/utils/malloc-guard.hh>
+#include <boost/atomic.hpp>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      /** Number of runners that disabled the guard */
+      static boost::atomic<int> mallocGuardDisablers(0);
+
+      bool isMallocGuardEnabled()
+      {
+        return mallocGuardDisablers.load()==0;
+      }
+
+      void disableMallocGuard()
+      {
+        mallocGuardDisablers++;
+      }
+
+      void enableMallocGuard()
+      {
+        mallocGuardDisablers--;
+      }
+
+    } // namespace torque_control
+  } // namespace sot
+} // namespace dynamicgraph
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/monte-carlo-runner.hh>
+#include <sot/core/debug.hh>
+#include <dynamic-graph/factory.h>
+#include <dynamic-graph/pool.h>
+
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <sot/torque_control/commands-helper.hh>
+#include <sot/torque_control/utils/statistics.hh>
+#include <sot/torque_control/utils/malloc-guard.hh>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      namespace dynamicgraph = ::dynamicgraph;
+      using namespace dynamicgraph;
+      using namespace dynamicgraph::command;
+      using namespace std;
+      using namespace dynamicgraph::sot::torque_control;
+
+      /// Define EntityClassName here rather than in the header file
+      /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
+      typedef MonteCarloRunner EntityClassName;
+
+      /* --- DG FACTORY ---------------------------------------------------- */
+      DYNAMICGRAPH_FACTORY_ENTITY_PLUGIN(MonteCarloRunner,
+                                         "MonteCarloRunner");
+
+      /* ------------------------------------------------------------------- */
+      /* --- CONSTRUCTION -------------------------------------------------- */
+      /* ------------------------------------------------------------------- */
+      MonteCarloRunner::
+      MonteCarloRunner(const std::string& name)
+        : Entity(name)
+        ,m_metricsSOUT("MonteCarloRunner("+name+")::output(dynamicgraph::Matrix)::metrics")
+        ,m_completed_stepsSOUT("MonteCarloRunner("+name+")::output(dynamicgraph::Vector)::completed_steps")
+        ,m_verbosity(VERBOSITY_ERROR)
+        ,m_nextSimulation(0)
+      {
+        Entity::signalRegistration(m_metricsSOUT << m_completed_stepsSOUT);
+
+        /* Commands. */
+        addCommand("addSimulation",
+                   makeCommandVoid1(*this, &MonteCarloRunner::addSimulation,
+                                    docCommandVoid1("Add a simulation, stepped by the specified device.",
+                                                    "Name of the device (string)")));
+
+        addCommand("addMetric",
+                   makeCommandVoid5(*this, &MonteCarloRunner::addMetric,
+                                    docCommandVoid5("Add a metric evaluated at every time step of a simulation",
+                                                    "Name of the device of the simulation (string)",
+                                                    "Name of the metric, i.e. of its column in the signal metrics (string)",
+                                                    "Vector signal to evaluate, as entity.signal (string)",
+                                                    "Reference signal subtracted from the signal, or empty string for none (string)",
+                                                    "Reduction over time: max, min, max_abs, max_norm, rms or final (string)")));
+
+        addCommand("setVerbosity",
+                   makeCommandVoid1(*this, &MonteCarloRunner::setVerbosity,
+                                    docCommandVoid1("Set the verbosity of the loggers of the simulations (errors only by default).",
+                                                    "0: all, 1: info, warning and error, 2: warning and error, 3: error, 4: none (int)")));
+
+        addCommand("run",
+                   makeCommandVoid3(*this, &MonteCarloRunner::run,
+                                    docCommandVoid3("Run all the simulations in parallel",
+                                                    "Time step of the devices (double)",
+                                                    "Number of time steps to simulate (int)",
+                                                    "Number of threads, 0 to use all the cores (int)")));
+
+        addCommand("clear",
+                   makeCommandVoid0(*this, &MonteCarloRunner::clear,
+                                    docCommandVoid0("Remove all the simulations and the metrics.")));
+      }
+
+      MonteCarloRunner::~MonteCarloRunner()
+      {
+        clear();
+      }
+
+      /* --- COMMANDS ---------------------------------------------------------- */
+
+      MonteCarloRunner::Simulation* MonteCarloRunner::findSimulation(const string& deviceName)
+      {
+        for(size_t i=0; i<m_simulations.size(); i++)
+          if(m_simulations[i]->deviceName==deviceName)
+            return m_simulations[i];
+        return NULL;
+      }
+
+      void MonteCarloRunner::addSimulation(const string& deviceName)
+      {
+        if(findSimulation(deviceName)!=NULL)
+          return SEND_MSG("There is already a simulation with device "+deviceName, MSG_TYPE_ERROR);
+        if(!PoolStorage::getInstance()->existEntity(deviceName))
+          return SEND_MSG("There is no entity with name "+deviceName, MSG_TYPE_ERROR);
+        dynamicgraph::sot::Device* device =
+            dynamic_cast<dynamicgraph::sot::Device*>(&PoolStorage::getInstance()->getEntity(deviceName));
+        if(device==NULL)
+          return SEND_MSG("Entity "+deviceName+" is not a device", MSG_TYPE_ERROR);
+
+        Simulation* sim = new Simulation();
+        sim->deviceName = deviceName;
+        sim->device = device;
+        sim->completedSteps = 0;
+        m_simulations.push_back(sim);
+      }
+
+      void MonteCarloRunner::addMetric(const string& deviceName,
+                                       const string& metricName,
+                                       const string& signalName,
+                                       const string& referenceSignalName,
+                                       const string& reduction)
+      {
+        Simulation* sim = findSimulation(deviceName);
+        if(sim==NULL)
+          return SEND_MSG("There is no simulation with device "+deviceName, MSG_TYPE_ERROR);
+
+        Metric m;
+        if(reduction=="max")            m.reduction = REDUCTION_MAX;
+        else if(reduction=="min")       m.reduction = REDUCTION_MIN;
+        else if(reduction=="max_abs")   m.reduction = REDUCTION_MAX_ABS;
+        else if(reduction=="max_norm")  m.reduction = REDUCTION_MAX_NORM;
+        else if(reduction=="rms")       m.reduction = REDUCTION_RMS;
+        else if(reduction=="final")     m.reduction = REDUCTION_FINAL;
+        else
+          return SEND_MSG("Unknown reduction "+reduction, MSG_TYPE_ERROR);
+
+        try
+        {
+          istringstream signalPath(signalName);
+          m.signal = dynamic_cast<InputSignalType*>(&PoolStorage::getInstance()->getSignal(signalPath));
+          m.reference = NULL;
+          if(!referenceSignalName.empty())
+          {
+            istringstream referencePath(referenceSignalName);
+            m.reference = dynamic_cast<InputSignalType*>(&PoolStorage::getInstance()->getSignal(referencePath));
+            if(m.reference==NULL)
+              return SEND_MSG("Signal "+referenceSignalName+" is not a vector signal", MSG_TYPE_ERROR);
+          }
+        }
+        catch (const ExceptionAbstract& e)
+        {
+          return SEND_MSG("Cannot find signal: "+e.getStringMessage(), MSG_TYPE_ERROR);
+        }
+        if(m.signal==NULL)
+          return SEND_MSG("Signal "+signalName+" is not a vector signal", MSG_TYPE_ERROR);
+
+        m.column = (int) (find(m_metricNames.begin(), m_metricNames.end(), metricName) - m_metricNames.begin());
+        for(size_t i=0; i<sim->metrics.size(); i++)
+          if(sim->metrics[i].column==m.column)
+            return SEND_MSG("Simulation "+deviceName+" already has a metric "+metricName, MSG_TYPE_ERROR);
+        if(m.column==(int)m_metricNames.size())
+          m_metricNames.push_back(metricName);
+        m.value = 0.0;
+        sim->metrics.push_back(m);
+      }
+
+      void MonteCarloRunner::setVerbosity(const int& verbosity)
+      {
+        if(verbosity<VERBOSITY_ALL || verbosity>VERBOSITY_NONE)
+          return SEND_MSG("Verbosity must be in [0, 4]", MSG_TYPE_ERROR);
+        m_verbosity = (LoggerVerbosity) verbosity;
+      }
+
+      void MonteCarloRunner::run(const double& dt, const int& nbTimeSteps, const int& nbThreads)
+      {
+        if(m_simulations.empty())
+          return SEND_MSG("Cannot run before adding simulations", MSG_TYPE_ERROR);
+        if(dt<=0.0 || nbTimeSteps<=0 || nbThreads<0)
+          return SEND_MSG("Time step and number of time steps must be positive", MSG_TYPE_ERROR);
+
+        int n = nbThreads>0 ? nbThreads : (int) boost::thread::hardware_concurrency();
+        n = std::max(1, std::min(n, (int) m_simulations.size()));
+
+        // the profilers of the simulations know the IDs registered by the entities
+        Stopwatch profiler(getProfiler());
+        profiler.reset_all();
+
+        // the allocation check of Eigen is process-wide: the controllers in
+        // real-time mode must not forbid the allocations of the other threads
+        disableMallocGuard();
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        m_nextSimulation = 0;
+        boost::thread_group workers;
+        for(int i=0; i<n; i++)
+          workers.create_thread(boost::bind(&MonteCarloRunner::runWorker, this,
+                                            dt, nbTimeSteps, &profiler));
+        workers.join_all();
+        enableMallocGuard();
+        const double elapsed = 1e-6*(boost::posix_time::microsec_clock::universal_time()-start).total_microseconds();
+
+        Matrix metrics = Matrix::Constant(m_simulations.size(), m_metricNames.size(),
+                                          std::numeric_limits<double>::quiet_NaN());
+        Vector completedSteps(m_simulations.size());
+        int failures = 0;
+        for(size_t i=0; i<m_simulations.size(); i++)
+        {
+          const Simulation& sim = *m_simulations[i];
+          for(size_t j=0; j<sim.metrics.size(); j++)
+            metrics(i, sim.metrics[j].column) = sim.metrics[j].value;
+          completedSteps(i) = sim.completedSteps;
+          if(sim.completedSteps<nbTimeSteps)
+          {
+            failures++;
+            SEND_MSG("Simulation "+sim.deviceName+" stopped at time step "+
+                     toString(sim.completedSteps)+": "+sim.error, MSG_TYPE_WARNING);
+          }
+        }
+        m_metricsSOUT.setConstant(metrics);
+        m_completed_stepsSOUT.setConstant(completedSteps);
+
+        SEND_MSG("Simulated "+toString(m_simulations.size())+" x "+toString(nbTimeSteps*dt)+
+                 " s on "+toString(n)+" threads in "+toString(elapsed)+" s, "+
+                 toString(failures)+" simulations stopped early", MSG_TYPE_INFO);
+      }
+
+      void MonteCarloRunner::runWorker(const double dt, const int nbTimeSteps,
+                                       const Stopwatch* profiler)
+      {
+        for(int i=m_nextSimulation++; i<(int)m_simulations.size(); i=m_nextSimulation++)
+        {
+          Stopwatch simProfiler(*profiler);
+          Logger simLogger(dt, 1.0);
+          ::Statistics simStatistics;
+          simLogger.setVerbosity(m_verbosity);
+          setThreadProfiler(&simProfiler);
+          setThreadLogger(&simLogger);
+          setThreadStatistics(&simStatistics);
+          runSimulation(*m_simulations[i], dt, nbTimeSteps);
+          setThreadStatistics(NULL);
+          setThreadLogger(NULL);
+          setThreadProfiler(NULL);
+        }
+      }
+
+      void MonteCarloRunner::runSimulation(Simulation& sim, const double dt, const int nbTimeSteps)
+      {
+        for(size_t j=0; j<sim.metrics.size(); j++)
+        {
+          Metric& m = sim.metrics[j];
+          m.value = (m.reduction==REDUCTION_MIN) ? std::numeric_limits<double>::infinity()
+                  : (m.reduction==REDUCTION_MAX) ? -std::numeric_limits<double>::infinity() : 0.0;
+        }
+        sim.completedSteps = 0;
+        sim.error.clear();
+
+        int i = 0;
+        try
+        {
+          for(i=0; i<nbTimeSteps; i++)
+          {
+            sim.device->increment(dt);
+            const int t = sim.device->stateSOUT.getTime();
+            for(size_t j=0; j<sim.metrics.size(); j++)
+            {
+              Metric& m = sim.metrics[j];
+              const Vector& v = (*m.signal)(t);
+              if(m.reference!=NULL)
+              {
+                const Vector& r = (*m.reference)(t);
+                if(r.size()!=v.size())
+                  throw std::runtime_error("size of the reference of metric "+m_metricNames[m.column]+
+                                           " is "+toString(r.size())+" instead of "+toString(v.size()));
+                m.error = v - r;
+              }
+              const Vector& e = (m.reference!=NULL) ? m.error : v;
+              if(e.size()==0)
+                continue;
+              switch(m.reduction)
+              {
+                case REDUCTION_MAX:       m.value = std::max(m.value, e.maxCoeff());             break;
+                case REDUCTION_MIN:       m.value = std::min(m.value, e.minCoeff());             break;
+                case REDUCTION_MAX_ABS:   m.value = std::max(m.value, e.cwiseAbs().maxCoeff());  break;
+                case REDUCTION_MAX_NORM:  m.value = std::max(m.value, e.norm());                 break;
+                case REDUCTION_RMS:       m.value += e.squaredNorm();                            break;
+                case REDUCTION_FINAL:     m.value = e.sum();                                     break;
+              }
+            }
+            sim.completedSteps++;
+          }
+        }
+        catch (const ExceptionAbstract& e)
+        {
+          sim.error = e.getStringMessage();
+        }
+        catch (const std::exception& e)
+        {
+          sim.error = e.what();
+        }
+
+        for(size_t j=0; j<sim.metrics.size(); j++)
+          if(sim.metrics[j].reduction==REDUCTION_RMS && sim.completedSteps>0)
+            sim.metrics[j].value = sqrt(sim.metrics[j].value/sim.completedSteps);
+      }
+
+      void MonteCarloRunner::clear()
+      {
+        for(size_t i=0; i<m_simulations.size(); i++)
+          delete m_simulations[i];
+        m_simulations.clear();
+        m_metricNames.clear();
+      }
+
+      /* ------------------------------------------------------------------- */
+      /* --- ENTITY -------------------------------------------------------- */
+      /* ------------------------------------------------------------------- */
+
+
+      void MonteCarloRunner::display(std::ostream& os) const
+      {
+        os << "MonteCarloRunner "<<getName()<<": "<<m_simulations.size()<<" simulations, metrics:";
+        for(size_t i=0; i<m_metricNames.size(); i++)
+          os << " " << m_metricNames[i];
+      }
+
+    } // namespace torquecontrol
+  } // namespace sot
+} // namespace dynamicgraph
@@ -80,6 +80,94 @@ namespace dynamicgraph {
             if (poly == 2 && value <= 0) return -a*a;
             return a*a*a;
         }
+
+        void MotorModel::packCoefficients(Eigen::ConstRefVector Kt_p, Eigen::ConstRefVector Kt_n,
+                                          Eigen::ConstRefVector Kf_p, Eigen::ConstRefVector Kf_n,
+                                          Eigen::ConstRefVector Kv_p, Eigen::ConstRefVector Kv_n,
+                                          Eigen::ConstRefVector Ka_p, Eigen::ConstRefVector Ka_n,
+                                          Eigen::ConstRefVector poly, MotorCoefficients & K)
+        {
+            assert((Kt_p.array()>0.0).all()  && "Kt_p should be > 0");
+            assert((Kt_n.array()>0.0).all()  && "Kt_n should be > 0");
+            assert((Kf_p.array()>=0.0).all() && "Kf_p should be >= 0");
+            assert((Kf_n.array()>=0.0).all() && "Kf_n should be >= 0");
+            assert((Kv_p.array()>=0.0).all() && "Kv_p should be >= 0");
+            assert((Kv_n.array()>=0.0).all() && "Kv_n should be >= 0");
+            assert((Ka_p.array()>=0.0).all() && "Ka_p should be >= 0");
+            assert((Ka_n.array()>=0.0).all() && "Ka_n should be >= 0");
+
+            packPolynomials(poly, K);
+            Eigen::Map<Eigen::ArrayXXd> k(K.data(), K.rows(), K.cols());
+            k.col(MOTOR_KT_MEAN)      = 0.5*(Kt_p.array()+Kt_n.array());
+            k.col(MOTOR_KT_HALF_DIFF) = 0.5*(Kt_p.array()-Kt_n.array());
+            k.col(MOTOR_KV_MEAN)      = 0.5*(Kv_p.array()+Kv_n.array());
+            k.col(MOTOR_KV_HALF_DIFF) = 0.5*(Kv_p.array()-Kv_n.array());
+            k.col(MOTOR_KA_MEAN)      = 0.5*(Ka_p.array()+Ka_n.array());
+            k.col(MOTOR_KA_HALF_DIFF) = 0.5*(Ka_p.array()-Ka_n.array());
+            k.col(MOTOR_KF_MEAN)      = 0.5*(Kf_p.array()+Kf_n.array());
+            k.col(MOTOR_KF_HALF_DIFF) = 0.5*(Kf_p.array()-Kf_n.array());
+        }
+
+        void MotorModel::packPolynomials(Eigen::ConstRefVector poly, MotorCoefficients & K)
+        {
+            if(K.rows()!=poly.size())
+                K.setZero(poly.size(), MOTOR_NB_COEFFICIENTS);
+            for(int i=0; i<poly.size(); i++)
+            {
+                // same degrees as the scalar smoothSign: anything else than 1 or 2 is cubic
+                const int p = (int) poly[i];
+                K(i,MOTOR_POLY_1) = (p==1) ? 1.0 : 0.0;
+                K(i,MOTOR_POLY_2) = (p==2) ? 1.0 : 0.0;
+                K(i,MOTOR_POLY_3) = (p!=1 && p!=2) ? 1.0 : 0.0;
+            }
+        }
+
+        void MotorModel::getCurrent(Eigen::ConstRefVector torque, Eigen::ConstRefVector dq,
+                                    Eigen::ConstRefVector ddq, const MotorCoefficients & K,
+                                    Eigen::RefVector current)
+        {
+            assert(K.rows()==torque.size() && "K should have one row per joint");
+            assert((K.col(MOTOR_KT_MEAN).array()-K.col(MOTOR_KT_HALF_DIFF).array().abs()>0.0).all()
+                   && "Kt_p and Kt_n should be > 0");
+            // current holds sign(dq) until the last line
+            this->smoothSign(dq, 0.1, K, current);
+            Eigen::Map<const Eigen::ArrayXXd> k(K.data(), K.rows(), K.cols());
+            Eigen::ArrayWrapper<Eigen::RefVector> s = current.array();
+            s = (k.col(MOTOR_KT_MEAN) + k.col(MOTOR_KT_HALF_DIFF)*s) * torque.array()
+              + (k.col(MOTOR_KV_MEAN) + k.col(MOTOR_KV_HALF_DIFF)*s) * dq.array()
+              + (k.col(MOTOR_KA_MEAN) + k.col(MOTOR_KA_HALF_DIFF)*s) * ddq.array()
+              + (k.col(MOTOR_KF_MEAN) + k.col(MOTOR_KF_HALF_DIFF)*s) * s;
+        }
+
+        void MotorModel::getTorque(Eigen::ConstRefVector current, Eigen::ConstRefVector dq,
+                                   Eigen::ConstRefVector ddq, const MotorCoefficients & K,
+                                   Eigen::RefVector torque)
+        {
+            assert(K.rows()==current.size() && "K should have one row per joint");
+            assert((K.col(MOTOR_KT_MEAN).array()-K.col(MOTOR_KT_HALF_DIFF).array().abs()>0.0).all()
+                   && "Kt_p and Kt_n should be > 0");
+            // torque holds sign(dq) until the last line
+            this->smoothSign(dq, 0.1, K, torque);
+            Eigen::Map<const Eigen::ArrayXXd> k(K.data(), K.rows(), K.cols());
+            Eigen::ArrayWrapper<Eigen::RefVector> s = torque.array();
+            s = ( current.array()
+                - (k.col(MOTOR_KV_MEAN) + k.col(MOTOR_KV_HALF_DIFF)*s) * dq.array()
+                - (k.col(MOTOR_KA_MEAN) + k.col(MOTOR_KA_HALF_DIFF)*s) * ddq.array()
+                - (k.col(MOTOR_KF_MEAN) + k.col(MOTOR_KF_HALF_DIFF)*s) * s )
+              / (k.col(MOTOR_KT_MEAN) + k.col(MOTOR_KT_HALF_DIFF)*s);
+        }
+
+        void MotorModel::smoothSign(Eigen::ConstRefVector value, double threshold,
+                                    const MotorCoefficients & K, Eigen::RefVector sign)
+        {
+            assert(K.rows()==value.size() && value.size()==sign.size());
+            // Saturating a=value/threshold in [-1,1] gives +-1 out of the threshold
+            // for all the degrees. Then sign = a*(w1 + w2*|a| + w3*a^2).
+            Eigen::Map<const Eigen::ArrayXXd> k(K.data(), K.rows(), K.cols());
+            Eigen::ArrayWrapper<Eigen::RefVector> a = sign.array();
+            a = (value.array()*(1.0/threshold)).max(-1.0).min(1.0);
+            a *= k.col(MOTOR_POLY_1) + a.abs()*(k.col(MOTOR_POLY_2) + a.abs()*k.col(MOTOR_POLY_3));
+        }
     } // namespace torque_control
   } // namespace sot
 } // namespace dynamicgraph
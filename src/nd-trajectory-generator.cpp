@@ -33,7 +33,7 @@ namespace dynamicgraph
       using namespace std;
       using namespace Eigen;
 
-#define PROFILE_ND_POSITION_DESIRED_COMPUTATION "NdTrajGen: traj computation"
+STOP_WATCH_REGISTER(PROFILE_ND_POSITION_DESIRED_COMPUTATION, "NdTrajGen: traj computation");
 #define DOUBLE_INF std::numeric_limits<double>::max()
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
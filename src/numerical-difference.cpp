@@ -55,6 +55,7 @@ namespace dynamicgraph
         ,CONSTRUCT_SIGNAL_OUT(dx,               dynamicgraph::Vector, m_x_dx_ddxSINNER)
         ,CONSTRUCT_SIGNAL_OUT(ddx,              dynamicgraph::Vector, m_x_dx_ddxSINNER)
         ,CONSTRUCT_SIGNAL_INNER(x_dx_ddx,       dynamicgraph::Vector, m_xSIN)
+        ,m_filter(NULL)
       {
         Entity::signalRegistration( ALL_INPUT_SIGNALS << ALL_OUTPUT_SIGNALS);
         
@@ -74,6 +75,9 @@ namespace dynamicgraph
                                               "Size of the input signal x",
                                               "Estimation delay for signal x",
                                               "Polynomial order")));
+        addCommand("setSlidingSums", makeCommandVoid1(*this, &NumericalDifference::setSlidingSums,
+                              docCommandVoid1("Update the fitting sums recursively in O(size) per sample, so that the cost does not depend on the window length.",
+                                              "Enable the sliding sums (bool)")));
       }
 
 
@@ -97,10 +101,13 @@ namespace dynamicgraph
           m_filter       = new QuadEstimator(winSizeEnc, x_size, m_dt);
         else
           SEND_MSG("Only polynomial orders 1 and 2 allowed. Reinitialize the filter", MSG_TYPE_INFO);
-        m_ddx_filter_std.resize(x_size);
-        m_dx_filter_std.resize(x_size);
-        m_x_filter_std.resize(x_size);
-        m_x_std.resize(x_size);
+      }
+
+      void NumericalDifference::setSlidingSums(const bool& sliding)
+      {
+        if(m_filter==NULL)
+          return SEND_MSG("Cannot set the sliding sums before initialization", MSG_TYPE_ERROR);
+        m_filter->setSlidingSums(sliding);
       }
 
       /* --- SIGNALS ---------------------------------------------------------- */
@@ -112,24 +119,14 @@ namespace dynamicgraph
       {
         sotDEBUG(15)<<"Compute x_dx_ddx inner signal "<<iter<<std::endl;
 
-        // read encoders and copy in std vector
         const dynamicgraph::Vector& base_x = m_xSIN(iter);
-        COPY_VECTOR_TO_ARRAY(base_x, m_x_std);
-
-        // Signal Filters
-        m_filter->estimate(m_x_filter_std, m_x_std);
-        m_filter->getEstimateDerivative(m_dx_filter_std, 1);
-        m_filter->getEstimateDerivative(m_ddx_filter_std, 2);
-
-        // copy data in signal vector
         if(s.size()!=3*x_size)
           s.resize(3*x_size);
-        for(int i=0; i<x_size; i++)
-          s(i) = m_x_filter_std[i];
-        for(int i=0; i<x_size; i++)
-          s(i+x_size) = m_dx_filter_std[i];
-        for(int i=0; i<x_size; i++)
-          s(i+2*x_size) = m_ddx_filter_std[i];
+
+        // Signal Filters, writing directly in the signal vector
+        m_filter->estimate(s.head(x_size), base_x);
+        m_filter->getEstimateDerivative(s.segment(x_size, x_size), 1);
+        m_filter->getEstimateDerivative(s.tail(x_size), 2);
 
         return s;
       }
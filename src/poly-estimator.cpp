@@ -38,6 +38,9 @@ PolyEstimator::PolyEstimator(const unsigned int& order,
   dt_(dt),
   dt_zero_(true),
   first_run_(true),
+  sliding_sums_(false),
+  sums_valid_(false),
+  shadow_count_(0),
   pt_(0)
 {
   t_.resize(N_);
@@ -126,6 +129,156 @@ void PolyEstimator::fit()
 }
 
 
+void PolyEstimator::initWindow(const Eigen::MatrixXd& Tmat,
+                               const unsigned int& dim)
+{
+  Eigen::MatrixXd pinvTmat(order_+1, N_);
+  pinv(Tmat, pinvTmat);
+  pinv_ = pinvTmat.transpose();
+  window_.setZero(dim, N_);
+
+  /* Time relative to the center of the window, in sampling periods */
+  time_powers_.resize(N_, order_+1);
+  for (unsigned int j = 0; j < N_; ++j)
+  {
+    double u = j - 0.5*(N_-1);
+    time_powers_(j,0) = 1.0;
+    for (unsigned int k = 1; k <= order_; ++k)
+      time_powers_(j,k) = time_powers_(j,k-1)*u;
+  }
+
+  /* The columns of pinv_ are polynomials of degree order_ in the time, so
+     they are spanned by the columns of time_powers_ */
+  Eigen::MatrixXd pinvPowers(order_+1, N_);
+  pinv(time_powers_, pinvPowers);
+  sums_to_coeff_ = pinvPowers * pinv_;
+  sums_.setZero(dim, order_+1);
+  shadow_sums_.setZero(dim, order_+1);
+}
+
+
+bool PolyEstimator::feedWindow(const Eigen::Ref<const Eigen::VectorXd>& el)
+{
+  if (sliding_sums_ && sums_valid_)
+    updateSlidingSums(el);
+
+  /* Feed Data. Note that the time is not completed since it is assumed to be
+     constant */
+  window_.col(pt_) = el;
+
+  if ( first_run_ )
+  {
+    if ( (pt_+1) < N_ )
+    {
+      pt_++;
+      return false;
+    }
+    else
+      first_run_ = false;
+  }
+
+  // Next pointer value
+  pt_ = (pt_+1) < N_ ? (pt_+1) : 0;
+  return true;
+}
+
+
+void PolyEstimator::fitWindow()
+{
+  if (sliding_sums_)
+  {
+    // The sums are computed from window_ only when the sliding sums are
+    // enabled; then the shadow sums bound the rounding errors
+    if (!sums_valid_)
+      anchorSlidingSums();
+    c_.noalias() = sums_ * sums_to_coeff_;
+    return;
+  }
+
+  // The oldest sample is in column pt_: the window is unrolled by splitting
+  // the product at the circular pointer
+  c_.noalias() = window_.rightCols(N_-pt_) * pinv_.topRows(N_-pt_);
+  if (pt_ > 0)
+    c_.noalias() += window_.leftCols(pt_) * pinv_.bottomRows(pt_);
+}
+
+
+void PolyEstimator::updateSlidingSums(const Eigen::Ref<const Eigen::VectorXd>& el)
+{
+  const double h = 0.5*(N_-1);
+
+  // Remove the oldest sample (column pt_), whose time is -h
+  double u_k = 1.0;
+  for (unsigned int k = 0; k <= order_; ++k)
+  {
+    sums_.col(k) -= u_k*window_.col(pt_);
+    u_k *= -h;
+  }
+  shiftSlidingSums(sums_);
+  addToSlidingSums(sums_, el);
+
+  // The shadow sums only contain the samples added since they were reset, so
+  // they never subtract anything: after N samples they are the moments of
+  // the whole window and replace sums_, dropping its accumulated rounding
+  // errors without recomputing the moments from window_ in a single tick
+  shiftSlidingSums(shadow_sums_);
+  addToSlidingSums(shadow_sums_, el);
+  if (++shadow_count_ == N_)
+  {
+    sums_.swap(shadow_sums_);
+    shadow_sums_.setZero();
+    shadow_count_ = 0;
+  }
+}
+
+
+void PolyEstimator::shiftSlidingSums(Eigen::MatrixXd& sums)
+{
+  // Shift the time origin by one sample: sum (u-1)^k x = sum_i C(k,i) (-1)^(k-i) sum u^i x
+  for (int k = order_; k > 0; --k)
+  {
+    double binom = 1.0;
+    for (int i = k-1; i >= 0; --i)
+    {
+      binom *= -(i+1.0)/(k-i);
+      sums.col(k) += binom*sums.col(i);
+    }
+  }
+}
+
+
+void PolyEstimator::addToSlidingSums(Eigen::MatrixXd& sums,
+                                     const Eigen::Ref<const Eigen::VectorXd>& el)
+{
+  // The new sample is the most recent one, whose time is h
+  const double h = 0.5*(N_-1);
+  double u_k = 1.0;
+  for (unsigned int k = 0; k <= order_; ++k)
+  {
+    sums.col(k) += u_k*el;
+    u_k *= h;
+  }
+}
+
+
+void PolyEstimator::anchorSlidingSums()
+{
+  sums_.noalias() = window_.rightCols(N_-pt_) * time_powers_.topRows(N_-pt_);
+  if (pt_ > 0)
+    sums_.noalias() += window_.leftCols(pt_) * time_powers_.bottomRows(pt_);
+  shadow_sums_.setZero();
+  shadow_count_ = 0;
+  sums_valid_ = true;
+}
+
+
+void PolyEstimator::setSlidingSums(const bool& sliding)
+{
+  sliding_sums_ = sliding;
+  sums_valid_ = false;
+}
+
+
 void PolyEstimator::setWindowLength(const unsigned int& N)
 {
   N_ = N;
@@ -31,8 +31,9 @@ namespace dynamicgraph
       using namespace dynamicgraph;
       using namespace dynamicgraph::command;
       using namespace std;
-//Size to be aligned                "-------------------------------------------------------"
-#define PROFILE_PWM_DES_COMPUTATION "PositionController: desired pwm computation            "
+      /// Name of the profiled section published by the signals latency and
+      /// deadline_misses, prefixed with the name of the entity
+      static const char* PROFILE_SECTION_NAME = "desired pwm computation";
 
 #define GAIN_SIGNALS      m_KpSIN << m_KdSIN << m_KiSIN
 #define REF_JOINT_SIGNALS m_qRefSIN << m_dqRefSIN
@@ -40,7 +41,7 @@ namespace dynamicgraph
 
 #define INPUT_SIGNALS     STATE_SIGNALS << REF_JOINT_SIGNALS << GAIN_SIGNALS
 
-#define OUTPUT_SIGNALS m_pwmDesSOUT << m_qErrorSOUT
+#define OUTPUT_SIGNALS m_pwmDesSOUT << m_qErrorSOUT << m_latencySOUT << m_deadline_missesSOUT
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -68,10 +69,13 @@ namespace dynamicgraph
             ,CONSTRUCT_SIGNAL_OUT(pwmDes,             dynamicgraph::Vector, INPUT_SIGNALS)
             ,CONSTRUCT_SIGNAL_OUT(qError,             dynamicgraph::Vector, m_base6d_encodersSIN <<
                                                                   m_qRefSIN)
+            ,CONSTRUCT_SIGNAL_OUT(latency,            dynamicgraph::Vector, m_pwmDesSOUT)
+            ,CONSTRUCT_SIGNAL_OUT(deadline_misses,    dynamicgraph::Vector, m_pwmDesSOUT)
             ,m_initSucceeded(false)
 	      ,m_robot_util(RefVoidRobotUtil())
       {
         Entity::signalRegistration( INPUT_SIGNALS << OUTPUT_SIGNALS );
+        m_profilePwmDes = getProfiler().get_id(name+": "+PROFILE_SECTION_NAME);
 
         /* Commands. */
         addCommand("init",
@@ -82,6 +86,10 @@ namespace dynamicgraph
         addCommand("resetIntegral",
                    makeCommandVoid0(*this, &PositionController::resetIntegral,
                                     docCommandVoid0("Reset the integral.")));
+        addCommand("setDeadline",
+                   makeCommandVoid1(*this, &PositionController::setDeadline,
+                                    docCommandVoid1("Set the maximum computation time of pwmDes, used to count the deadline misses (the control period by default).",
+                                                    "Deadline in seconds (double)")));
       }
 
       void PositionController::init(const double& dt,
@@ -121,10 +129,16 @@ namespace dynamicgraph
         m_dq.setZero(m_robot_util->m_nbJoints);
 
         resetIntegral();
+        setDeadline(dt);
 
         m_initSucceeded = true;
       }
 
+      void PositionController::setDeadline(const double& deadline)
+      {
+        getProfiler().set_deadline(m_profilePwmDes, deadline);
+      }
+
       void PositionController::resetIntegral()
       {
         m_e_integral.setZero(m_robot_util->m_nbJoints);
@@ -142,7 +156,7 @@ namespace dynamicgraph
           return s;
         }
 
-        getProfiler().start(PROFILE_PWM_DES_COMPUTATION);
+        getProfiler().start(m_profilePwmDes);
         {
           const VectorN& Kp =        m_KpSIN(iter); // n
           const VectorN& Kd =        m_KdSIN(iter); // n
@@ -164,8 +178,22 @@ namespace dynamicgraph
           s.resize(m_robot_util->m_nbJoints);
 	s = m_pwmDes;
         }
-        getProfiler().stop(PROFILE_PWM_DES_COMPUTATION);
+        getProfiler().stop(m_profilePwmDes);
+
+        return s;
+      }
 
+      DEFINE_SIGNAL_OUT_FUNCTION(latency,dynamicgraph::Vector)
+      {
+        m_pwmDesSOUT(iter);
+        getProfiler().get_latencies(&m_profilePwmDes, 1, s);
+        return s;
+      }
+
+      DEFINE_SIGNAL_OUT_FUNCTION(deadline_misses,dynamicgraph::Vector)
+      {
+        m_pwmDesSOUT(iter);
+        getProfiler().get_deadline_misses(&m_profilePwmDes, 1, s);
         return s;
       }
 
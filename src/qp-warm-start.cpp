@@ -0,0 +1,278 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/utils/qp-warm-start.hh>
+
+/// Same regularization as the eiquadprog solvers of tsid
+#define HESSIAN_REGULARIZATION 1e-8
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      using namespace tsid::math;
+      using namespace tsid::solvers;
+
+      QpWarmStart::QpWarmStart()
+        : m_n(0)
+        , m_neq(0)
+        , m_nin(0)
+        , m_tol(1e-6)
+        , m_seeded(false)
+        , m_H_chol_valid(false)
+      {}
+
+      void QpWarmStart::resize(unsigned int n, unsigned int neq, unsigned int nin)
+      {
+        if(n==m_n && neq==m_neq && nin==m_nin)
+          return;
+        m_n = n;
+        m_neq = neq;
+        m_nin = nin;
+
+        m_H.setZero(n, n);
+        m_g.setZero(n);
+
+        m_H_chol = Eigen::LLT<Matrix>(n);
+        m_H_factorized.setZero(n, n);
+        m_H_chol_valid = false;
+        m_C.setZero(neq+2*nin, n);
+        m_c0.setZero(neq+2*nin);
+        m_M.setZero(n, neq+2*nin);
+        m_S.setZero(neq+2*nin, neq+2*nin);
+        m_w.setZero(n);
+        m_lambda.setZero(neq+2*nin);
+        m_slack.setZero(nin);
+
+        m_layout.reserve(2*nin);
+        m_activeSet.reserve(2*nin);
+        m_activeIndex.reserve(2*nin);
+
+        m_output.x.setZero(n);
+        m_output.lambda.setZero(neq+2*nin);
+        m_output.activeSet.setZero(2*nin);
+      }
+
+      void QpWarmStart::reset()
+      {
+        m_activeSet.clear();
+        m_seeded = false;
+      }
+
+      void QpWarmStart::computeLayout(const HQPData & problemData)
+      {
+        m_layout.clear();
+        if(problemData.size()==0)
+          return;
+        int i_in = 0;
+        const ConstraintLevel & cl0 = problemData[0];
+        for(ConstraintLevel::const_iterator it=cl0.begin(); it!=cl0.end(); it++)
+        {
+          const ConstraintBase* constr = it->second;
+          if(constr->isInequality() || constr->isBound())
+          {
+            ConstraintBlock b;
+            b.constr = constr;
+            b.index = i_in;
+            b.rows = constr->rows();
+            m_layout.push_back(b);
+            i_in += 2*constr->rows();
+          }
+        }
+      }
+
+      void QpWarmStart::computeMatrices(const HQPData & problemData)
+      {
+        int i_eq = 0;
+        const ConstraintLevel & cl0 = problemData[0];
+        for(ConstraintLevel::const_iterator it=cl0.begin(); it!=cl0.end(); it++)
+        {
+          const ConstraintBase* constr = it->second;
+          if(constr->isEquality())
+          {
+            const int rows = constr->rows();
+            m_C.middleRows(i_eq, rows) = constr->matrix();
+            m_c0.segment(i_eq, rows)   = -constr->vector();
+            i_eq += rows;
+          }
+        }
+
+        m_H.setZero();
+        m_g.setZero();
+        if(problemData.size()>1)
+        {
+          const ConstraintLevel & cl1 = problemData[1];
+          for(ConstraintLevel::const_iterator it=cl1.begin(); it!=cl1.end(); it++)
+          {
+            const double & w = it->first;
+            const ConstraintBase* constr = it->second;
+            m_H.noalias() += w*constr->matrix().transpose()*constr->matrix();
+            m_g.noalias() -= w*(constr->matrix().transpose()*constr->vector());
+          }
+        }
+        m_H.diagonal().array() += HESSIAN_REGULARIZATION;
+      }
+
+      void QpWarmStart::setActiveRow(const ActiveIndex & a, int i)
+      {
+        const ConstraintBase* constr = m_layout[a.block].constr;
+        if(constr->isBound())
+        {
+          m_C.row(i).setZero();
+          m_C(i, a.row) = a.upper ? -1.0 : 1.0;
+        }
+        else if(a.upper)
+          m_C.row(i) = -constr->matrix().row(a.row);
+        else
+          m_C.row(i) = constr->matrix().row(a.row);
+        m_c0(i) = a.upper ? constr->upperBound()(a.row) : -constr->lowerBound()(a.row);
+      }
+
+      bool QpWarmStart::isPrimalFeasible(const Vector & x)
+      {
+        for(std::size_t j=0; j<m_layout.size(); j++)
+        {
+          const ConstraintBase* constr = m_layout[j].constr;
+          const int rows = m_layout[j].rows;
+          if(constr->isBound())
+            m_slack.head(rows) = x.head(rows);
+          else
+            m_slack.head(rows).noalias() = constr->matrix()*x;
+          if(((m_slack.head(rows)-constr->lowerBound()).array() < -m_tol).any() ||
+             ((constr->upperBound()-m_slack.head(rows)).array() < -m_tol).any())
+            return false;
+        }
+        return true;
+      }
+
+      bool QpWarmStart::solve(const HQPData & problemData)
+      {
+        if(!m_seeded || problemData.size()==0)
+          return false;
+
+        // map the stored active set on the constraint blocks of the current problem
+        computeLayout(problemData);
+        m_activeIndex.clear();
+        for(std::size_t i=0; i<m_activeSet.size(); i++)
+        {
+          const ActiveRow & a = m_activeSet[i];
+          for(std::size_t j=0; j<m_layout.size(); j++)
+          {
+            if(m_layout[j].constr==a.constr && a.row<m_layout[j].rows)
+            {
+              ActiveIndex ai;
+              ai.block = (int) j;
+              ai.row = a.row;
+              ai.upper = a.upper;
+              m_activeIndex.push_back(ai);
+              break;
+            }
+          }
+        }
+
+        // stack equalities and active inequalities in C x + c0 = 0
+        computeMatrices(problemData);
+        const int na = (int) m_activeIndex.size();
+        const int m = m_neq + na;
+        for(int i=0; i<na; i++)
+          setActiveRow(m_activeIndex[i], m_neq+i);
+
+        // The Hessian only depends on the tasks of level 1, so its
+        // factorization can often be reused from the previous cycle
+        if(!m_H_chol_valid || m_H!=m_H_factorized)
+        {
+          m_H_chol.compute(m_H);
+          m_H_chol_valid = m_H_chol.info()==Eigen::Success;
+          if(!m_H_chol_valid)
+            return false;
+          m_H_factorized = m_H;
+        }
+
+        // Range-space solution of the KKT system:
+        //   S lambda = C H^{-1} g - c0,   x = H^{-1} (C^T lambda - g)
+        m_M.leftCols(m) = m_C.topRows(m).transpose();
+        m_H_chol.matrixL().solveInPlace(m_M.leftCols(m));
+        m_w = m_g;
+        m_H_chol.matrixL().solveInPlace(m_w);
+
+        m_S.topLeftCorner(m, m).noalias() = m_M.leftCols(m).transpose()*m_M.leftCols(m);
+        m_lambda.head(m).noalias() = m_M.leftCols(m).transpose()*m_w;
+        m_lambda.head(m) -= m_c0.head(m);
+
+        Eigen::Ref<Matrix> S = m_S.topLeftCorner(m, m);
+        Eigen::LLT<Eigen::Ref<Matrix> > S_chol(S);   // in-place factorization
+        if(S_chol.info()!=Eigen::Success)
+          return false;   // active constraints are linearly dependent
+        S_chol.solveInPlace(m_lambda.head(m));
+
+        // dual feasibility of the active inequalities
+        for(int i=0; i<na; i++)
+          if(m_lambda(m_neq+i) < -m_tol)
+            return false;
+
+        m_output.x.noalias() = m_M.leftCols(m)*m_lambda.head(m);
+        m_output.x -= m_w;
+        m_H_chol.matrixU().solveInPlace(m_output.x);
+
+        // primal feasibility of all the inequalities
+        if(!m_output.x.allFinite() || !isPrimalFeasible(m_output.x))
+          return false;
+
+        m_output.status = HQP_STATUS_OPTIMAL;
+        m_output.iterations = 0;
+        m_output.lambda.setZero();
+        m_output.lambda.head(m) = m_lambda.head(m);
+        m_output.activeSet.fill(-1);
+        for(int i=0; i<na; i++)
+        {
+          const ActiveIndex & a = m_activeIndex[i];
+          const ConstraintBlock & b = m_layout[a.block];
+          m_output.activeSet(i) = b.index + a.row + (a.upper ? b.rows : 0);
+        }
+        return true;
+      }
+
+      void QpWarmStart::store(const HQPData & problemData, const HQPOutput & sol)
+      {
+        m_activeSet.clear();
+        computeLayout(problemData);
+        for(int i=0; i<sol.activeSet.size(); i++)
+        {
+          const int index = sol.activeSet(i);
+          if(index<0)
+            break;
+          for(std::size_t j=0; j<m_layout.size(); j++)
+          {
+            const ConstraintBlock & b = m_layout[j];
+            if(index>=b.index && index<b.index+2*b.rows)
+            {
+              ActiveRow a;
+              a.constr = b.constr;
+              a.upper = index >= b.index+b.rows;
+              a.row = index - b.index - (a.upper ? b.rows : 0);
+              m_activeSet.push_back(a);
+              break;
+            }
+          }
+        }
+        m_seeded = true;
+      }
+
+    } // namespace torquecontrol
+  } // namespace sot
+} // namespace dynamicgraph
@@ -37,7 +37,6 @@ QuadEstimator::QuadEstimator(const unsigned int& N,
   if (!dt_zero_) 
   {
     Eigen::MatrixXd Tmat(N_, 3);
-    Eigen::MatrixXd pinvTmat(3, N_);
     double time = 0.0;
     for (unsigned int i = 0; i < N_; ++i) 
     {
@@ -49,26 +48,10 @@ QuadEstimator::QuadEstimator(const unsigned int& N,
     /* Half time used to estimate velocity and position*/
     tmed_ = time*0.5;
 
-    /* Pseudo inverse */
-    pinv(Tmat, pinvTmat);
-    pinv0_ = new double[N_];
-    pinv1_ = new double[N_];
-    pinv2_ = new double[N_];
-    c0_.resize(dim_);
-    c1_.resize(dim_);
-    c2_.resize(dim_);
-    c0_.assign(dim_, 0.0);
-    c1_.assign(dim_, 0.0);
-    c2_.assign(dim_, 0.0);
-
-    /* Copy the pseudo inverse to an array */
-    for(unsigned int i = 0; i < N_; ++i) 
-    {
-      pinv2_[i] = pinvTmat(2,i);
-      pinv1_[i] = pinvTmat(1,i);
-      pinv0_[i] = pinvTmat(0,i);
-    }
+    /* Pseudo inverse and window */
+    initWindow(Tmat, dim_);
   }
+  c_.setZero(dim_, 3);
 
 }
 
@@ -219,83 +202,59 @@ void QuadEstimator::fit()
 
 void QuadEstimator::estimate(std::vector<double>& esteem,
                             const std::vector<double>& el)
+{
+  Eigen::Map<Eigen::VectorXd> esteem_map(&esteem[0], esteem.size());
+  estimate(esteem_map, Eigen::Map<const Eigen::VectorXd>(&el[0], el.size()));
+}
+
+void QuadEstimator::estimate(Eigen::Ref<Eigen::VectorXd> esteem,
+                            const Eigen::Ref<const Eigen::VectorXd>& el)
 {
   if (dt_zero_)
   {
     std::cerr << "Error: dt cannot be zero" << std::endl;
     // Return a zero vector
-    for (unsigned int i = 0; i < esteem.size(); ++i)
-      esteem[i]  = 0.0;
+    esteem.setZero();
     return;
   }
 
-  /* Feed Data. Note that the time is not completed since it is assumed to be
-     constant */
-  elem_list_[pt_] = el;
-
-  if ( first_run_ )
+  if (!feedWindow(el))
   {
-    if ( (pt_+1) < N_ )
-    {
-      // Return input vector when not enough elements to compute
-      pt_++;
-      for (unsigned int i = 0; i < esteem.size(); ++i)
-        esteem[i] = el[i];
-      return;
-    }
-    else
-      first_run_ = false;
-  }
-
-  // Next pointer value
-  pt_ = (pt_+1) < N_ ? (pt_+1) : 0;
-
-  unsigned int idx;
-
-  double x;
-  // Cycle all the elements in the vector
-  for (int i = 0; i < dim_; ++i)
-  {
-    c0_[i] = 0.0; c1_[i] = 0.0; c2_[i] = 0.0;
-    // Retrieve the data in the window
-    for (int j = 0; j < N_; ++j)
-    {
-      idx = (pt_+j);
-      if (idx >= N_ ) idx -= N_;
-      x = elem_list_[idx][i];
-      c0_[i] += x*pinv0_[j];
-      c1_[i] += x*pinv1_[j];
-      c2_[i] += x*pinv2_[j];
-    }
-
-    // Polynomial (position)
-    esteem[i] = 0.5*c2_[i]*tmed_*tmed_ + c1_[i]*tmed_ + c0_[i];
+    // Return input vector when not enough elements to compute
+    esteem = el;
+    return;
   }
+  fitWindow();
 
+  // Polynomial (position)
+  esteem = 0.5*tmed_*tmed_*c_.col(2) + tmed_*c_.col(1) + c_.col(0);
 }
 
 void QuadEstimator::getEstimateDerivative(std::vector<double>& estimateDerivative,
                                    const unsigned int order)
+{
+  Eigen::Map<Eigen::VectorXd> derivative_map(&estimateDerivative[0], dim_);
+  getEstimateDerivative(derivative_map, order);
+}
+
+void QuadEstimator::getEstimateDerivative(Eigen::Ref<Eigen::VectorXd> estimateDerivative,
+                                   const unsigned int order)
 {
   switch(order)
   {
     case 0:
-      for (int i = 0; i < dim_; ++i)
-        estimateDerivative[i] = 0.5*c2_[i]*tmed_*tmed_ + c1_[i]*tmed_ + c0_[i];
+      estimateDerivative = 0.5*tmed_*tmed_*c_.col(2) + tmed_*c_.col(1) + c_.col(0);
       return;
 
     case 1:
-      for (int i = 0; i < dim_; ++i)
-        estimateDerivative[i] = c2_[i]*tmed_ + c1_[i];
+      estimateDerivative = tmed_*c_.col(2) + c_.col(1);
       return;
 
     case 2:
-      for (int i = 0; i < dim_; ++i)
-        estimateDerivative[i] = c2_[i];
+      estimateDerivative = c_.col(2);
       return;
 
     default:
-      for (int i = 0; i < dim_; ++i)
-        estimateDerivative[i] = 0.0;
+      estimateDerivative.setZero();
   }
 }
@@ -33,7 +33,7 @@ namespace dynamicgraph
       using namespace std;
       using namespace Eigen;
 
-#define PROFILE_SE3_POSITION_DESIRED_COMPUTATION "SE3TrajGen: traj computation"
+STOP_WATCH_REGISTER(PROFILE_SE3_POSITION_DESIRED_COMPUTATION, "SE3TrajGen: traj computation");
 
       /// Define EntityClassName here rather than in the header file
       /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/simulation-runner.hh>
+#include <sot/core/debug.hh>
+#include <dynamic-graph/factory.h>
+#include <dynamic-graph/pool.h>
+
+#include <stdexcept>
+#include <sot/torque_control/commands-helper.hh>
+#include <sot/torque_control/utils/trace-file.hh>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      namespace dynamicgraph = ::dynamicgraph;
+      using namespace dynamicgraph;
+      using namespace dynamicgraph::command;
+      using namespace std;
+      using namespace dynamicgraph::sot::torque_control;
+
+      /// Define EntityClassName here rather than in the header file
+      /// so that it can be used by the macros DEFINE_SIGNAL_**_FUNCTION.
+      typedef SimulationRunner EntityClassName;
+
+      /* --- DG FACTORY ---------------------------------------------------- */
+      DYNAMICGRAPH_FACTORY_ENTITY_PLUGIN(SimulationRunner,
+                                         "SimulationRunner");
+
+      /* ------------------------------------------------------------------- */
+      /* --- CONSTRUCTION -------------------------------------------------- */
+      /* ------------------------------------------------------------------- */
+      SimulationRunner::
+      SimulationRunner(const std::string& name)
+        : Entity(name)
+        ,m_initSucceeded(false)
+        ,m_device(NULL)
+      {
+        /* Commands. */
+        addCommand("init",
+                   makeCommandVoid1(*this, &SimulationRunner::init,
+                                    docCommandVoid1("Initialize the entity.",
+                                                    "Name of the device to step (string)")));
+
+        addCommand("addRecordedSignal",
+                   makeCommandVoid2(*this, &SimulationRunner::addRecordedSignal,
+                                    docCommandVoid2("Record a vector signal during the simulation",
+                                                    "Name of the signal to record, as entity.signal (string)",
+                                                    "Name of the output signal of the recorded data (string)")));
+
+        addCommand("run",
+                   makeCommandVoid3(*this, &SimulationRunner::run,
+                                    docCommandVoid3("Run the simulation, recording the signals",
+                                                    "Time step of the device (double)",
+                                                    "Number of time steps to simulate (int)",
+                                                    "Number of time steps between two records (int)")));
+
+        addCommand("saveRecordedSignal",
+                   makeCommandVoid2(*this, &SimulationRunner::saveRecordedSignal,
+                                    docCommandVoid2("Save the data recorded during the last simulation in a binary trace file",
+                                                    "Name of the output signal of the recorded data (string)",
+                                                    "Name of the binary file to write (string)")));
+
+        addCommand("clear",
+                   makeCommandVoid0(*this, &SimulationRunner::clear,
+                                    docCommandVoid0("Remove all the recorded signals.")));
+      }
+
+      SimulationRunner::~SimulationRunner()
+      {
+        clear();
+      }
+
+      void SimulationRunner::init(const std::string& deviceName)
+      {
+        m_initSucceeded = false;
+        if(!PoolStorage::getInstance()->existEntity(deviceName))
+          return SEND_MSG("There is no entity with name "+deviceName, MSG_TYPE_ERROR);
+        m_device = dynamic_cast<dynamicgraph::sot::Device*>(&PoolStorage::getInstance()->getEntity(deviceName));
+        if(m_device==NULL)
+          return SEND_MSG("Entity "+deviceName+" is not a device", MSG_TYPE_ERROR);
+        m_initSucceeded = true;
+      }
+
+      /* --- COMMANDS ---------------------------------------------------------- */
+
+      void SimulationRunner::addRecordedSignal(const string& signalName,
+                                               const string& outputSignalName)
+      {
+        if(m_recorded.find(outputSignalName) != m_recorded.end())
+          return SEND_MSG("It already exists a signal with name "+outputSignalName, MSG_TYPE_ERROR);
+
+        InputSignalType* signal = NULL;
+        try
+        {
+          istringstream signalPath(signalName);
+          signal = dynamic_cast<InputSignalType*>(&PoolStorage::getInstance()->getSignal(signalPath));
+        }
+        catch (const ExceptionAbstract& e)
+        {
+          return SEND_MSG("Cannot find signal "+signalName+": "+e.getStringMessage(), MSG_TYPE_ERROR);
+        }
+        catch (const std::exception& e)
+        {
+          return SEND_MSG("Cannot find signal "+signalName+": "+e.what(), MSG_TYPE_ERROR);
+        }
+        if(signal==NULL)
+          return SEND_MSG("Signal "+signalName+" is not a vector signal", MSG_TYPE_ERROR);
+
+        RecordedSignal* recorded = new RecordedSignal();
+        recorded->signal = signal;
+        recorded->output = new OutputSignalType(getClassName()+"("+getName()+
+                                                ")::output(dynamicgraph::Matrix)::"+
+                                                outputSignalName);
+        m_recorded[outputSignalName] = recorded;
+        Entity::signalRegistration(*recorded->output);
+      }
+
+      void SimulationRunner::run(const double& dt, const int& nbTimeSteps, const int& recordingPeriod)
+      {
+        if(!m_initSucceeded)
+          return SEND_MSG("Cannot run the simulation before initializing the entity", MSG_TYPE_ERROR);
+        if(dt<=0.0 || nbTimeSteps<=0 || recordingPeriod<=0)
+          return SEND_MSG("Time step, number of time steps and recording period must be positive", MSG_TYPE_ERROR);
+
+        typedef std::map<std::string, RecordedSignal*>::iterator it_type;
+        const int nbRecords = (nbTimeSteps+recordingPeriod-1)/recordingPeriod;
+        try
+        {
+          for(it_type it=m_recorded.begin(); it!=m_recorded.end(); it++)
+          {
+            RecordedSignal& r = *it->second;
+            const Vector& v = (*r.signal)(m_device->stateSOUT.getTime());
+            r.buffer.resize(v.size(), nbRecords);
+          }
+        }
+        catch (const ExceptionAbstract& e)
+        {
+          return SEND_MSG("Cannot evaluate the recorded signals: "+e.getStringMessage(), MSG_TYPE_ERROR);
+        }
+        catch (const std::exception& e)
+        {
+          return SEND_MSG("Cannot evaluate the recorded signals: "+string(e.what()), MSG_TYPE_ERROR);
+        }
+
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        int i = 0, k = 0;
+        bool ok = true;
+        try
+        {
+          for(i=0; ok && i<nbTimeSteps; i++)
+          {
+            m_device->increment(dt);
+            if(i%recordingPeriod!=0)
+              continue;
+            const int t = m_device->stateSOUT.getTime();
+            for(it_type it=m_recorded.begin(); it!=m_recorded.end(); it++)
+            {
+              RecordedSignal& r = *it->second;
+              const Vector& v = (*r.signal)(t);
+              if(v.size()!=r.buffer.rows())
+              {
+                SEND_MSG("Size of signal "+it->first+" changed from "+toString(r.buffer.rows())+
+                         " to "+toString(v.size())+" at time step "+toString(i), MSG_TYPE_ERROR);
+                ok = false;
+                break;
+              }
+              r.buffer.col(k) = v;
+            }
+            if(ok)
+              k++;
+          }
+        }
+        catch (const ExceptionAbstract& e)
+        {
+          SEND_MSG("Simulation stopped at time step "+toString(i)+": "+e.getStringMessage(), MSG_TYPE_ERROR);
+        }
+        catch (const std::exception& e)
+        {
+          SEND_MSG("Simulation stopped at time step "+toString(i)+": "+e.what(), MSG_TYPE_ERROR);
+        }
+        const double elapsed = 1e-6*(boost::posix_time::microsec_clock::universal_time()-start).total_microseconds();
+
+        // records not reached because of an error are discarded
+        for(it_type it=m_recorded.begin(); it!=m_recorded.end(); it++)
+        {
+          RecordedSignal& r = *it->second;
+          r.buffer.conservativeResize(Eigen::NoChange, k);
+          r.output->setConstant(r.buffer.transpose());
+        }
+        SEND_MSG("Simulated "+toString(i*dt)+" s in "+toString(elapsed)+" s ("+
+                 toString(i*dt/elapsed)+" times real time)", MSG_TYPE_INFO);
+      }
+
+      void SimulationRunner::saveRecordedSignal(const string& outputSignalName,
+                                                const string& fileName)
+      {
+        std::map<std::string, RecordedSignal*>::iterator it = m_recorded.find(outputSignalName);
+        if(it == m_recorded.end())
+          return SEND_MSG("There is no recorded signal with name "+outputSignalName, MSG_TYPE_ERROR);
+        string error;
+        if(!writeBinaryTrace(fileName, it->second->buffer, error))
+          return SEND_MSG(error, MSG_TYPE_ERROR);
+      }
+
+      void SimulationRunner::clear()
+      {
+        typedef std::map<std::string, RecordedSignal*>::iterator it_type;
+        for(it_type it=m_recorded.begin(); it!=m_recorded.end(); it++)
+        {
+          Entity::signalDeregistration(it->first);
+          delete it->second->output;
+          delete it->second;
+        }
+        m_recorded.clear();
+      }
+
+      /* ------------------------------------------------------------------- */
+      /* --- ENTITY -------------------------------------------------------- */
+      /* ------------------------------------------------------------------- */
+
+
+      void SimulationRunner::display(std::ostream& os) const
+      {
+        os << "SimulationRunner "<<getName();
+      }
+
+    } // namespace torquecontrol
+  } // namespace sot
+} // namespace dynamicgraph
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/utils/statistics.hh>
+#include <boost/thread/tss.hpp>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      /** The statistics set with setThreadStatistics are owned by the caller */
+      static void keepThreadStatistics(::Statistics*) {}
+
+      static boost::thread_specific_ptr< ::Statistics >& threadStatistics()
+      {
+        static boost::thread_specific_ptr< ::Statistics > p(&keepThreadStatistics);
+        return p;
+      }
+
+      ::Statistics& getStatistics()
+      {
+        ::Statistics* t = threadStatistics().get();
+        return t!=NULL ? *t : ::getStatistics();
+      }
+
+      void setThreadStatistics(::Statistics* statistics)
+      {
+        threadStatistics().reset(statistics);
+      }
+
+    } // namespace torque_control
+  } // namespace sot
+} // namespace dynamicgraph
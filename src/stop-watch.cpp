@@ -27,37 +27,69 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "sot/torque_control/utils/Stdafx.hh"
 
 #ifndef WIN32
-	#include <sys/time.h>
+	#include <time.h>
 #else
 	#include <Windows.h>
 	#include <iomanip>
 #endif
 
 #include <iomanip>      // std::setprecision
+#include <algorithm>    // std::nth_element
+#include <cmath>
 #include "sot/torque_control/utils/stop-watch.hh"
+#include <boost/thread/tss.hpp>
 
 using std::map;
 using std::string;
 using std::ostringstream;
 
-//#define START_PROFILER(name) getProfiler().start(name)
-//#define STOP_PROFILER(name) getProfiler().stop(name)
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+/** The profilers set with setThreadProfiler are owned by the caller */
+static void keepThreadProfiler(Stopwatch*) {}
+
+static boost::thread_specific_ptr<Stopwatch>& threadProfiler()
+{
+  static boost::thread_specific_ptr<Stopwatch> p(&keepThreadProfiler);
+  return p;
+}
 
 Stopwatch& getProfiler()
 {
   static Stopwatch s(REAL_TIME);   // alternatives are CPU_TIME and REAL_TIME
-  return s;
+  Stopwatch* t = threadProfiler().get();
+  return t!=NULL ? *t : s;
+}
+
+void setThreadProfiler(Stopwatch* profiler)
+{
+  threadProfiler().reset(profiler);
+}
+
+/** Index of the histogram bin of a time lapse, i.e. floor(log2(lapse)) */
+static inline int histogram_bin(int64_t lapse)
+{
+  if(lapse<=1)
+    return 0;
+#ifdef __GNUC__
+  int bin = 63 - __builtin_clzll((unsigned long long) lapse);
+#else
+  int bin = 0;
+  while(lapse >>= 1)
+    bin++;
+#endif
+  return bin<STOP_WATCH_HISTOGRAM_SIZE ? bin : STOP_WATCH_HISTOGRAM_SIZE-1;
 }
 
 Stopwatch::Stopwatch(StopwatchMode _mode) 
   : active(true), mode(_mode)  
 {
-  records_of = new map<string, PerformanceData>();
 }
 
 Stopwatch::~Stopwatch() 
 {
-  delete records_of;
 }
 
 void Stopwatch::set_mode(StopwatchMode new_mode) 
@@ -67,16 +99,62 @@ void Stopwatch::set_mode(StopwatchMode new_mode)
 
 bool Stopwatch::performance_exists(string perf_name) 
 {
-  return (records_of->find(perf_name) != records_of->end());
+  return (ids_of.find(perf_name) != ids_of.end());
+}
+
+StopwatchId Stopwatch::get_id(const string & perf_name)
+{
+  map<string, StopwatchId>::iterator it = ids_of.find(perf_name);
+  if(it != ids_of.end())
+    return it->second;
+
+  StopwatchId id = (StopwatchId) records.size();
+  records.push_back(PerformanceData());
+  records.back().name = perf_name;
+  records.back().window.resize(STOP_WATCH_WINDOW_SIZE, 0);
+  records.back().window_scratch.resize(STOP_WATCH_WINDOW_SIZE, 0);
+  ids_of.insert(make_pair(perf_name, id));
+  return id;
+}
+
+StopwatchId Stopwatch::find_id(const string & perf_name)
+{
+  map<string, StopwatchId>::iterator it = ids_of.find(perf_name);
+  if(it == ids_of.end())
+    throw StopwatchException("Performance not initialized.");
+  return it->second;
+}
+
+Stopwatch::PerformanceData& Stopwatch::get_record(const string & perf_name)
+{
+  return records[find_id(perf_name)];
+}
+
+Stopwatch::PerformanceData& Stopwatch::get_record(StopwatchId id)
+{
+  if(id<0 || id>=(StopwatchId)records.size())
+    throw StopwatchException("Performance not initialized.");
+  return records[id];
 }
 
 long double Stopwatch::take_time() 
+{
+  return take_time_ns()*1e-9L;
+}
+
+int64_t Stopwatch::take_time_ns()
 {
   if ( mode == CPU_TIME ) {
-    
+
+#ifdef WIN32
     // Use ctime
-    return clock();
-    
+    return (int64_t)(clock() * (1e9 / CLOCKS_PER_SEC));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+#endif
+
   } else if ( mode == REAL_TIME ) {
     
     // Query operating system
@@ -92,21 +170,18 @@ long double Stopwatch::take_time()
     intervals.LowPart = ft.dwLowDateTime;
     intervals.HighPart = ft.dwHighDateTime;
     
-    long double measure = intervals.QuadPart;
-    measure -= 116444736000000000.0;	// Convert to UNIX epoch time
-    measure /= 10000000.0;		// Convert to seconds
-    
-    return measure;
+    return (int64_t) intervals.QuadPart * 100;
 #else
     /* Linux, MacOS, ... */
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    
-    long double measure = tv.tv_usec;
-    measure /= 1000000.0;		// Convert to seconds
-    measure += tv.tv_sec;		// Add seconds part
-    
-    return measure;
+    /* Monotonic clock, not affected by the adjustments of the system time.
+       It is read through the vDSO, without entering the kernel. */
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
 #endif
     
   } else {
@@ -120,12 +195,17 @@ void Stopwatch::start(string perf_name)
   if (!active) return;
   
   // Just works if not already present
-  records_of->insert(make_pair(perf_name, PerformanceData()));
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
+  start(get_id(perf_name));
+}
+
+void Stopwatch::start(StopwatchId id)
+{
+  if (!active) return;
+
+  PerformanceData& perf_info = get_record(id);
   
   // Take ctime
-  perf_info.clock_start = take_time();
+  perf_info.clock_start = take_time_ns();
   
   // If this is a new start (i.e. not a restart)
 //  if (!perf_info.paused)
@@ -138,23 +218,24 @@ void Stopwatch::stop(string perf_name)
 {
   if (!active) return;
   
-  long double clock_end = take_time();
+  stop(find_id(perf_name));
+}
+
+void Stopwatch::stop(StopwatchId id)
+{
+  if (!active) return;
+
+  int64_t clock_end = take_time_ns();
   
   // Try to recover performance data
-  if ( !performance_exists(perf_name) )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
+  PerformanceData& perf_info = get_record(id);
   
   // check whether the performance has been reset
   if(perf_info.clock_start==0)
     return;
 
   perf_info.stops++;
-  long double  lapse = clock_end - perf_info.clock_start;
-  
-  if ( mode == CPU_TIME )
-    lapse /= (double) CLOCKS_PER_SEC;
+  int64_t lapse = clock_end - perf_info.clock_start;
   
   // Update last time
   perf_info.last_time = lapse;
@@ -166,25 +247,48 @@ void Stopwatch::stop(string perf_name)
   
   // Update total time
   perf_info.total_time += lapse;
+
+  perf_info.histogram[histogram_bin(lapse)]++;
+
+  // Update sliding window, removing the oldest measurement when full
+  int64_t removed = -1;
+  if(perf_info.window_count==STOP_WATCH_WINDOW_SIZE)
+    removed = perf_info.window[perf_info.window_index];
+  else
+    perf_info.window_count++;
+  perf_info.window[perf_info.window_index] = lapse;
+  perf_info.window_index = (perf_info.window_index+1) % STOP_WATCH_WINDOW_SIZE;
+  // the window is only scanned when its maximum leaves it
+  if(lapse >= perf_info.window_max_time)
+    perf_info.window_max_time = lapse;
+  else if(removed == perf_info.window_max_time)
+    perf_info.window_max_time = window_max(perf_info);
+
+  if(perf_info.deadline>0 && lapse>perf_info.deadline)
+    perf_info.deadline_misses++;
 }
 
 void Stopwatch::pause(string perf_name) 
 {
   if (!active) return;
   
-  long double  clock_end = clock();
+  pause(find_id(perf_name));
+}
+
+void Stopwatch::pause(StopwatchId id)
+{
+  if (!active) return;
+
+  int64_t clock_end = take_time_ns();
   
   // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
+  PerformanceData& perf_info = get_record(id);
 
   // check whether the performance has been reset
   if(perf_info.clock_start==0)
     return;
 
-  long double  lapse = clock_end - perf_info.clock_start;
+  int64_t lapse = clock_end - perf_info.clock_start;
   
   // Update total time
   perf_info.last_time += lapse;
@@ -195,10 +299,8 @@ void Stopwatch::reset_all()
 {
   if (!active) return;
   
-  map<string, PerformanceData>::iterator it;
-  
-  for (it = records_of->begin(); it != records_of->end(); ++it) {
-    reset(it->first);
+  for (StopwatchId id = 0; id < (StopwatchId)records.size(); ++id) {
+    reset(id);
   }
 }
 
@@ -206,10 +308,11 @@ void Stopwatch::report_all(int precision, std::ostream& output)
 {
   if (!active) return;
   
-  output<< "\n*** PROFILING RESULTS [ms] (min - avg - max - lastTime - nSamples - totalTime) ***\n";
-  map<string, PerformanceData>::iterator it;
-  for (it = records_of->begin(); it != records_of->end(); ++it) {
-    report(it->first, precision, output);
+  output<< "\n*** PROFILING RESULTS [ms] (min - avg - max - lastTime - nSamples - totalTime - p50 - p99 of the last "
+        << STOP_WATCH_WINDOW_SIZE << ") ***\n";
+  map<string, StopwatchId>::iterator it;
+  for (it = ids_of.begin(); it != ids_of.end(); ++it) {
+    report(it->second, precision, output);
   }
 }
 
@@ -217,11 +320,15 @@ void Stopwatch::reset(string perf_name)
 {
   if (!active) return;
   
+  reset(find_id(perf_name));
+}
+
+void Stopwatch::reset(StopwatchId id)
+{
+  if (!active) return;
+
   // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
+  PerformanceData& perf_info = get_record(id);
   
   perf_info.clock_start = 0;
   perf_info.total_time = 0;
@@ -230,6 +337,12 @@ void Stopwatch::reset(string perf_name)
   perf_info.last_time = 0;
   perf_info.paused = false;
   perf_info.stops = 0;
+  for(int i=0; i<STOP_WATCH_HISTOGRAM_SIZE; i++)
+    perf_info.histogram[i] = 0;
+  perf_info.window_index = 0;
+  perf_info.window_count = 0;
+  perf_info.window_max_time = 0;
+  perf_info.deadline_misses = 0;
 }
 
 void Stopwatch::turn_on() 
@@ -248,101 +361,214 @@ void Stopwatch::report(string perf_name, int precision, std::ostream& output)
 {
   if (!active) return;
   
+  report(find_id(perf_name), precision, output);
+}
+
+void Stopwatch::report(StopwatchId id, int precision, std::ostream& output)
+{
+  if (!active) return;
+
   // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
+  PerformanceData& perf_info = get_record(id);
   
   string pad = "";
-  for (int i = perf_name.length(); i<STOP_WATCH_MAX_NAME_LENGTH; i++)
+  for (int i = perf_info.name.length(); i<STOP_WATCH_MAX_NAME_LENGTH; i++)
     pad.append(" ");
   
-  output << perf_name << pad;
+  output << perf_info.name << pad;
   output << std::fixed << std::setprecision(precision) 
-         << (perf_info.min_time*1e3) << "\t";
+         << (perf_info.min_time*1e-6) << "\t";
   output << std::fixed << std::setprecision(precision) 
-         << (perf_info.total_time*1e3 / (long double) perf_info.stops) << "\t";
+         << (perf_info.total_time*1e-6 / (long double) perf_info.stops) << "\t";
   output << std::fixed << std::setprecision(precision) 
-         << (perf_info.max_time*1e3) << "\t";
+         << (perf_info.max_time*1e-6) << "\t";
+  output << std::fixed << std::setprecision(precision)
+         << (perf_info.last_time*1e-6) << "\t";
   output << std::fixed << std::setprecision(precision)
-         << (perf_info.last_time*1e3) << "\t";
+         << perf_info.stops << "\t";
   output << std::fixed << std::setprecision(precision)
-         << perf_info.stops << std::endl;
+         << perf_info.total_time*1e-6 << "\t";
+  long double p50, p99;
+  get_window_percentiles(id, p50, p99);
   output << std::fixed << std::setprecision(precision)
-         << perf_info.total_time*1e3 << std::endl;
+         << p50*1e3 << "\t";
+  output << std::fixed << std::setprecision(precision)
+         << p99*1e3 << std::endl;
 }
 
 long double Stopwatch::get_time_so_far(string perf_name) 
+{
+  return get_time_so_far(find_id(perf_name));
+}
+
+long double Stopwatch::get_time_so_far(StopwatchId id)
 {
   // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
+  PerformanceData& perf_info = get_record(id);
   
-  long double lapse = 
-    (take_time() - (records_of->find(perf_name)->second).clock_start);
-  
-  if (mode == CPU_TIME)
-    lapse /= (double) CLOCKS_PER_SEC;
-  
-  return lapse;
+  return (take_time_ns() - perf_info.clock_start)*1e-9L;
 }
 
 long double Stopwatch::get_total_time(string perf_name) 
 {
-  // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
-  
-  return perf_info.total_time;
-  
+  return get_record(perf_name).total_time*1e-9L;
+}
+
+long double Stopwatch::get_total_time(StopwatchId id)
+{
+  return get_record(id).total_time*1e-9L;
 }
 
 long double Stopwatch::get_average_time(string perf_name) 
 {
-  // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
-  
-  return (perf_info.total_time / (long double)perf_info.stops);
+  PerformanceData& perf_info = get_record(perf_name);
   
+  return (perf_info.total_time*1e-9L / (long double)perf_info.stops);
+}
+
+long double Stopwatch::get_average_time(StopwatchId id)
+{
+  PerformanceData& perf_info = get_record(id);
+
+  return (perf_info.total_time*1e-9L / (long double)perf_info.stops);
 }
 
 long double Stopwatch::get_min_time(string perf_name) 
 {
-  // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
-  
-  return perf_info.min_time;
-  
+  return get_record(perf_name).min_time*1e-9L;
+}
+
+long double Stopwatch::get_min_time(StopwatchId id)
+{
+  return get_record(id).min_time*1e-9L;
 }
 
 long double Stopwatch::get_max_time(string perf_name) 
 {
-  // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
-  
-  return perf_info.max_time;
-  
+  return get_record(perf_name).max_time*1e-9L;
+}
+
+long double Stopwatch::get_max_time(StopwatchId id)
+{
+  return get_record(id).max_time*1e-9L;
 }
 
 long double Stopwatch::get_last_time(string perf_name) 
 {
-  // Try to recover performance data
-  if ( !performance_exists(perf_name)  )
-    throw StopwatchException("Performance not initialized.");
-  
-  PerformanceData& perf_info = records_of->find(perf_name)->second;
-  
-  return perf_info.last_time;
+  return get_record(perf_name).last_time*1e-9L;
 }
+
+long double Stopwatch::get_last_time(StopwatchId id)
+{
+  return get_record(id).last_time*1e-9L;
+}
+
+long double Stopwatch::get_percentile(string perf_name, double percentile)
+{
+  return get_percentile(find_id(perf_name), percentile);
+}
+
+long double Stopwatch::get_percentile(StopwatchId id, double percentile)
+{
+  PerformanceData& perf_info = get_record(id);
+  return histogram_percentile(perf_info.histogram, perf_info.stops,
+                              perf_info.min_time, perf_info.max_time, percentile);
+}
+
+int Stopwatch::percentile_rank(int n, double percentile)
+{
+  int k = (int) std::ceil(n * percentile / 100.0) - 1;
+  if(k<0)
+    k = 0;
+  return k<n ? k : n-1;
+}
+
+int64_t Stopwatch::window_rank(PerformanceData & perf_info, int k, int end)
+{
+  std::vector<int64_t>::iterator first = perf_info.window_scratch.begin();
+  std::nth_element(first, first+k, first+end);
+  return first[k];
+}
+
+long double Stopwatch::get_window_percentile(StopwatchId id, double percentile)
+{
+  PerformanceData& perf_info = get_record(id);
+  const int n = perf_info.window_count;
+  if(n==0)
+    return 0.0;
+  std::copy(perf_info.window.begin(), perf_info.window.begin()+n, perf_info.window_scratch.begin());
+  return window_rank(perf_info, percentile_rank(n, percentile), n)*1e-9L;
+}
+
+void Stopwatch::get_window_percentiles(StopwatchId id, long double & p50, long double & p99)
+{
+  PerformanceData& perf_info = get_record(id);
+  const int n = perf_info.window_count;
+  if(n==0)
+  {
+    p50 = p99 = 0.0;
+    return;
+  }
+  std::copy(perf_info.window.begin(), perf_info.window.begin()+n, perf_info.window_scratch.begin());
+  // after the first selection the elements of rank below k99 are before it
+  const int k99 = percentile_rank(n, 99.0);
+  p99 = window_rank(perf_info, k99, n)*1e-9L;
+  p50 = window_rank(perf_info, percentile_rank(n, 50.0), k99+1)*1e-9L;
+}
+
+long double Stopwatch::get_window_max_time(StopwatchId id)
+{
+  return get_record(id).window_max_time*1e-9L;
+}
+
+void Stopwatch::set_deadline(StopwatchId id, long double deadline)
+{
+  get_record(id).deadline = (int64_t)(deadline*1e9L);
+}
+
+unsigned long Stopwatch::get_deadline_misses(StopwatchId id)
+{
+  return get_record(id).deadline_misses;
+}
+
+int64_t Stopwatch::window_max(const PerformanceData & perf_info)
+{
+  int64_t max = 0;
+  for(int i=0; i<perf_info.window_count; i++)
+    if(perf_info.window[i] > max)
+      max = perf_info.window[i];
+  return max;
+}
+
+long double Stopwatch::histogram_percentile(const unsigned int * histogram, long samples,
+                                            int64_t min_time, int64_t max_time,
+                                            double percentile)
+{
+  if(samples==0)
+    return 0.0;
+
+  // number of samples below the percentile
+  const long double target = samples * percentile / 100.0;
+  long double count = 0.0;
+  for(int i=0; i<STOP_WATCH_HISTOGRAM_SIZE; i++)
+  {
+    const unsigned int n = histogram[i];
+    if(n>0 && count+n >= target)
+    {
+      // interpolate linearly inside the bin [2^i, 2^(i+1)),
+      // whose bounds are clamped to the measured min and max
+      long double low  = (i==0) ? 0.0 : (long double)((int64_t)1 << i);
+      long double high = (long double)((int64_t)1 << (i+1));
+      if(low  < min_time) low  = min_time;
+      if(high > max_time) high = max_time;
+      if(high < low) high = low;
+      return (low + (high-low)*(target-count)/n)*1e-9L;
+    }
+    count += n;
+  }
+  return max_time*1e-9L;
+}
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
@@ -20,6 +20,7 @@
 #include <sot/torque_control/commands-helper.hh>
 #include <sot/torque_control/motor-model.hh>
 #include <sot/torque_control/common.hh>
+#include <tsid/robots/robot-wrapper.hpp>
 #include <Eigen/Dense>
 
 namespace dynamicgraph
@@ -114,8 +115,8 @@ namespace torque_control
         return;
       }
 
-      se3::urdf::buildModel(m_robot_util->m_urdf_filename,
-                            se3::JointModelFreeFlyer(), m_model);
+      // copy of the shared model, because the gravity is modified during the calibration
+      m_model = getRobotModel(m_robot_util->m_urdf_filename, ROOT_JOINT_FREE_FLYER).model();
       // assert(m_model.nq == N_JOINTS+7);
       // assert(m_model.nv == N_JOINTS+6);
             
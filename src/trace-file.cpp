@@ -0,0 +1,467 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sot/torque_control/utils/trace-file.hh>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace dynamicgraph
+{
+  namespace sot
+  {
+    namespace torque_control
+    {
+      using namespace std;
+
+
+      static inline bool isBlank(char c)
+      {
+        return c==' ' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+      }
+
+      static bool isBlankLine(const char* begin, const char* end)
+      {
+        for(const char* p=begin; p<end; ++p)
+          if(!isBlank(*p))
+            return false;
+        return true;
+      }
+
+      /** Parse a decimal number without calling strtod, which is slow because it
+       *  handles every case. The result is exact (hence identical to strtod) when
+       *  the significand has at most 2^53 and the power of ten at most 22: then
+       *  both are exact doubles and the product or division rounds correctly.
+       *  @return false if the number is not in this form, in which case
+       *  strtod must be used.
+       */
+      static bool parseDecimalFast(const char* p, const char* end, double& x, const char*& next)
+      {
+        static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const uint64_t MAX_SIGNIFICAND = (uint64_t)1 << 53;
+
+        bool negative = false;
+        if(p<end && (*p=='-' || *p=='+'))
+          negative = (*p++=='-');
+
+        uint64_t significand = 0;
+        int nbDigits = 0, exponent = 0;
+        for(; p<end && *p>='0' && *p<='9'; ++p, ++nbDigits)
+          if((significand = 10*significand + (*p-'0')) >= MAX_SIGNIFICAND)
+            return false;
+        if(p<end && *p=='.')
+          for(++p; p<end && *p>='0' && *p<='9'; ++p, ++nbDigits, --exponent)
+            if((significand = 10*significand + (*p-'0')) >= MAX_SIGNIFICAND)
+              return false;
+        if(nbDigits==0)
+          return false;
+
+        if(p<end && (*p=='e' || *p=='E'))
+        {
+          ++p;
+          bool negativeExp = false;
+          if(p<end && (*p=='-' || *p=='+'))
+            negativeExp = (*p++=='-');
+          if(p>=end || *p<'0' || *p>'9')
+            return false;
+          int e = 0;
+          for(; p<end && *p>='0' && *p<='9' && e<1000; ++p)
+            e = 10*e + (*p-'0');
+          exponent += negativeExp ? -e : e;
+        }
+        if(p<end && !isBlank(*p))
+          return false;
+        if(exponent<-22 || exponent>22)
+          return false;
+
+        x = (double)significand;
+        x = exponent<0 ? x/POW10[-exponent] : x*POW10[exponent];
+        if(negative)
+          x = -x;
+        next = p;
+        return true;
+      }
+
+      /** Parse the numbers of the line [begin, end), writing at most maxValues
+       *  of them in values. The line must be followed by a character that
+       *  strtod does not accept (newline or null), so that it stops inside it.
+       *  @return The number of values in the line, or -1 if it contains
+       *  something that is not a number.
+       */
+      static long parseLine(const char* begin, const char* end, double* values, long maxValues)
+      {
+        long n = 0;
+        const char* p = begin;
+        char* next;
+        while(true)
+        {
+          // skip the separators here, because strtod would also skip newlines
+          while(p<end && isBlank(*p))
+            ++p;
+          if(p>=end)
+            return n;
+          double x;
+          const char* fastNext;
+          if(parseDecimalFast(p, end, x, fastNext))
+            next = const_cast<char*>(fastNext);
+          else
+          {
+            x = strtod(p, &next);
+            if(next==p || next>end)
+              return -1;
+          }
+          if(n<maxValues)
+            values[n] = x;
+          ++n;
+          p = next;
+        }
+      }
+
+      /** Map the file fileName in memory, read only.
+       *  Empty files are not mapped and give map==NULL and size==0. */
+      static bool mapFile(const string& fileName, void*& map, size_t& size, string& error)
+      {
+        map = NULL;
+        size = 0;
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if(fd<0)
+        {
+          error = "Error trying to open the file "+fileName;
+          return false;
+        }
+        struct stat st;
+        if(fstat(fd, &st)!=0)
+        {
+          ::close(fd);
+          error = "Error trying to read the size of the file "+fileName;
+          return false;
+        }
+        if(st.st_size==0)
+        {
+          ::close(fd);
+          return true;
+        }
+
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(map==MAP_FAILED)
+        {
+          map = NULL;
+          error = "Error trying to map the file "+fileName+" in memory";
+          return false;
+        }
+        size = st.st_size;
+        // the files are read from the beginning to the end
+        madvise(map, size, MADV_SEQUENTIAL);
+        return true;
+      }
+
+      static string toStr(long long i)
+      {
+        stringstream ss;
+        ss<<i;
+        return ss.str();
+      }
+
+      TraceFile::TraceFile()
+        : m_data(NULL), m_rows(0), m_cols(0), m_map(NULL), m_mapSize(0)
+      {}
+
+      TraceFile::~TraceFile()
+      {
+        close();
+      }
+
+      void TraceFile::close()
+      {
+        if(m_map!=NULL)
+          munmap(m_map, m_mapSize);
+        m_map = NULL;
+        m_mapSize = 0;
+        vector<double>().swap(m_buffer);
+        m_data = NULL;
+        m_rows = 0;
+        m_cols = 0;
+      }
+
+      bool TraceFile::open(const string& fileName, string& error)
+      {
+        close();
+
+        ifstream file(fileName.c_str(), ios::binary);
+        if(file.fail())
+        {
+          error = "Error trying to read the file "+fileName;
+          return false;
+        }
+        char magic[sizeof(TraceFileHeader::magic)];
+        file.read(magic, sizeof(magic));
+        bool isBinary = file.gcount()==(streamsize)sizeof(magic) &&
+                        strncmp(magic, TRACE_FILE_MAGIC, sizeof(magic))==0;
+        file.close();
+
+        if(isBinary)
+          return openBinary(fileName, error);
+        return openText(fileName, error);
+      }
+
+      bool TraceFile::openBinary(const string& fileName, string& error)
+      {
+        if(!mapFile(fileName, m_map, m_mapSize, error))
+          return false;
+        if(m_mapSize<sizeof(TraceFileHeader))
+        {
+          error = "Invalid binary trace file "+fileName;
+          close();
+          return false;
+        }
+
+        const TraceFileHeader* header = static_cast<const TraceFileHeader*>(m_map);
+        if(header->version!=TRACE_FILE_VERSION)
+        {
+          error = "Unsupported version "+toStr(header->version)+" of binary trace file "+fileName;
+          close();
+          return false;
+        }
+        if(header->dataOffset%sizeof(double)!=0 ||
+           header->dataOffset + header->nbRows*header->nbCols*sizeof(double) > m_mapSize)
+        {
+          error = "Binary trace file "+fileName+" is truncated or corrupted";
+          close();
+          return false;
+        }
+
+        m_rows = header->nbRows;
+        m_cols = header->nbCols;
+        m_data = reinterpret_cast<const double*>(static_cast<const char*>(m_map) + header->dataOffset);
+        return true;
+      }
+
+      bool TraceFile::openText(const string& fileName, string& error)
+      {
+        TextMatrixFileReader reader;
+        if(!reader.open(fileName, error))
+          return false;
+        if(reader.rows()==0)
+          return true;
+
+        // the first column contains the time, which is not stored
+        Eigen::VectorXd values(reader.cols());
+        m_cols = reader.cols()-1;
+        m_buffer.resize(reader.rows()*m_cols);
+        for(m_rows=0; m_rows<reader.rows(); m_rows++)
+        {
+          if(!reader.readRow(values))
+          {
+            error = "In file "+fileName+" line "+toStr(m_rows)+" does not contain "+
+                    toStr(reader.cols())+" numbers like the preceding lines";
+            close();
+            return false;
+          }
+          Eigen::VectorXd::Map(&m_buffer[m_rows*m_cols], m_cols) = values.tail(m_cols);
+        }
+        m_data = m_buffer.empty() ? NULL : &m_buffer[0];
+        return true;
+      }
+
+      TextMatrixFileReader::TextMatrixFileReader()
+        : m_begin(NULL), m_end(NULL), m_cursor(NULL), m_rows(0), m_cols(0),
+          m_currentRow(0), m_map(NULL), m_mapSize(0)
+      {}
+
+      TextMatrixFileReader::~TextMatrixFileReader()
+      {
+        close();
+      }
+
+      void TextMatrixFileReader::close()
+      {
+        if(m_map!=NULL)
+          munmap(m_map, m_mapSize);
+        m_map = NULL;
+        m_mapSize = 0;
+        m_begin = m_end = m_cursor = NULL;
+        m_rows = m_cols = m_currentRow = 0;
+        m_lastLine.clear();
+      }
+
+      void TextMatrixFileReader::rewind()
+      {
+        m_cursor = m_begin;
+        m_currentRow = 0;
+      }
+
+      bool TextMatrixFileReader::open(const string& fileName, string& error)
+      {
+        close();
+        if(!mapFile(fileName, m_map, m_mapSize, error))
+          return false;
+        m_begin = static_cast<const char*>(m_map);
+        m_end = m_begin + m_mapSize;
+
+        // count the rows and parse the first one to get the number of columns
+        m_cursor = m_begin;
+        const char *lineBegin, *lineEnd;
+        while(nextLine(lineBegin, lineEnd))
+        {
+          if(m_rows==0)
+          {
+            long n = parseLine(lineBegin, lineEnd, NULL, 0);
+            if(n<=0)
+            {
+              error = "The first line of file "+fileName+" does not contain numbers";
+              close();
+              return false;
+            }
+            m_cols = n;
+          }
+          m_rows++;
+        }
+        rewind();
+        return true;
+      }
+
+      bool TextMatrixFileReader::nextLine(const char*& lineBegin, const char*& lineEnd)
+      {
+        while(m_cursor<m_end)
+        {
+          lineBegin = m_cursor;
+          lineEnd = static_cast<const char*>(memchr(m_cursor, '\n', m_end-m_cursor));
+          if(lineEnd==NULL)
+          {
+            lineEnd = m_end;
+            m_cursor = m_end;
+          }
+          else
+            m_cursor = lineEnd+1;
+
+          if(!isBlankLine(lineBegin, lineEnd))
+          {
+            if(lineEnd==m_end)
+            {
+              // the last line is not followed by a newline: parse a null-terminated copy
+              // (the copy is made when counting the rows, so it does not allocate later)
+              if(m_lastLine.size()!=(size_t)(lineEnd-lineBegin))
+                m_lastLine.assign(lineBegin, lineEnd);
+              lineBegin = m_lastLine.c_str();
+              lineEnd = lineBegin + m_lastLine.size();
+            }
+            return true;
+          }
+        }
+        return false;
+      }
+
+      bool TextMatrixFileReader::readRow(Eigen::Ref<Eigen::VectorXd> row)
+      {
+        const char *lineBegin, *lineEnd;
+        if(row.size()!=m_cols || !nextLine(lineBegin, lineEnd))
+          return false;
+        m_currentRow++;
+        return parseLine(lineBegin, lineEnd, row.data(), m_cols)==m_cols;
+      }
+
+      static void initHeader(TraceFileHeader& header, long nbCols, long nbRows)
+      {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+        header.version = TRACE_FILE_VERSION;
+        header.nbCols = nbCols;
+        header.nbRows = nbRows;
+        header.dataOffset = sizeof(TraceFileHeader);
+      }
+
+      bool convertTextTraceToBinary(const string& textFileName,
+                                    const string& binaryFileName,
+                                    string& error)
+      {
+        TextMatrixFileReader reader;
+        if(!reader.open(textFileName, error))
+          return false;
+        ofstream binaryFile(binaryFileName.c_str(), ios::binary | ios::trunc);
+        if(binaryFile.fail())
+        {
+          error = "Error trying to write the file "+binaryFileName;
+          return false;
+        }
+
+        // the first column contains the time, which is not stored
+        TraceFileHeader header;
+        initHeader(header, reader.rows()>0 ? reader.cols()-1 : 0, reader.rows());
+        binaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        Eigen::VectorXd values(reader.cols());
+        for(Eigen::VectorXd::Index i=0; i<reader.rows(); i++)
+        {
+          if(!reader.readRow(values))
+          {
+            error = "In file "+textFileName+" line "+toStr(i)+" does not contain "+
+                    toStr(reader.cols())+" numbers like the preceding lines";
+            return false;
+          }
+          binaryFile.write(reinterpret_cast<const char*>(values.data()+1), header.nbCols*sizeof(double));
+        }
+
+        if(binaryFile.fail())
+        {
+          error = "Error while writing the file "+binaryFileName;
+          return false;
+        }
+        return true;
+      }
+
+      bool writeBinaryTrace(const string& fileName,
+                            const Eigen::Ref<const Eigen::MatrixXd>& records,
+                            string& error)
+      {
+        ofstream binaryFile(fileName.c_str(), ios::binary | ios::trunc);
+        if(binaryFile.fail())
+        {
+          error = "Error trying to write the file "+fileName;
+          return false;
+        }
+
+        TraceFileHeader header;
+        initHeader(header, records.rows(), records.cols());
+        binaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        // the records are the columns of the matrix
+        if(records.outerStride()==records.rows())
+          binaryFile.write(reinterpret_cast<const char*>(records.data()),
+                           records.size()*sizeof(double));
+        else
+          for(Eigen::MatrixXd::Index i=0; i<records.cols(); i++)
+            binaryFile.write(reinterpret_cast<const char*>(records.col(i).data()),
+                             records.rows()*sizeof(double));
+
+        if(binaryFile.fail())
+        {
+          error = "Error while writing the file "+fileName;
+          return false;
+        }
+        return true;
+      }
+
+    } // namespace torquecontrol
+  } // namespace sot
+} // namespace dynamicgraph
@@ -59,6 +59,12 @@ namespace dynamicgraph
                                                     "Name of the text file where to read the data (string)",
                                                     "Name of the output signal (string)")));
 
+        addCommand("convertTraceFile",
+                   makeCommandVoid2(*this, &TracePlayer::convertTraceFile,
+                                    docCommandVoid2("Convert a text file saved by the Tracer to the binary trace format, which addOutputSignal memory maps",
+                                                    "Name of the text file to read (string)",
+                                                    "Name of the binary file to write (string)")));
+
         addCommand("playNext",
                    makeCommandVoid0(*this, &TracePlayer::playNext,
                                     docCommandVoid0("Update all the output signals.")));
@@ -72,6 +78,11 @@ namespace dynamicgraph
                                     docCommandVoid0("Clear all the output signals.")));
       }
 
+      TracePlayer::~TracePlayer()
+      {
+        clear();
+      }
+
 
       /* ------------------------------------------------------------------- */
       /* --- SIGNALS ------------------------------------------------------- */
@@ -93,62 +104,29 @@ namespace dynamicgraph
         if(m_outputSignals.find(signalName) != m_outputSignals.end())
           return SEND_MSG("It already exists a signal with name "+signalName, MSG_TYPE_ERROR);
 
-        // read the text file
-        std::ifstream datafile( fileName.c_str() );
-        if(datafile.fail())
-          return SEND_MSG("Error trying to read the file "+fileName, MSG_TYPE_ERROR);
-
-        const unsigned int SIZE=1024;
-        char buffer[SIZE];
-        std::vector<double> newline;
-        int nbLines = 0;
-        bool firstIter = true;
-        int size = -1;
-        string fileNameShort = fileName.substr(1+fileName.find_last_of("/"));
-        while( datafile.good() )
+        // read the trace file (memory mapped if it is binary)
+        TraceData* data = new TraceData();
+        string error;
+        if(!data->file.open(fileName, error))
         {
-          datafile.getline( buffer,SIZE );
-          const unsigned int gcount = datafile.gcount();
-          if( gcount>=SIZE )
-            return SEND_MSG("Read error: line "+toString(nbLines)+
-                            " too long in file "+fileNameShort, MSG_TYPE_ERROR);
-
-          std::istringstream iss(buffer);
-          newline.clear();
-          double x;
-          iss>>x; // discard the first value, which is the time step
-          while( 1 )
-          {
-            iss>>x;
-            if(iss.fail())
-              break;
-            newline.push_back(x);
-          }
-
-          if( newline.size()>0 )
-          {
-            if(firstIter)
-              size = newline.size();
-            else if(size!=newline.size())
-            {
-              SEND_MSG("In file "+fileNameShort+" nb of elements in each line changed from "+
-                       toString(size)+" to "+toString(newline.size())+" at line "+
-                       toString(nbLines), MSG_TYPE_WARNING);
-              size = newline.size();
-            }
-            m_data[signalName].push_back( Eigen::Map<Vector>(&newline[0], newline.size()));
-            nbLines++;
-          }
+          delete data;
+          return SEND_MSG(error, MSG_TYPE_ERROR);
         }
-        SEND_MSG("Finished reading "+toString(nbLines)+" lines of "+toString(size)+
-                 " elements from file "+fileNameShort, MSG_TYPE_INFO);
-        m_dataPointers[signalName] = m_data[signalName].begin();
+        data->pointer = 0;
+        data->value.setZero(data->file.cols());
+
+        string fileNameShort = fileName.substr(1+fileName.find_last_of("/"));
+        SEND_MSG("Finished reading "+toString(data->file.rows())+" lines of "+toString(data->file.cols())+
+                 " elements from "+(data->file.isMapped() ? "binary" : "text")+" file "+fileNameShort,
+                 MSG_TYPE_INFO);
 
         // create a new output signal
         m_outputSignals[signalName] = new OutputSignalType(
                                         getClassName()+"("+getName()+
                                         ")::output(dynamicgraph::Vector)::"+
                                         signalName);
+        data->signal = m_outputSignals[signalName];
+        m_data[signalName] = data;
 
         // register the new signal
         m_triggerSOUT.addDependency(*m_outputSignals[signalName]);
@@ -156,42 +134,54 @@ namespace dynamicgraph
 
       }
 
+      void TracePlayer::convertTraceFile(const string& textFileName,
+                                         const string& binaryFileName)
+      {
+        string error;
+        if(!convertTextTraceToBinary(textFileName, binaryFileName, error))
+          return SEND_MSG(error, MSG_TYPE_ERROR);
+        SEND_MSG("Converted file "+textFileName+" to binary file "+binaryFileName, MSG_TYPE_INFO);
+      }
+
       void TracePlayer::playNext()
       {
-        typedef std::map<std::string, OutputSignalType* >::iterator it_type;
-        for(it_type it=m_outputSignals.begin(); it!=m_outputSignals.end(); it++)
+        typedef std::map<std::string, TraceData*>::iterator it_type;
+        for(it_type it=m_data.begin(); it!=m_data.end(); it++)
         {
           const string & signalName           = it->first;
-          OutputSignalType * signal           = it->second;
-          DataPointerType & dataPointer       = m_dataPointers[signalName];
-          const DataHistoryType & dataSet     = m_data[signalName];
+          TraceData & data                    = *it->second;
 
-          if( dataPointer!=dataSet.end() )
-            ++dataPointer;
+          if( data.pointer<data.file.rows() )
+            ++data.pointer;
 
-          if( dataPointer==dataSet.end() )
+          if( data.pointer==data.file.rows() )
             SEND_WARNING_STREAM_MSG("Reached end of dataset for signal "+signalName);
           else
-            signal->setConstant(*dataPointer);
+          {
+            data.value = data.file.row(data.pointer);
+            data.signal->setConstant(data.value);
+          }
         }
       }
 
       void TracePlayer::rewind()
       {
-        typedef std::map<std::string, DataPointerType>::iterator it_type;
-        for(it_type it=m_dataPointers.begin(); it!=m_dataPointers.end(); it++)
-        {
-          const string & signalName           = it->first;
-          DataPointerType & dataPointer       = it->second;
-          const DataHistoryType & dataSet     = m_data[signalName];
-          dataPointer = dataSet.begin();
-        }
+        typedef std::map<std::string, TraceData*>::iterator it_type;
+        for(it_type it=m_data.begin(); it!=m_data.end(); it++)
+          it->second->pointer = 0;
       }
 
       void TracePlayer::clear()
       {
+        typedef std::map<std::string, TraceData*>::iterator it_type;
+        for(it_type it=m_data.begin(); it!=m_data.end(); it++)
+        {
+          m_triggerSOUT.removeDependency(*it->second->signal);
+          signalDeregistration(it->first);
+          delete it->second->signal;
+          delete it->second;
+        }
         m_data.clear();
-        m_dataPointers.clear();
         m_outputSignals.clear();
       }
 
@@ -29,8 +29,32 @@ namespace dynamicgraph
       using namespace dynamicgraph;
       using namespace dynamicgraph::command;
 
+      Eigen::MatrixXd readMatrixFromFile(const char *filename)
+      {
+        TextMatrixFileReader file;
+        std::string error;
+        if(!file.open(filename, error))
+        {
+          std::cout<<error<<"\n";
+          return Eigen::MatrixXd();
+        }
+
+        // the rows are parsed directly into the result, which is allocated once
+        Eigen::MatrixXd result(file.rows(), file.cols());
+        Eigen::VectorXd row(file.cols());
+        for(Eigen::MatrixXd::Index i=0; i<result.rows(); i++)
+        {
+          if(!file.readRow(row))
+          {
+            std::cout<<"Error while reading matrix from file, line "<<i<<" does not contain "
+                     <<file.cols()<<" numbers like the preceding lines\n";
+            return Eigen::MatrixXd();
+          }
+          result.row(i) = row.transpose();
+        }
+        return result;
+      }
 
-      
     } // namespace torquecontrol
   } // namespace sot
 } // namespace dynamicgraph
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Set-up of the robot and of the balance controller shared by the C++ tests */
+
+#ifndef __sot_torque_control_balance_controller_test_utils_H__
+#define __sot_torque_control_balance_controller_test_utils_H__
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <sot/torque_control/inverse-dynamics-balance-controller.hh>
+#include <sot/torque_control/common.hh>
+
+namespace dynamicgraph {
+  namespace sot {
+    namespace torque_control {
+
+/// Return the URDF file given as first argument of the test (set by CMake
+/// from the prefix of simple_humanoid_description), or an empty string
+/// after printing an error if it is missing or cannot be read.
+inline std::string getTestUrdf(int argc, char** argv)
+{
+  if(argc<2)
+  {
+    std::cout<<"Usage: "<<argv[0]<<" <urdf file of simple_humanoid>"<<std::endl;
+    return "";
+  }
+  const std::string urdf(argv[1]);
+  if(!std::ifstream(urdf.c_str()).good())
+  {
+    std::cout<<"ERROR: cannot find the URDF file "<<urdf<<std::endl;
+    return "";
+  }
+  return urdf;
+}
+
+/// Same robot as the Python tests (see tests/robot_data_test.py)
+inline void initRobotUtil(const std::string & robotName, const std::string & urdf)
+{
+  std::string name(robotName);
+  RobotUtil* ru = createRobotUtil(name);
+  ru->m_urdf_filename = urdf;
+  const Index urdf_to_sot[] = {12,13,14,15,23,24,25,26,27,28,16,17,18,19,20,
+                               21,22,6,7,8,9,10,11,0,1,2,3,4,5};
+  ru->set_urdf_to_sot(std::vector<Index>(urdf_to_sot, urdf_to_sot+29));
+  ru->m_nbJoints = 29;
+  ru->m_foot_util.m_Right_Foot_Frame_Name = "RLEG_ANKLE_R";
+  ru->m_foot_util.m_Left_Foot_Frame_Name = "LLEG_ANKLE_R";
+}
+
+/// Set all the inputs of the balance controller for a standing robot and initialize it
+inline void initBalanceController(InverseDynamicsBalanceController & ctrl, const double dt,
+                                  const std::string & robotName)
+{
+  const int nj = 29;
+  const dynamicgraph::Vector zeros_nj = dynamicgraph::Vector::Zero(nj);
+  const dynamicgraph::Vector ones_nj = dynamicgraph::Vector::Ones(nj);
+  dynamicgraph::Matrix contactPoints(3,4);
+  contactPoints << 0.1, -0.1, -0.1,  0.1,
+                 -0.06, -0.06, 0.06, 0.06,
+                 -0.105, -0.105, -0.105, -0.105;
+  dynamicgraph::Vector contactNormal(3);
+  contactNormal << 0.0, 0.0, 1.0;
+  dynamicgraph::Vector f_ref = dynamicgraph::Vector::Zero(6);
+  f_ref(2) = 280.0;
+
+  dynamicgraph::Vector q = dynamicgraph::Vector::Zero(nj+6);
+  q(2) = 0.6;
+  ctrl.m_qSIN.setConstant(q);
+  ctrl.m_vSIN.setConstant(dynamicgraph::Vector::Zero(nj+6));
+  ctrl.m_com_ref_posSIN.setConstant(dynamicgraph::Vector::Zero(3));
+  ctrl.m_com_ref_velSIN.setConstant(dynamicgraph::Vector::Zero(3));
+  ctrl.m_com_ref_accSIN.setConstant(dynamicgraph::Vector::Zero(3));
+  ctrl.m_rf_ref_posSIN.setConstant(dynamicgraph::Vector::Zero(12));
+  ctrl.m_rf_ref_velSIN.setConstant(dynamicgraph::Vector::Zero(6));
+  ctrl.m_rf_ref_accSIN.setConstant(dynamicgraph::Vector::Zero(6));
+  ctrl.m_lf_ref_posSIN.setConstant(dynamicgraph::Vector::Zero(12));
+  ctrl.m_lf_ref_velSIN.setConstant(dynamicgraph::Vector::Zero(6));
+  ctrl.m_lf_ref_accSIN.setConstant(dynamicgraph::Vector::Zero(6));
+  ctrl.m_posture_ref_posSIN.setConstant(zeros_nj);
+  ctrl.m_posture_ref_velSIN.setConstant(zeros_nj);
+  ctrl.m_posture_ref_accSIN.setConstant(zeros_nj);
+  ctrl.m_f_ref_right_footSIN.setConstant(f_ref);
+  ctrl.m_f_ref_left_footSIN.setConstant(f_ref);
+  ctrl.m_kp_constraintsSIN.setConstant(dynamicgraph::Vector::Zero(6));
+  ctrl.m_kd_constraintsSIN.setConstant(dynamicgraph::Vector::Zero(6));
+  ctrl.m_kp_comSIN.setConstant(dynamicgraph::Vector::Constant(3, 30.0));
+  ctrl.m_kd_comSIN.setConstant(dynamicgraph::Vector::Constant(3, 10.0));
+  ctrl.m_kp_feetSIN.setConstant(dynamicgraph::Vector::Constant(6, 30.0));
+  ctrl.m_kd_feetSIN.setConstant(dynamicgraph::Vector::Constant(6, 10.0));
+  ctrl.m_kp_postureSIN.setConstant(10.0*ones_nj);
+  ctrl.m_kd_postureSIN.setConstant(5.0*ones_nj);
+  ctrl.m_kp_posSIN.setConstant(zeros_nj);
+  ctrl.m_kd_posSIN.setConstant(zeros_nj);
+  ctrl.m_w_comSIN.setConstant(1.0);
+  ctrl.m_w_feetSIN.setConstant(1.0);
+  ctrl.m_w_postureSIN.setConstant(1e-2);
+  ctrl.m_w_forcesSIN.setConstant(1e-4);
+  ctrl.m_muSIN.setConstant(0.3);
+  ctrl.m_contact_pointsSIN.setConstant(contactPoints);
+  ctrl.m_contact_normalSIN.setConstant(contactNormal);
+  ctrl.m_f_minSIN.setConstant(1.0);
+  ctrl.m_f_max_right_footSIN.setConstant(1e3);
+  ctrl.m_f_max_left_footSIN.setConstant(1e3);
+  ctrl.m_rotor_inertiasSIN.setConstant(zeros_nj);
+  ctrl.m_gear_ratiosSIN.setConstant(ones_nj);
+  ctrl.m_active_jointsSIN.setConstant(ones_nj);
+
+  ctrl.init(dt, robotName);
+}
+
+    }    // namespace torque_control
+  }      // namespace sot
+}        // namespace dynamicgraph
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2017-, Rohan Budhiraja LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Micro-benchmark of CausalFilter::get_x_dx_ddx against the implementation
+ *  that built the reordered coefficients at every sample, for filter orders
+ *  from 2 to 12 and signals of 6 to 64 channels. The outputs of the two
+ *  implementations must be bit-identical.
+ *  Usage: benchmark_causal_filter [number of samples]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <sot/torque_control/utils/causal-filter.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+/// CausalFilter before the coefficient tables: the coefficients are
+/// reordered in temporary vectors at every sample
+class ReferenceCausalFilter
+{
+public:
+  ReferenceCausalFilter(const double &timestep, const int& xSize,
+                        const Eigen::VectorXd& filter_numerator,
+                        const Eigen::VectorXd& filter_denominator)
+    : m_dt(timestep)
+    , m_x_size(xSize)
+    , m_filter_order_m(filter_numerator.size())
+    , m_filter_order_n(filter_denominator.size())
+    , m_filter_numerator(filter_numerator)
+    , m_filter_denominator(filter_denominator)
+    , first_sample(true)
+    , pt_numerator(0)
+    , pt_denominator(0)
+    , input_buffer(Eigen::MatrixXd::Zero(xSize, filter_numerator.size()))
+    , output_buffer(Eigen::MatrixXd::Zero(xSize, filter_denominator.size()-1))
+  {}
+
+  void get_x_dx_ddx(const Eigen::VectorXd& base_x, Eigen::VectorXd& x_output_dx_ddx)
+  {
+    if(first_sample)
+    {
+      for(int i=0;i<m_filter_order_m; i++)
+        input_buffer.col(i) = base_x;
+      for(int i=0;i<m_filter_order_n-1; i++)
+        output_buffer.col(i) = base_x*m_filter_numerator.sum()/m_filter_denominator.sum();
+      first_sample = false;
+    }
+
+    input_buffer.col(pt_numerator) = base_x;
+
+    Eigen::VectorXd b(m_filter_order_m);
+    Eigen::VectorXd a(m_filter_order_n-1);
+    b.head(pt_numerator+1) = m_filter_numerator.head(pt_numerator+1).reverse();
+    b.tail(m_filter_order_m-pt_numerator-1) =
+      m_filter_numerator.tail(m_filter_order_m-pt_numerator-1).reverse();
+
+    a.head(pt_denominator+1) = m_filter_denominator.segment(1, pt_denominator+1).reverse();
+    a.tail(m_filter_order_n-pt_denominator-2) =
+      m_filter_denominator.tail(m_filter_order_n-pt_denominator-2).reverse();
+    x_output_dx_ddx.head(m_x_size) = (input_buffer*b-output_buffer*a)/m_filter_denominator[0];
+
+    int pt_denominator_prev = (pt_denominator == 0) ? m_filter_order_n-2 : pt_denominator-1;
+    x_output_dx_ddx.segment(m_x_size,m_x_size) = (x_output_dx_ddx.head(m_x_size)-output_buffer.col(pt_denominator))/m_dt;
+    x_output_dx_ddx.tail(m_x_size) = (x_output_dx_ddx.head(m_x_size)-2*output_buffer.col(pt_denominator)+output_buffer.col(pt_denominator_prev))/m_dt/m_dt;
+
+    pt_numerator = (pt_numerator+1) < m_filter_order_m ? (pt_numerator+1) : 0;
+    pt_denominator = (pt_denominator+1) < m_filter_order_n-1 ? (pt_denominator+1) : 0;
+    output_buffer.col(pt_denominator) = x_output_dx_ddx.head(m_x_size);
+  }
+
+private:
+  double m_dt;
+  int m_x_size;
+  int m_filter_order_m;
+  int m_filter_order_n;
+  Eigen::VectorXd m_filter_numerator;
+  Eigen::VectorXd m_filter_denominator;
+  bool first_sample;
+  int pt_numerator;
+  int pt_denominator;
+  Eigen::MatrixXd input_buffer;
+  Eigen::MatrixXd output_buffer;
+};
+
+/// Stable low-pass filter of the specified order with unit static gain:
+/// all the poles are in 0.5 and the numerator is a moving average
+static void low_pass_filter(int order, Eigen::VectorXd& num, Eigen::VectorXd& den)
+{
+  den.setZero(order+1);
+  den[0] = 1.0;
+  for(int k=0; k<order; k++)
+    for(int i=k+1; i>0; i--)
+      den[i] -= 0.5*den[i-1];
+  num.setConstant(order+1, den.sum()/(order+1));
+}
+
+static bool benchmark(int order, int channels, int N)
+{
+  const double dt = 1e-3;
+  Eigen::VectorXd num, den;
+  low_pass_filter(order, num, den);
+  CausalFilter filter(dt, channels, num, den);
+  ReferenceCausalFilter reference(dt, channels, num, den);
+
+  // the signals are generated beforehand so that only the filters are timed
+  Eigen::MatrixXd x = Eigen::MatrixXd::Random(channels, N);
+  Eigen::MatrixXd y(3*channels, N), y_ref(3*channels, N);
+  Eigen::VectorXd x_i(channels), y_i(3*channels);
+
+  Stopwatch& p = getProfiler();
+  p.start("reference");
+  for(int i=0; i<N; i++)
+  {
+    x_i = x.col(i);
+    reference.get_x_dx_ddx(x_i, y_i);
+    y_ref.col(i) = y_i;
+  }
+  p.stop("reference");
+
+  p.start("coefficient tables");
+  for(int i=0; i<N; i++)
+  {
+    x_i = x.col(i);
+    filter.get_x_dx_ddx(x_i, y_i);
+    y.col(i) = y_i;
+  }
+  p.stop("coefficient tables");
+
+  const bool ok = (y.array()==y_ref.array()).all();
+  const double tRef = 1e9*p.get_total_time("reference")/N;
+  const double tNew = 1e9*p.get_total_time("coefficient tables")/N;
+  std::cout<<"order "<<order<<", "<<channels<<" channels: reference "<<tRef
+           <<" ns, coefficient tables "<<tNew<<" ns, speed-up "<<tRef/tNew
+           <<(ok ? "" : "  ERROR: outputs differ")<<std::endl;
+  p.reset("reference");
+  p.reset("coefficient tables");
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  const int N = argc>1 ? atoi(argv[1]) : 10000;
+  const int channels[] = {6, 16, 32, 64};
+
+  std::cout<<"Average time per sample of "<<N<<" samples:"<<std::endl;
+  bool ok = true;
+  for(int order=2; order<=12; order++)
+    for(int c=0; c<4; c++)
+      ok = benchmark(order, channels[c], N) && ok;
+  std::cout<<(ok ? "OK" : "ERROR: the outputs are not bit-identical")<<std::endl;
+  return ok ? 0 : 1;
+}
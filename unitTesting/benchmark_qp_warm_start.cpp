@@ -0,0 +1,180 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Benchmark of the warm start of the HQP of the balance controller
+ *  (QpWarmStart) on a sequence of slowly varying problems of the size of the
+ *  double support (60 variables, 36 equalities, 34 inequalities), solved
+ *  cold with eiquadprog-fast and then with the warm start in front of it.
+ *  Prints the HQP time percentiles and the histograms of the iterations.
+ *  It is also run as a test: it fails if the cold solver fails or if the
+ *  solutions with the warm start differ from the cold ones by more than
+ *  SOLUTION_TOLERANCE.
+ *  Usage: benchmark_qp_warm_start [number of cycles] [1 to change the Hessian at every cycle]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <algorithm>
+#include <sot/torque_control/utils/qp-warm-start.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+#include <tsid/math/constraint-equality.hpp>
+#include <tsid/math/constraint-inequality.hpp>
+#include <tsid/solvers/solver-HQP-factory.hxx>
+
+using namespace dynamicgraph::sot::torque_control;
+using namespace tsid::math;
+using namespace tsid::solvers;
+
+#define N_VAR 60
+#define N_EQ  36
+#define N_IN  34
+#define SOLUTION_TOLERANCE 1e-6
+
+/// Slowly varying problem with a few active inequalities at the optimum
+struct Problem
+{
+  Eigen::MatrixXd A_eq, A_in, A_task, A_task0;
+  Eigen::VectorXd b_eq0, lb0, ub0, b_task0;
+  ConstraintEquality eq;
+  ConstraintInequality in;
+  ConstraintEquality task;
+  HQPData data;
+
+  Problem()
+    : eq("dynamics", N_EQ, N_VAR)
+    , in("forces", N_IN, N_VAR)
+    , task("tasks", N_VAR, N_VAR)
+  {
+    srand(0);
+    A_eq = Eigen::MatrixXd::Random(N_EQ, N_VAR);
+    A_in = Eigen::MatrixXd::Random(N_IN, N_VAR);
+    A_task0 = Eigen::MatrixXd::Random(N_VAR, N_VAR);
+    A_task = A_task0;
+    const Eigen::VectorXd x0 = Eigen::VectorXd::Random(N_VAR);
+    b_eq0 = A_eq*x0;
+    lb0 = A_in*x0 - Eigen::VectorXd::Constant(N_IN, 0.1);
+    ub0 = A_in*x0 + Eigen::VectorXd::Constant(N_IN, 0.1);
+    // the task pulls away from x0, so some inequalities are active
+    b_task0 = A_task*(x0 + Eigen::VectorXd::Random(N_VAR));
+
+    eq.setMatrix(A_eq);
+    in.setMatrix(A_in);
+    data.resize(2);
+    data[0].push_back(ConstraintLevel::value_type(1.0, &eq));
+    data[0].push_back(ConstraintLevel::value_type(1.0, &in));
+    data[1].push_back(ConstraintLevel::value_type(1.0, &task));
+  }
+
+  /// Update the problem of cycle i (1 ms period)
+  void update(int i, bool changeHessian)
+  {
+    const double t = 1e-3*i;
+    eq.setVector(b_eq0*(1.0+0.01*std::sin(2.0*t)));
+    in.setLowerBound(lb0 + Eigen::VectorXd::Constant(N_IN, 0.01*std::sin(3.0*t)));
+    in.setUpperBound(ub0 + Eigen::VectorXd::Constant(N_IN, 0.01*std::sin(3.0*t)));
+    if(changeHessian)
+    {
+      A_task = A_task0*(1.0+1e-3*std::sin(t));
+      task.setMatrix(A_task);
+    }
+    else
+      task.setMatrix(A_task0);
+    task.setVector(b_task0*(1.0+0.05*std::sin(t)));
+  }
+};
+
+/// Print the time percentiles and the histogram of the iterations,
+/// where the hits of the warm start count as 0 iterations
+static void printResults(const std::string & name, const std::map<int,int> & iterations, int N)
+{
+  Stopwatch& p = getProfiler();
+  std::cout<<name<<": HQP time (us) p50 "<<1e6*p.get_percentile(name, 50.0)
+           <<", p99 "<<1e6*p.get_percentile(name, 99.0)
+           <<", max "<<1e6*p.get_max_time(name)
+           <<", avg "<<1e6*p.get_average_time(name)<<std::endl;
+  std::cout<<"  iterations (iterations: cycles):";
+  int count = 0, p99 = -1;
+  for(std::map<int,int>::const_iterator it=iterations.begin(); it!=iterations.end(); it++)
+  {
+    std::cout<<" "<<it->first<<": "<<it->second;
+    count += it->second;
+    if(p99<0 && count>=0.99*N)
+      p99 = it->first;
+  }
+  std::cout<<std::endl<<"  iterations p99 "<<p99<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  const int N = argc>1 ? atoi(argv[1]) : 10000;
+  const bool changeHessian = argc>2 && atoi(argv[2])!=0;
+
+  Problem problem;
+  SolverHQPBase * solver = SolverHQPFactory::createNewSolver(SOLVER_HQP_EIQUADPROG_FAST, "eiquadprog-fast");
+  solver->resize(N_VAR, N_EQ, N_IN);
+  QpWarmStart warmStart;
+  warmStart.resize(N_VAR, N_EQ, N_IN);
+
+  std::map<int,int> itCold, itWarm;
+  int failures = 0, hits = 0;
+  double maxError = 0.0;
+  Stopwatch& p = getProfiler();
+  for(int i=0; i<N; i++)
+  {
+    problem.update(i, changeHessian);
+
+    p.start("cold");
+    const HQPOutput & solCold = solver->solve(problem.data);
+    p.stop("cold");
+    if(solCold.status!=HQP_STATUS_OPTIMAL)
+    {
+      failures++;
+      continue;
+    }
+    itCold[solCold.iterations]++;
+    const Eigen::VectorXd xCold = solCold.x;
+
+    p.start("warm start");
+    const HQPOutput * sol = NULL;
+    if(warmStart.solve(problem.data))
+    {
+      sol = &warmStart.getOutput();
+      hits++;
+    }
+    else
+    {
+      sol = &solver->solve(problem.data);
+      if(sol->status==HQP_STATUS_OPTIMAL)
+        warmStart.store(problem.data, *sol);
+      else
+        warmStart.reset();
+    }
+    p.stop("warm start");
+    itWarm[sol->iterations]++;
+    maxError = std::max(maxError, (sol->x-xCold).cwiseAbs().maxCoeff());
+  }
+
+  std::cout<<N<<" cycles, "<<failures<<" failures of the cold solver, "<<hits
+           <<" warm start hits, max difference of the solutions "<<maxError<<std::endl;
+  printResults("cold", itCold, N);
+  printResults("warm start", itWarm, N);
+  delete solver;
+  const bool ok = failures==0 && maxError<SOLUTION_TOLERANCE;
+  std::cout<<(ok ? "OK" : "ERROR: the cold solver failed or the solutions with the warm start are different")<<std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Micro-benchmark of the conversions between the SoT and the URDF orders
+ *  of the joints done by RobotUtil, on a 30-joint robot whose orders differ
+ *  (HRP-2) and on a 32-joint robot whose orders are the same (Talos).
+ *  Usage: benchmark_robot_util [number of iterations]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <sot/torque_control/common.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+/// Scalar gather, as done by RobotUtil before the joint segments
+static void gather_sot_to_urdf(const std::vector<Index>& urdf_to_sot,
+                               Eigen::ConstRefVector q_sot, Eigen::RefVector q_urdf)
+{
+  for(std::size_t idx=0; idx<urdf_to_sot.size(); idx++)
+    q_urdf[idx] = q_sot[urdf_to_sot[idx]];
+}
+
+static bool benchmark(const std::string& robotName, const std::vector<Index>& urdf_to_sot, int N)
+{
+  std::string name(robotName);
+  RobotUtil* ru = createRobotUtil(name);
+  ru->set_urdf_to_sot(urdf_to_sot);
+  const Index nj = (Index) urdf_to_sot.size();
+  std::cout<<robotName<<": "<<nj<<" joints, "<<ru->m_urdf_to_sot_segments.size()
+           <<" segments, identity "<<ru->m_urdf_to_sot_identity<<std::endl;
+
+  Eigen::VectorXd q_sot = Eigen::VectorXd::Random(nj+6);
+  Eigen::VectorXd v_sot = Eigen::VectorXd::Random(nj+6);
+  Eigen::VectorXd a_sot = Eigen::VectorXd::Random(nj+6);
+  Eigen::VectorXd q_urdf(nj+7), v_urdf(nj+6), a_urdf(nj+6), q_ref(nj), q_back(nj);
+  Eigen::VectorXd q_urdf2(nj+7), v_urdf2(nj+6), v_urdf3(nj), a_urdf3(nj);
+
+  // check the results against the scalar gather and the separate conversions
+  Eigen::VectorXd qj = q_sot.tail(nj);
+  gather_sot_to_urdf(urdf_to_sot, qj, q_ref);
+  ru->joints_sot_to_urdf(qj, q_urdf.tail(nj));
+  ru->joints_urdf_to_sot(q_urdf.tail(nj), q_back);
+  bool ok = q_urdf.tail(nj)==q_ref && q_back==qj;
+  ru->config_sot_to_urdf(q_sot, q_urdf);
+  ru->velocity_sot_to_urdf(q_urdf, v_sot, v_urdf);
+  ru->config_velocity_sot_to_urdf(q_sot, v_sot, q_urdf2, v_urdf2);
+  ok = ok && q_urdf==q_urdf2 && v_urdf==v_urdf2;
+  ru->joints_sot_to_urdf(q_sot.tail(nj), v_sot.tail(nj), a_sot.tail(nj), q_back, v_urdf3, a_urdf3);
+  ok = ok && q_back==q_ref;
+  if(!ok)
+    std::cout<<"ERROR: conversions of "<<robotName<<" do not match"<<std::endl;
+
+  Stopwatch& p = getProfiler();
+  p.start("scalar gather");
+  for(int i=0; i<N; i++)
+    gather_sot_to_urdf(urdf_to_sot, qj, q_ref);
+  p.stop("scalar gather");
+
+  p.start("joints_sot_to_urdf");
+  for(int i=0; i<N; i++)
+    ru->joints_sot_to_urdf(qj, q_ref);
+  p.stop("joints_sot_to_urdf");
+
+  p.start("joints_sot_to_urdf x3");
+  for(int i=0; i<N; i++)
+  {
+    ru->joints_sot_to_urdf(q_sot.tail(nj), q_back);
+    ru->joints_sot_to_urdf(v_sot.tail(nj), v_urdf3);
+    ru->joints_sot_to_urdf(a_sot.tail(nj), a_urdf3);
+  }
+  p.stop("joints_sot_to_urdf x3");
+
+  p.start("joints_sot_to_urdf fused x3");
+  for(int i=0; i<N; i++)
+    ru->joints_sot_to_urdf(q_sot.tail(nj), v_sot.tail(nj), a_sot.tail(nj), q_back, v_urdf3, a_urdf3);
+  p.stop("joints_sot_to_urdf fused x3");
+
+  p.start("config + velocity_sot_to_urdf");
+  for(int i=0; i<N; i++)
+  {
+    ru->config_sot_to_urdf(q_sot, q_urdf);
+    ru->velocity_sot_to_urdf(q_urdf, v_sot, v_urdf);
+  }
+  p.stop("config + velocity_sot_to_urdf");
+
+  p.start("config_velocity_sot_to_urdf");
+  for(int i=0; i<N; i++)
+    ru->config_velocity_sot_to_urdf(q_sot, v_sot, q_urdf, v_urdf);
+  p.stop("config_velocity_sot_to_urdf");
+
+  std::cout<<"Average time of "<<N<<" calls (us):"<<std::endl;
+  const char* perfs[] = {"scalar gather", "joints_sot_to_urdf", "joints_sot_to_urdf x3",
+                         "joints_sot_to_urdf fused x3", "config + velocity_sot_to_urdf",
+                         "config_velocity_sot_to_urdf"};
+  for(int i=0; i<6; i++)
+  {
+    std::cout<<"  "<<perfs[i]<<": "<<1e6*p.get_total_time(perfs[i])/N<<std::endl;
+    p.reset(perfs[i]);
+  }
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  const int N = argc>1 ? atoi(argv[1]) : 1000000;
+
+  // HRP-2: legs, chest, head and arms are ordered differently in the URDF
+  const Index hrp2[] = {12,13,14,15,23,24,25,26,27,28,29,16,17,18,19,20,
+                        21,22,6,7,8,9,10,11,0,1,2,3,4,5};
+  std::vector<Index> urdf_to_sot_hrp2(hrp2, hrp2+30);
+
+  // Talos: the URDF and the SoT orders are the same
+  std::vector<Index> urdf_to_sot_talos(32);
+  for(Index i=0; i<32; i++)
+    urdf_to_sot_talos[i] = i;
+
+  bool ok = benchmark("hrp2", urdf_to_sot_hrp2, N);
+  ok = benchmark("talos", urdf_to_sot_talos, N) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Micro-benchmark of the Stopwatch: cost of a start/stop pair using the
+ *  StopwatchId (the path used in the control loop) and using the name of the
+ *  performance (the slow compatibility path), with a few performances
+ *  registered so that the name lookup is realistic.
+ *  Usage: benchmark_stop_watch [number of start/stop pairs]
+ */
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <sot/torque_control/utils/stop-watch.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define NB_PERFORMANCES 40
+
+int main(int argc, char** argv)
+{
+  const int N = argc>1 ? atoi(argv[1]) : 1000000;
+
+  Stopwatch watch(REAL_TIME);
+  for(int i=0; i<NB_PERFORMANCES; i++)
+  {
+    std::stringstream ss;
+    ss<<"InverseDynamicsBalanceController: section "<<i;
+    watch.get_id(ss.str());
+  }
+  const std::string name = "InverseDynamicsBalanceController: section 20";
+  const StopwatchId id = watch.get_id(name);
+
+  // warm up the caches and the clock
+  for(int i=0; i<N/10; i++)
+  {
+    watch.start(id);
+    watch.stop(id);
+  }
+
+  int64_t t0 = watch.take_time_ns();
+  for(int i=0; i<N; i++)
+  {
+    watch.start(id);
+    watch.stop(id);
+  }
+  const double nsId = double(watch.take_time_ns()-t0)/N;
+
+  t0 = watch.take_time_ns();
+  for(int i=0; i<N; i++)
+  {
+    watch.start(name);
+    watch.stop(name);
+  }
+  const double nsName = double(watch.take_time_ns()-t0)/N;
+
+  t0 = watch.take_time_ns();
+  for(int i=0; i<N; i++)
+    watch.take_time_ns();
+  const double nsClock = double(watch.take_time_ns()-t0)/N;
+
+  std::cout<<N<<" start/stop pairs, "<<NB_PERFORMANCES<<" performances registered"<<std::endl;
+  std::cout<<"start/stop by id:   "<<nsId<<" ns per pair"<<std::endl;
+  std::cout<<"start/stop by name: "<<nsName<<" ns per pair"<<std::endl;
+  std::cout<<"clock reading:      "<<nsClock<<" ns"<<std::endl;
+  return 0;
+}
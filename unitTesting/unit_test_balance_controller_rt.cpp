@@ -0,0 +1,236 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Check that the real-time mode of InverseDynamicsBalanceController does not
+ *  allocate memory after the first tick: malloc and operator new are replaced
+ *  by versions counting the allocations of the main thread, and the test fails
+ *  if any tick allocates, including the ticks switching the contacts, and
+ *  the ticks of the transitions of the contacts removed with a transition
+ *  time, which must end in single support before the contact is added back.
+ *  Usage: unit_test_balance_controller_rt <urdf file of simple_humanoid>
+ *  Fails if the URDF file cannot be found (CMake passes the one of simple_humanoid_description).
+ */
+
+#include <iostream>
+#include <fstream>
+#include <new>
+#include <cstdlib>
+#include <cerrno>
+#include "balance_controller_test_utils.hh"
+
+using namespace dynamicgraph::sot::torque_control;
+
+/* --- ALLOCATION COUNTING ---------------------------------------------- */
+
+/// Only the allocations of the thread running the controller are counted
+/// (the logger prints the messages in a background thread).
+static __thread bool countAllocations = false;
+static long allocations = 0;
+
+extern "C"
+{
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t n, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+  void  __libc_free(void* ptr);
+
+  void* malloc(size_t size)
+  {
+    if(countAllocations)
+      allocations++;
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t n, size_t size)
+  {
+    if(countAllocations)
+      allocations++;
+    return __libc_calloc(n, size);
+  }
+
+  void* realloc(void* ptr, size_t size)
+  {
+    if(countAllocations)
+      allocations++;
+    return __libc_realloc(ptr, size);
+  }
+
+  void* memalign(size_t alignment, size_t size)
+  {
+    if(countAllocations)
+      allocations++;
+    return __libc_memalign(alignment, size);
+  }
+
+  int posix_memalign(void** ptr, size_t alignment, size_t size)
+  {
+    if(countAllocations)
+      allocations++;
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr==NULL ? ENOMEM : 0;
+  }
+
+  void free(void* ptr)
+  {
+    __libc_free(ptr);
+  }
+}
+
+void* operator new(std::size_t size)
+{
+  void* p = malloc(size);
+  if(p==NULL)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+  return malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+  return malloc(size);
+}
+
+void operator delete(void* p) throw()   { free(p); }
+void operator delete[](void* p) throw() { free(p); }
+void operator delete(void* p, const std::nothrow_t&) throw()   { free(p); }
+void operator delete[](void* p, const std::nothrow_t&) throw() { free(p); }
+
+/* --- TEST -------------------------------------------------------------- */
+
+#define ROBOT_NAME "rt-test-robot"
+#define NB_WARM_UP_TICKS 100
+#define NB_TICKS_PER_PHASE 100
+#define TRANSITION_TIME 0.05
+
+/// Balance controller giving access to its contact phase
+class TestController : public InverseDynamicsBalanceController
+{
+public:
+  TestController(const std::string & name)
+    : InverseDynamicsBalanceController(name)
+  {}
+
+  bool isInPhase(const bool rightRemoved, const bool transition, const bool doubleSupport) const
+  {
+    if(doubleSupport)
+      return m_contactPhase==PHASE_DOUBLE_SUPPORT;
+    if(rightRemoved)
+      return m_contactPhase==(transition ? PHASE_LEFT_SUPPORT_TRANSITION : PHASE_LEFT_SUPPORT);
+    return m_contactPhase==(transition ? PHASE_RIGHT_SUPPORT_TRANSITION : PHASE_RIGHT_SUPPORT);
+  }
+};
+
+/** Compute tau_des at the specified ticks, counting the allocations.
+ *  @return The number of allocations. */
+static long runTicks(InverseDynamicsBalanceController & ctrl, int & iter, const int nbTicks)
+{
+  const long before = allocations;
+  for(int i=0; i<nbTicks; i++, iter++)
+  {
+    countAllocations = true;
+    ctrl.m_tau_desSOUT.recompute(iter);
+    ctrl.m_latencySOUT.recompute(iter);
+    ctrl.m_fallback_levelSOUT.recompute(iter);
+    countAllocations = false;
+  }
+  return allocations-before;
+}
+
+int main(int argc, char** argv)
+{
+  const std::string urdf = getTestUrdf(argc, argv);
+  if(urdf.empty())
+    return 1;
+
+  initRobotUtil(ROBOT_NAME, urdf);
+  TestController ctrl("ctrl-rt-test");
+  initBalanceController(ctrl, 1e-3, ROBOT_NAME);
+  ctrl.setRealTimeMode(true);
+
+  // warm-up: the first ticks can allocate memory
+  int iter = 1;
+  for(; iter<=NB_WARM_UP_TICKS; iter++)
+  {
+    ctrl.m_tau_desSOUT.recompute(iter);
+    ctrl.m_latencySOUT.recompute(iter);
+    ctrl.m_fallback_levelSOUT.recompute(iter);
+  }
+
+  dynamicgraph::Vector f_ref = ctrl.m_f_ref_right_footSIN.accessCopy();
+  const dynamicgraph::Vector f_zero = dynamicgraph::Vector::Zero(6);
+  bool ok = true;
+  for(int warmStart=0; warmStart<2; warmStart++)
+  {
+    ctrl.setWarmStart(warmStart==1);
+    // double support, right support, double support, left support, double support
+    const char* phases[] = {"double support", "right support", "double support",
+                            "left support", "double support"};
+    for(int p=0; p<5; p++)
+    {
+      ctrl.m_f_ref_left_footSIN.setConstant(p==1 ? f_zero : f_ref);
+      ctrl.m_f_ref_right_footSIN.setConstant(p==3 ? f_zero : f_ref);
+      const long n = runTicks(ctrl, iter, NB_TICKS_PER_PHASE);
+      std::cout<<phases[p]<<(warmStart ? " (warm start)" : "")<<": "<<n<<" allocations"<<std::endl;
+      ok = ok && n==0;
+    }
+  }
+
+  // contact removed by the command with a transition time (both contacts kept
+  // until its end), then added back by the command
+  for(int side=0; side<2; side++)
+  {
+    const bool right = side==0;
+    const char* foot = right ? "right" : "left";
+    dynamicgraph::SignalPtr<dynamicgraph::Vector, int> & f_ref_foot =
+        right ? ctrl.m_f_ref_right_footSIN : ctrl.m_f_ref_left_footSIN;
+    if(right)
+      ctrl.removeRightFootContact(TRANSITION_TIME);
+    else
+      ctrl.removeLeftFootContact(TRANSITION_TIME);
+    f_ref_foot.setConstant(f_zero);
+    bool phasesOk = ctrl.isInPhase(right, true, false);
+    long n = runTicks(ctrl, iter, (int)(0.8*TRANSITION_TIME/1e-3));
+    phasesOk = phasesOk && ctrl.isInPhase(right, true, false);
+    n += runTicks(ctrl, iter, (int)(0.4*TRANSITION_TIME/1e-3));
+    phasesOk = phasesOk && ctrl.isInPhase(right, false, false);
+
+    if(right)
+      ctrl.addRightFootContact(TRANSITION_TIME);
+    else
+      ctrl.addLeftFootContact(TRANSITION_TIME);
+    f_ref_foot.setConstant(f_ref);
+    phasesOk = phasesOk && ctrl.isInPhase(right, false, true);
+    n += runTicks(ctrl, iter, NB_TICKS_PER_PHASE);
+    phasesOk = phasesOk && ctrl.isInPhase(right, false, true);
+
+    std::cout<<"remove and add "<<foot<<" foot contact with transition: "<<n<<" allocations"
+             <<(phasesOk ? "" : ", ERROR: wrong contact phases")<<std::endl;
+    ok = ok && n==0 && phasesOk;
+  }
+
+  std::cout<<(ok ? "OK" : "ERROR: the real-time ticks allocated memory or switched the wrong contacts")<<std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2015, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Check that BatchTrajectoryGenerator generates bit for bit the same
+ *  trajectories as one size-1 generator per channel, used the way
+ *  JointTrajectoryGenerator used them: the trajectories start from the
+ *  position of a NoTrajectoryGenerator, which takes over the channel at the
+ *  end of the trajectory or when the channel is stopped. Each channel goes
+ *  through all the profiles, so that channels of different profiles are
+ *  interleaved and restarted from where the previous profile left them.
+ */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <sot/torque_control/utils/trajectory-generators.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define N_CHANNELS 6
+#define N_PHASES 7
+#define N_STEPS_PER_PHASE 3000
+#define DT 1e-3
+
+/** One channel driven by the old size-1 generators. */
+struct ScalarChannel
+{
+  MinimumJerkTrajectoryGenerator          minJerk;
+  SinusoidTrajectoryGenerator             sinusoid;
+  TriangleTrajectoryGenerator             triangle;
+  ConstantAccelerationTrajectoryGenerator constAcc;
+  LinearChirpTrajectoryGenerator          linChirp;
+  NoTrajectoryGenerator                   noTraj;
+  AbstractTrajectoryGenerator*            current;
+
+  ScalarChannel(double x):
+    minJerk(DT,5.0,1), sinusoid(DT,5.0,1), triangle(DT,5.0,1),
+    constAcc(DT,5.0,1), linChirp(DT,5.0,1), noTraj(1), current(&noTraj)
+  {
+    noTraj.set_initial_point(x);
+  }
+
+  void stop()
+  {
+    noTraj.set_initial_point(current->getPos());
+    current = &noTraj;
+  }
+
+  void compute_next_point()
+  {
+    current->compute_next_point();
+    if(current->isTrajectoryEnded())
+      stop();
+  }
+};
+
+/** Start on channel i of both generators the profile (i+phase)%N_PROFILES,
+ *  with parameters depending on i and phase. */
+static bool start(ScalarChannel& s, BatchTrajectoryGenerator& b, int i, int phase)
+{
+  const double x_final = 0.3*(i+1) - 0.17*phase;
+  const double T = 0.5 + 0.13*i + 0.07*phase;
+  const double Tacc = 0.2*T;
+  const double f0 = 0.5 + 0.1*i, f1 = 2.0 + 0.3*phase;
+  const double x_init = s.noTraj.getPos()(0);
+  bool ok = true;
+  switch((i+phase)%BatchTrajectoryGenerator::N_PROFILES)
+  {
+  case BatchTrajectoryGenerator::PROFILE_NONE:
+    break;
+  case BatchTrajectoryGenerator::PROFILE_MIN_JERK:
+    s.minJerk.set_initial_point(x_init);
+    s.minJerk.set_final_point(x_final);
+    s.minJerk.set_trajectory_time(T);
+    s.current = &s.minJerk;
+    ok = b.start_min_jerk(i, x_final, T);
+    break;
+  case BatchTrajectoryGenerator::PROFILE_SINUSOID:
+    s.sinusoid.set_initial_point(x_init);
+    s.sinusoid.set_final_point(x_final);
+    s.sinusoid.set_trajectory_time(T);
+    s.current = &s.sinusoid;
+    ok = b.start_sinusoid(i, x_final, T);
+    break;
+  case BatchTrajectoryGenerator::PROFILE_TRIANGLE:
+    s.triangle.set_initial_point(x_init);
+    s.triangle.set_final_point(x_final);
+    s.triangle.set_trajectory_time(T);
+    s.triangle.set_acceleration_time(Tacc);
+    s.current = &s.triangle;
+    ok = b.start_triangle(i, x_final, T, Tacc);
+    break;
+  case BatchTrajectoryGenerator::PROFILE_CONST_ACC:
+    s.constAcc.set_initial_point(x_init);
+    s.constAcc.set_final_point(x_final);
+    s.constAcc.set_trajectory_time(T);
+    s.current = &s.constAcc;
+    ok = b.start_const_acc(i, x_final, T);
+    break;
+  case BatchTrajectoryGenerator::PROFILE_LIN_CHIRP:
+    s.linChirp.set_initial_point(x_init);
+    s.linChirp.set_final_point(x_final);
+    s.linChirp.set_trajectory_time(T);
+    s.linChirp.set_initial_frequency(f0);
+    s.linChirp.set_final_frequency(f1);
+    s.current = &s.linChirp;
+    ok = b.start_linear_chirp(i, x_final, f0, f1, T);
+    break;
+  }
+  if(!ok)
+    std::cout<<"ERROR: cannot start channel "<<i<<" in phase "<<phase<<std::endl;
+  return ok;
+}
+
+int main()
+{
+  BatchTrajectoryGenerator batch(DT, N_CHANNELS);
+  std::vector<ScalarChannel*> scalar(N_CHANNELS);
+  for(int i=0; i<N_CHANNELS; i++)
+  {
+    scalar[i] = new ScalarChannel(0.1*i);
+    batch.stop(i, 0.1*i);
+  }
+
+  bool ok = true;
+  for(int phase=0; ok && phase<N_PHASES; phase++)
+  {
+    // stop the endless trajectories of the previous phase, then start the new ones
+    for(int i=0; i<N_CHANNELS; i++)
+    {
+      scalar[i]->stop();
+      batch.stop(i, batch.getPos()(i));
+      ok = ok && start(*scalar[i], batch, i, phase);
+    }
+
+    for(int k=0; ok && k<N_STEPS_PER_PHASE; k++)
+    {
+      batch.compute_next_point();
+      for(int i=0; i<N_CHANNELS; i++)
+      {
+        const bool was_moving = scalar[i]->current!=&scalar[i]->noTraj;
+        scalar[i]->compute_next_point();
+        const bool is_moving = scalar[i]->current!=&scalar[i]->noTraj;
+        const std::vector<BatchTrajectoryGenerator::Index>& ended = batch.get_ended();
+        const bool batch_ended = std::find(ended.begin(), ended.end(), i)!=ended.end();
+        if(batch.getPos()(i)!=scalar[i]->current->getPos()(0) ||
+           batch.getVel()(i)!=scalar[i]->current->getVel()(0) ||
+           batch.getAcc()(i)!=scalar[i]->current->getAcc()(0))
+        {
+          std::cout<<"ERROR: different point on channel "<<i<<" at step "<<k
+                   <<" of phase "<<phase<<std::endl;
+          ok = false;
+          break;
+        }
+        if(batch_ended!=(was_moving && !is_moving) ||
+           (batch.get_profile(i)!=BatchTrajectoryGenerator::PROFILE_NONE)!=is_moving)
+        {
+          std::cout<<"ERROR: channel "<<i<<" did not end with the scalar generator at step "
+                   <<k<<" of phase "<<phase<<std::endl;
+          ok = false;
+          break;
+        }
+      }
+    }
+  }
+
+  for(int i=0; i<N_CHANNELS; i++)
+    delete scalar[i];
+  std::cout<<(ok ? "OK" : "ERROR")<<std::endl;
+  return ok ? 0 : 1;
+}
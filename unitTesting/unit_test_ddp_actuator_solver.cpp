@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018, Olivier Stasse LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Initialize DdpActuatorSolver twice with several joints, solved on the
+ *  pool of threads, and solve the same problem after each init: the
+ *  commands must be the same at each time step and after each init.
+ */
+
+#include <iostream>
+#include <sot/torque_control/ddp-actuator-solver.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define NB_JOINTS 6
+#define NB_TICKS 20
+
+/// Solve NB_TICKS time steps from iter and check that tau is always ref
+/// (set to the first solution if empty)
+static bool solve(DdpActuatorSolver& ddp, int iter, dynamicgraph::Vector& ref)
+{
+  for(int i=0; i<NB_TICKS; i++)
+  {
+    const dynamicgraph::Vector& tau = ddp.m_tauSOUT(iter+i);
+    if(ref.size()==0)
+      ref = tau;
+    if(tau!=ref)
+    {
+      std::cout<<"ERROR: tau at time step "<<iter+i<<" is "<<tau.transpose()
+               <<" instead of "<<ref.transpose()<<"\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+int main()
+{
+  DdpActuatorSolver ddp("ddp-test");
+  for(int k=0; k<NB_JOINTS; k++)
+    ddp.add_joint(k, 50, 10, 1e-5);
+
+  dynamicgraph::Vector pos_des(NB_JOINTS), zero(NB_JOINTS), temp(NB_JOINTS);
+  for(int k=0; k<NB_JOINTS; k++)
+    pos_des(k) = 0.1*(k+1);
+  zero.setZero();
+  temp.setConstant(30.0);
+  ddp.m_pos_desSIN.setConstant(pos_des);
+  ddp.m_pos_motor_measureSIN.setConstant(zero);
+  ddp.m_pos_joint_measureSIN.setConstant(zero);
+  ddp.m_dx_measureSIN.setConstant(zero);
+  ddp.m_tau_measureSIN.setConstant(zero);
+  ddp.m_temp_measureSIN.setConstant(temp);
+
+  dynamicgraph::Vector ref;
+  ddp.param_init(1e-3, 50, 10, 1e-5);
+  if(!solve(ddp, 0, ref))
+    return 1;
+  // the second init restarts the pool of threads
+  ddp.param_init(1e-3, 50, 10, 1e-5);
+  if(!solve(ddp, NB_TICKS, ref))
+    return 1;
+
+  std::cout<<"Same commands of the "<<NB_JOINTS<<" joints after the two inits: "
+           <<ref.transpose()<<"\n";
+  return 0;
+}
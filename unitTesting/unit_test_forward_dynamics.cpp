@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Compare the two solvers of the constrained forward dynamics of
+ *  DeviceTorqueCtrl (SVD and Cholesky) on random problems with two 6d
+ *  contacts and 18, 36 and 44 degrees of freedom: the accelerations and the
+ *  contact forces must match, and the average time of each solver is printed.
+ *  Usage: unit_test_forward_dynamics [number of solutions per solver]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <sot/torque_control/device-torque-ctrl.hh>
+#include <sot/torque_control/utils/stop-watch.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define NB_CONTACT_FORCES 12
+/// Maximum difference of the solutions, relative to their norm
+#define TOLERANCE 1e-6
+
+/// Device giving access to the solvers of the forward dynamics without a
+/// robot model: the problem data are set directly
+class TestDevice : public DeviceTorqueCtrl
+{
+public:
+  TestDevice(const std::string& name, int nv)
+    : DeviceTorqueCtrl(name)
+  {
+    m_nj = nv-6;
+    m_Jc = Eigen::MatrixXd::Random(NB_CONTACT_FORCES, nv);
+    m_dJcv = Eigen::VectorXd::Random(NB_CONTACT_FORCES);
+    m_tau_np6.setZero(nv);
+    m_tau_np6.tail(m_nj).setRandom();
+    m_dvBar.setZero(nv);
+    m_f.setZero(NB_CONTACT_FORCES);
+    m_Minv_JcT.setZero(nv, NB_CONTACT_FORCES);
+    m_JMinvJcT.setZero(NB_CONTACT_FORCES, NB_CONTACT_FORCES);
+
+    // well-conditioned symmetric positive-definite mass matrix
+    const Eigen::MatrixXd A = Eigen::MatrixXd::Random(nv, nv);
+    M = A*A.transpose() + nv*Eigen::MatrixXd::Identity(nv, nv);
+    h = Eigen::VectorXd::Random(nv);
+  }
+
+  void solveSvd()      { computeForwardDynamicsSvd(M, h); }
+  void solveCholesky() { computeForwardDynamicsCholesky(M, h); }
+  const Eigen::VectorXd& dv() const { return m_dv; }
+  const Eigen::VectorXd& f()  const { return m_f; }
+  double constraintError() const { return (m_Jc*m_dv-m_dJcv).norm(); }
+
+  Eigen::MatrixXd M;
+  Eigen::VectorXd h;
+};
+
+static bool check(int nv, int N)
+{
+  TestDevice device("fd-test-device-"+toString(nv), nv);
+
+  device.solveSvd();
+  const Eigen::VectorXd dv_svd = device.dv(), f_svd = device.f();
+  const double err_svd = device.constraintError();
+  device.solveCholesky();
+  const Eigen::VectorXd dv_chol = device.dv(), f_chol = device.f();
+  const double err_chol = device.constraintError();
+
+  const double e_dv = (dv_svd-dv_chol).norm()/dv_svd.norm();
+  const double e_f  = (f_svd-f_chol).norm()/f_svd.norm();
+  const bool ok = e_dv<TOLERANCE && e_f<TOLERANCE &&
+                  err_svd<TOLERANCE && err_chol<TOLERANCE;
+
+  Stopwatch& p = getProfiler();
+  const std::string svd = "svd "+toString(nv), chol = "cholesky "+toString(nv);
+  p.start(svd);
+  for(int i=0; i<N; i++)
+    device.solveSvd();
+  p.stop(svd);
+  p.start(chol);
+  for(int i=0; i<N; i++)
+    device.solveCholesky();
+  p.stop(chol);
+
+  const double t_svd = 1e6*p.get_total_time(svd)/N, t_chol = 1e6*p.get_total_time(chol)/N;
+  std::cout<<nv<<" DoF: relative difference dv "<<e_dv<<", f "<<e_f
+           <<", constraint error svd "<<err_svd<<", cholesky "<<err_chol
+           <<"; time (us) svd "<<t_svd<<", cholesky "<<t_chol
+           <<", speed-up "<<t_svd/t_chol<<(ok ? "" : "  ERROR")<<std::endl;
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  const int N = argc>1 ? atoi(argv[1]) : 1000;
+  srand(0);
+  bool ok = check(18, N);
+  ok = check(36, N) && ok;
+  ok = check(44, N) && ok;
+  std::cout<<(ok ? "OK" : "ERROR: the forward dynamics solvers do not match")<<std::endl;
+  return ok ? 0 : 1;
+}
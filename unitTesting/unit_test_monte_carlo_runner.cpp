@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Smoke test of MonteCarloRunner: three simulations of a DeviceTorqueCtrl
+ *  controlled by an InverseDynamicsBalanceController run on three threads,
+ *  two controllers in non real-time mode and one in real-time mode. The
+ *  real-time mode must not forbid the allocations of the other threads
+ *  (the check of Eigen is process-wide, MonteCarloRunner disables it during
+ *  the run and enables it again at the end). All the simulations must
+ *  complete, and the statistics of the controllers must be stored in the
+ *  statistics of the threads, not in the ones of the process.
+ *  Run it with a thread sanitizer to check that the simulations do not share
+ *  any data.
+ *  Usage: unit_test_monte_carlo_runner <urdf file of simple_humanoid>
+ *  Fails if the URDF file cannot be found (CMake passes the one of simple_humanoid_description).
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sot/torque_control/device-torque-ctrl.hh>
+#include <sot/torque_control/monte-carlo-runner.hh>
+#include <sot/torque_control/utils/statistics.hh>
+#include <sot/torque_control/utils/malloc-guard.hh>
+#include "balance_controller_test_utils.hh"
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define NB_SIMULATIONS 3
+#define NB_TIME_STEPS 200
+#define DT 1e-3
+
+typedef dynamicgraph::SignalPtr<dynamicgraph::Vector, int> VectorSignalIn;
+
+/// Set an input signal of an entity that is not accessible from outside
+static void setInput(dynamicgraph::Entity & entity, const std::string & signalName,
+                     const dynamicgraph::Vector & value)
+{
+  dynamic_cast<VectorSignalIn&>(entity.getSignal(signalName)).setConstant(value);
+}
+
+/// Graph of a simulation: the device and its balance controller
+struct Simulation
+{
+  DeviceTorqueCtrl device;
+  InverseDynamicsBalanceController ctrl;
+
+  Simulation(const std::string & name, const std::string & urdf)
+    : device("device-"+name)
+    , ctrl("ctrl-"+name)
+  {
+    const std::string robotName = "robot-"+name;
+    const int nj = 29;
+    initRobotUtil(robotName, urdf);
+
+    setInput(device, "kp_constraints", dynamicgraph::Vector::Constant(6, 1.0));
+    setInput(device, "kd_constraints", dynamicgraph::Vector::Constant(6, 1.0));
+    setInput(device, "rotor_inertias", dynamicgraph::Vector::Zero(nj));
+    setInput(device, "gear_ratios", dynamicgraph::Vector::Ones(nj));
+    device.init(DT, robotName);
+    dynamicgraph::Vector q = dynamicgraph::Vector::Zero(nj+6);
+    q(2) = 0.6;
+    device.setState(q);
+
+    initBalanceController(ctrl, DT, robotName);
+    ctrl.m_qSIN.plug(&device.getSignal("robotState"));
+    device.controlSIN.plug(&ctrl.m_tau_desSOUT);
+  }
+};
+
+int main(int argc, char** argv)
+{
+  const std::string urdf = getTestUrdf(argc, argv);
+  if(urdf.empty())
+    return 1;
+
+  Simulation simA("mc-test-a", urdf);
+  Simulation simB("mc-test-b", urdf);
+  Simulation simRt("mc-test-rt", urdf);
+  simRt.ctrl.setRealTimeMode(true);
+  MonteCarloRunner runner("mc-test-runner");
+  runner.addSimulation(simA.device.getName());
+  runner.addSimulation(simB.device.getName());
+  runner.addSimulation(simRt.device.getName());
+  runner.run(DT, NB_TIME_STEPS, NB_SIMULATIONS);
+
+  const dynamicgraph::Vector & steps = runner.m_completed_stepsSOUT.accessCopy();
+  bool ok = steps.size()==NB_SIMULATIONS;
+  for(int i=0; i<steps.size(); i++)
+  {
+    std::cout<<"Simulation "<<i<<": "<<steps(i)<<" time steps completed"<<std::endl;
+    ok = ok && steps(i)==NB_TIME_STEPS;
+  }
+  if(::getStatistics().quantity_exists("active inequalities"))
+  {
+    std::cout<<"ERROR: the simulations stored their statistics in the statistics of the process"<<std::endl;
+    ok = false;
+  }
+  if(!isMallocGuardEnabled())
+  {
+    std::cout<<"ERROR: the allocation check of Eigen is still disabled after the run"<<std::endl;
+    ok = false;
+  }
+
+  std::cout<<(ok ? "OK" : "ERROR")<<std::endl;
+  return ok ? 0 : 1;
+}
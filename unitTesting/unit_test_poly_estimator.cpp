@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Check the sliding sums of LinEstimator and QuadEstimator against the batch
+ *  fit of the window (the product with the pseudo-inverse of the time matrix)
+ *  on a long noisy signal with a large offset: the estimates and their
+ *  derivatives must stay close for the whole run, i.e. the rounding errors
+ *  of the sliding sums must not accumulate.
+ *  Usage: unit_test_poly_estimator [number of samples]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <sot/torque_control/utils/lin-estimator.hh>
+#include <sot/torque_control/utils/quad-estimator.hh>
+
+#define DIM 6
+#define DT 1e-3
+/// Maximum error relative to the scale of each derivative
+#define TOLERANCE 1e-10
+
+template<typename Estimator>
+static bool check(const std::string& name, const unsigned int order,
+                  const unsigned int N, const long nbSamples)
+{
+  Estimator batch(N, DIM, DT);
+  Estimator sliding(N, DIM, DT);
+  sliding.setSlidingSums(true);
+
+  Eigen::VectorXd x(DIM), e_batch(DIM), e_sliding(DIM);
+  Eigen::VectorXd d_batch(DIM), d_sliding(DIM);
+  std::vector<double> maxError(order+1, 0.0);
+  srand(0);
+  for(long i=0; i<nbSamples; i++)
+  {
+    const double t = i*DT;
+    for(int j=0; j<DIM; j++)
+      x(j) = 1e3*(j+1) + std::sin((j+1)*t) + 1e-3*rand()/RAND_MAX;
+    batch.estimate(e_batch, x);
+    sliding.estimate(e_sliding, x);
+    if(i+1<N)
+      continue;
+    for(unsigned int k=0; k<=order; k++)
+    {
+      batch.getEstimateDerivative(d_batch, k);
+      sliding.getEstimateDerivative(d_sliding, k);
+      // the error of the k-th derivative scales as the data over dt^k
+      const double scale = 1e3*DIM*std::pow(DT*N, -(double)k);
+      maxError[k] = std::max(maxError[k], (d_batch-d_sliding).cwiseAbs().maxCoeff()/scale);
+    }
+  }
+
+  bool ok = true;
+  std::cout<<name<<", window "<<N<<", "<<nbSamples<<" samples, relative errors:";
+  for(unsigned int k=0; k<=order; k++)
+  {
+    std::cout<<" "<<maxError[k];
+    ok = ok && maxError[k]<TOLERANCE;
+  }
+  std::cout<<(ok ? "" : "  ERROR")<<std::endl;
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  const long nbSamples = argc>1 ? atol(argv[1]) : 10000000;
+  const unsigned int windows[] = {5, 21, 60, 200, 401, 1001};
+  bool ok = true;
+  for(int w=0; w<6; w++)
+  {
+    ok = check<LinEstimator>("LinEstimator", 1, windows[w], nbSamples) && ok;
+    ok = check<QuadEstimator>("QuadEstimator", 2, windows[w], nbSamples) && ok;
+  }
+  std::cout<<(ok ? "OK" : "ERROR: the sliding sums drift from the batch fit")<<std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Check the conversions between the SoT and the URDF orders of the joints
+ *  done by RobotUtil against the gather of the joints one by one with
+ *  m_urdf_to_sot, for orders converted by copying joint segments (identity,
+ *  long runs) and orders converted joint by joint (HRP-2, reversed, shuffled).
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <sot/torque_control/common.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+/// Index-based conversions of the joints
+static Eigen::VectorXd urdf_to_sot(const std::vector<Index>& urdf_to_sot, const Eigen::VectorXd& q_urdf)
+{
+  Eigen::VectorXd q_sot(q_urdf.size());
+  for(std::size_t idx=0; idx<urdf_to_sot.size(); idx++)
+    q_sot[urdf_to_sot[idx]] = q_urdf[idx];
+  return q_sot;
+}
+
+static Eigen::VectorXd sot_to_urdf(const std::vector<Index>& urdf_to_sot, const Eigen::VectorXd& q_sot)
+{
+  Eigen::VectorXd q_urdf(q_sot.size());
+  for(std::size_t idx=0; idx<urdf_to_sot.size(); idx++)
+    q_urdf[idx] = q_sot[urdf_to_sot[idx]];
+  return q_urdf;
+}
+
+static bool check(const std::string& robotName, const std::vector<Index>& order)
+{
+  std::string name(robotName);
+  RobotUtil* ru = createRobotUtil(name);
+  ru->set_urdf_to_sot(order);
+  const Index nj = (Index) order.size();
+  std::cout<<robotName<<": "<<nj<<" joints, "<<ru->m_urdf_to_sot_segments.size()
+           <<" segments, copied by segment "<<ru->m_urdf_to_sot_use_segments<<std::endl;
+
+  const Eigen::VectorXd qj_urdf = Eigen::VectorXd::Random(nj);
+  const Eigen::VectorXd qj_sot = Eigen::VectorXd::Random(nj);
+  const Eigen::VectorXd vj_sot = Eigen::VectorXd::Random(nj);
+  const Eigen::VectorXd aj_sot = Eigen::VectorXd::Random(nj);
+  const Eigen::VectorXd qj_ref = sot_to_urdf(order, qj_sot);
+  const Eigen::VectorXd vj_ref = sot_to_urdf(order, vj_sot);
+  const Eigen::VectorXd aj_ref = sot_to_urdf(order, aj_sot);
+  bool ok = true;
+
+  Eigen::VectorXd q(nj), v(nj), a(nj);
+  ru->joints_urdf_to_sot(qj_urdf, q);
+  ok = ok && q==urdf_to_sot(order, qj_urdf);
+  ru->joints_sot_to_urdf(qj_sot, q);
+  ok = ok && q==qj_ref;
+  ru->joints_sot_to_urdf(qj_sot, vj_sot, aj_sot, q, v, a);
+  ok = ok && q==qj_ref && v==vj_ref && a==aj_ref;
+
+  // conversions of the free-flyer configurations and velocities
+  Eigen::VectorXd q_sot(nj+6), v_sot(nj+6), q_urdf(nj+7), v_urdf(nj+6), q_urdf2(nj+7), v_urdf2(nj+6);
+  q_sot << Eigen::VectorXd::Random(6), qj_sot;
+  v_sot << Eigen::VectorXd::Random(6), vj_sot;
+  ru->config_sot_to_urdf(q_sot, q_urdf);
+  ru->velocity_sot_to_urdf(q_urdf, v_sot, v_urdf);
+  ok = ok && q_urdf.tail(nj)==qj_ref && v_urdf.tail(nj)==vj_ref;
+  ru->config_velocity_sot_to_urdf(q_sot, v_sot, q_urdf2, v_urdf2);
+  ok = ok && q_urdf2==q_urdf && v_urdf2==v_urdf;
+  Eigen::VectorXd q_sot2(nj+6), v_sot2(nj+6);
+  ru->config_urdf_to_sot(q_urdf, q_sot2);
+  ru->velocity_urdf_to_sot(q_urdf, v_urdf, v_sot2);
+  ok = ok && q_sot2.tail(nj)==qj_sot && v_sot2.tail(nj)==vj_sot;
+
+  if(!ok)
+    std::cout<<"ERROR: the conversions of "<<robotName<<" do not match the index-based ones"<<std::endl;
+  return ok;
+}
+
+int main()
+{
+  // HRP-2: legs, chest, head and arms are ordered differently in the URDF
+  const Index hrp2[] = {12,13,14,15,23,24,25,26,27,28,29,16,17,18,19,20,
+                        21,22,6,7,8,9,10,11,0,1,2,3,4,5};
+  const std::vector<Index> order_hrp2(hrp2, hrp2+30);
+
+  std::vector<Index> order_identity(32), order_reversed(32), order_runs(32);
+  for(Index i=0; i<32; i++)
+  {
+    order_identity[i] = i;
+    order_reversed[i] = 31-i;
+    order_runs[i] = (i+16)%32;  // two runs of 16 joints swapped
+  }
+  std::vector<Index> order_shuffled(order_identity);
+  std::random_shuffle(order_shuffled.begin(), order_shuffled.end());
+
+  bool ok = check("robot-util-test-hrp2", order_hrp2);
+  ok = check("robot-util-test-identity", order_identity) && ok;
+  ok = check("robot-util-test-reversed", order_reversed) && ok;
+  ok = check("robot-util-test-runs", order_runs) && ok;
+  ok = check("robot-util-test-shuffled", order_shuffled) && ok;
+  std::cout<<(ok ? "OK" : "ERROR")<<std::endl;
+  return ok ? 0 : 1;
+}
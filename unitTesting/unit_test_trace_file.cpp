@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Check the trace files read by TracePlayer: the parser of the text traces
+ *  of the Tracer (separators, blank lines, missing final newline, time column
+ *  discarded, malformed rows), the round-trip through the binary trace format
+ *  and the conversion of a text trace to a binary trace.
+ *  The files are written in the current directory.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sot/torque_control/utils/trace-file.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define TEXT_FILE   "unit_test_trace_file.dat"
+#define BINARY_FILE "unit_test_trace_file.bin"
+
+static void writeText(const std::string& content)
+{
+  std::ofstream f(TEXT_FILE);
+  f << content;
+}
+
+static bool fail(const std::string& msg)
+{
+  std::cout<<"ERROR: "<<msg<<std::endl;
+  return false;
+}
+
+/// The text trace of the expected records, with tabs, spaces, a blank line
+/// and no newline at the end of the file
+static bool checkTextParser(const Eigen::MatrixXd& expected)
+{
+  writeText("0\t1.5 -2\t3e-3\n"
+            "\n"
+            "0.001  4.25\t5  -6.125e2\n"
+            "0.002\t7\t8\t9");
+  TraceFile trace;
+  std::string error;
+  if(!trace.open(TEXT_FILE, error))
+    return fail("cannot read the text trace: "+error);
+  if(trace.isMapped() || trace.rows()!=expected.cols() || trace.cols()!=expected.rows())
+    return fail("wrong size of the text trace");
+  for(Eigen::VectorXd::Index i=0; i<trace.rows(); i++)
+    if(trace.row(i)!=expected.col(i))
+      return fail("wrong record of the text trace");
+
+  // a row with a missing value must be rejected
+  writeText("0 1 2 3\n0.001 4 5\n");
+  TraceFile bad;
+  if(bad.open(TEXT_FILE, error))
+    return fail("a text trace with a missing value has been read");
+
+  // rows read one by one, time column included
+  writeText("0 1 2\n1 3 4\n");
+  TextMatrixFileReader reader;
+  Eigen::VectorXd row(3);
+  if(!reader.open(TEXT_FILE, error) || reader.rows()!=2 || reader.cols()!=3)
+    return fail("wrong size of the text matrix");
+  if(!reader.readRow(row) || row!=Eigen::Vector3d(0, 1, 2) ||
+     !reader.readRow(row) || row!=Eigen::Vector3d(1, 3, 4) || reader.readRow(row))
+    return fail("wrong rows of the text matrix");
+  reader.rewind();
+  if(!reader.readRow(row) || row!=Eigen::Vector3d(0, 1, 2))
+    return fail("wrong row of the text matrix after rewind");
+  return true;
+}
+
+static bool checkBinaryRoundTrip(const Eigen::MatrixXd& records)
+{
+  std::string error;
+  if(!writeBinaryTrace(BINARY_FILE, records, error))
+    return fail("cannot write the binary trace: "+error);
+  TraceFile trace;
+  if(!trace.open(BINARY_FILE, error))
+    return fail("cannot read the binary trace: "+error);
+  if(!trace.isMapped() || trace.rows()!=records.cols() || trace.cols()!=records.rows())
+    return fail("wrong size of the binary trace");
+  for(Eigen::VectorXd::Index i=0; i<trace.rows(); i++)
+    if(trace.row(i)!=records.col(i))
+      return fail("wrong record of the binary trace");
+  return true;
+}
+
+static bool checkConversion(const Eigen::MatrixXd& records)
+{
+  // full precision, so that the binary trace is bit identical
+  {
+    std::ofstream f(TEXT_FILE);
+    f.precision(17);
+    for(Eigen::VectorXd::Index i=0; i<records.cols(); i++)
+      f << 1e-3*i << " " << records.col(i).transpose() << "\n";
+  }
+  std::string error;
+  if(!convertTextTraceToBinary(TEXT_FILE, BINARY_FILE, error))
+    return fail("cannot convert the text trace: "+error);
+  TraceFile text, binary;
+  if(!text.open(TEXT_FILE, error) || !binary.open(BINARY_FILE, error))
+    return fail("cannot read the converted traces: "+error);
+  if(!binary.isMapped() || binary.rows()!=text.rows() || binary.cols()!=text.cols() ||
+     binary.rows()!=records.cols())
+    return fail("wrong size of the converted trace");
+  for(Eigen::VectorXd::Index i=0; i<binary.rows(); i++)
+    if(binary.row(i)!=records.col(i) || text.row(i)!=records.col(i))
+      return fail("wrong record of the converted trace");
+  return true;
+}
+
+int main()
+{
+  Eigen::MatrixXd expected(3, 3);
+  expected << 1.5, 4.25, 7,
+              -2,  5,    8,
+              3e-3, -6.125e2, 9;
+  const Eigen::MatrixXd records = Eigen::MatrixXd::Random(7, 1000);
+
+  bool ok = checkTextParser(expected);
+  ok = checkBinaryRoundTrip(records) && ok;
+  ok = checkConversion(records) && ok;
+  std::remove(TEXT_FILE);
+  std::remove(BINARY_FILE);
+  std::cout<<(ok ? "OK" : "ERROR")<<std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2015, Andrea Del Prete, LAAS-CNRS
+ *
+ * This file is part of sot-torque-control.
+ * sot-torque-control is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ * sot-torque-control is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.  You should
+ * have received a copy of the GNU Lesser General Public License along
+ * with sot-torque-control.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Check that TextFileTrajectoryGenerator plays exactly the rows of its text
+ *  file, when the trajectory is much longer than the window of parsed rows
+ *  and the points are computed as fast as possible (the thread parsing the
+ *  rows must not be overtaken), and when the trajectory is loaded again.
+ *  The file is written in the current directory.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sot/torque_control/utils/trajectory-generators.hh>
+
+using namespace dynamicgraph::sot::torque_control;
+
+#define TRAJ_FILE "unit_test_trajectory_generators.dat"
+#define SIZE 3
+#define NB_ROWS 5000
+#define WINDOW_SIZE 16
+#define DT 1e-3
+
+static bool play(TextFileTrajectoryGenerator& gen, const Eigen::MatrixXd& traj)
+{
+  if(!gen.loadTextFile(TRAJ_FILE))
+  {
+    std::cout<<"ERROR: cannot load the trajectory file"<<std::endl;
+    return false;
+  }
+  if(gen.get_initial_point()!=traj.row(0).head(SIZE).transpose())
+  {
+    std::cout<<"ERROR: wrong initial point"<<std::endl;
+    return false;
+  }
+  for(int i=0; i<NB_ROWS; i++)
+  {
+    if(gen.isTrajectoryEnded())
+    {
+      std::cout<<"ERROR: the trajectory ended at row "<<i<<std::endl;
+      return false;
+    }
+    gen.compute_next_point();
+    if(gen.getPos()!=traj.row(i).head(SIZE).transpose() ||
+       gen.getVel()!=traj.row(i).segment(SIZE, SIZE).transpose() ||
+       gen.getAcc()!=traj.row(i).tail(SIZE).transpose())
+    {
+      std::cout<<"ERROR: wrong point at row "<<i<<std::endl;
+      return false;
+    }
+  }
+  if(!gen.isTrajectoryEnded())
+  {
+    std::cout<<"ERROR: the trajectory did not end after its last row"<<std::endl;
+    return false;
+  }
+  // the last point is kept after the end
+  gen.compute_next_point();
+  return gen.getPos()==traj.row(NB_ROWS-1).head(SIZE).transpose();
+}
+
+int main()
+{
+  // integers, so that the text file holds the exact values
+  Eigen::MatrixXd traj(NB_ROWS, 3*SIZE);
+  for(int i=0; i<NB_ROWS; i++)
+    for(int j=0; j<3*SIZE; j++)
+      traj(i, j) = 100*i+j;
+  {
+    std::ofstream f(TRAJ_FILE);
+    for(int i=0; i<NB_ROWS; i++)
+      f << traj.row(i) << "\n";
+  }
+
+  TextFileTrajectoryGenerator gen(DT, SIZE, WINDOW_SIZE);
+  bool ok = play(gen, traj);
+  // load it again, after having played it and while it is being played
+  ok = ok && play(gen, traj);
+  for(int i=0; i<NB_ROWS/2; i++)
+    gen.compute_next_point();
+  ok = ok && play(gen, traj);
+
+  std::remove(TRAJ_FILE);
+  std::cout<<(ok ? "OK" : "ERROR")<<std::endl;
+  return ok ? 0 : 1;
+}